@@ -0,0 +1,39 @@
+#version 450
+
+// wiender dynamic resolution upscale, see include/wiender_dynamic_resolution.hpp
+
+layout(constant_id = 0) const bool sharpen = false;
+
+layout(set = 3, binding = 0) uniform sampler2D scene;
+layout(std140, set = 3, binding = 1) uniform upscale_params {
+    vec2 uvScale;       // render extent / target extent
+    vec2 texelSize;     // 1 / target extent
+    float sharpness;    // 0 to 1
+} params;
+
+layout(location = 0) in vec2 fragUv;
+
+layout(location = 0) out vec4 fragColor;
+
+vec3 fetch(vec2 uv) {
+    // texels outside of the render extent are stale, bilinear taps must not reach them
+    return texture(scene, clamp(uv, params.texelSize * 0.5, params.uvScale - params.texelSize * 0.5)).rgb;
+}
+
+void main() {
+    vec2 uv = fragUv * params.uvScale;
+    vec3 color = fetch(uv);
+    if (sharpen) {
+        // contrast-adaptive sharpening over the cross of neighbour texels
+        vec3 north = fetch(uv - vec2(0.0, params.texelSize.y));
+        vec3 south = fetch(uv + vec2(0.0, params.texelSize.y));
+        vec3 west = fetch(uv - vec2(params.texelSize.x, 0.0));
+        vec3 east = fetch(uv + vec2(params.texelSize.x, 0.0));
+        vec3 minColor = min(color, min(min(north, south), min(west, east)));
+        vec3 maxColor = max(color, max(max(north, south), max(west, east)));
+        // less sharpening where local contrast is already high, so edges don't ring
+        vec3 amount = sqrt(clamp(min(minColor, 1.0 - maxColor) / max(maxColor, 1e-4), 0.0, 1.0)) * -mix(0.125, 0.2, params.sharpness);
+        color = clamp((color + (north + south + west + east) * amount) / (1.0 + 4.0 * amount), 0.0, 1.0);
+    }
+    fragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 450
+
+// wiender fullscreen triangle of the dynamic resolution upscale, see include/wiender_dynamic_resolution.hpp
+
+layout(location = 0) out vec2 fragUv;
+
+void main() {
+    fragUv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(fragUv * 2.0 - 1.0, 0.0, 1.0);
+}
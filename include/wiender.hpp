@@ -1,6 +1,8 @@
 #ifndef WIENDER_HPP_
 #define WIENDER_HPP_ 1
 
+#include "wiender_core.hpp"
+
 #ifdef _WIN32
 #include "wiender_windows.hpp"
 #elif defined(__linux__)
@@ -34,6 +36,21 @@ namespace wiender {
      * @return A unique pointer to the created wienderer instance.
      */ 
     std::unique_ptr<wienderer> create_wienderer(backend_type backendType, const window_handle& whandle);
+    /**
+     * @brief Creates a wienderer without a window, e.g. for batch rendering or benchmarks on machines without a display.
+     * Frames are rendered into a small ring of offscreen RGBA8 images of the given size, `execute` submits the frame
+     * and never waits for presentation, so the frame rate is bound by the GPU (or a software implementation) only.
+     * 
+     * @throw std::exeption If the creation of the wienderer instance fails or the size is zero.
+     */
+    std::unique_ptr<wienderer> create_headless_wienderer(backend_type backendType, uint32_t width, uint32_t height);
+    /**
+     * @brief Creates a context to open several windows on one device, see `context`.
+     * Nothing is created until the first renderer, its window picks the device.
+     * 
+     * @throw std::exeption If the backend type is unknown.
+     */
+    std::shared_ptr<context> create_context(backend_type backendType);
 } // namespace wiender
 
 #endif
\ No newline at end of file
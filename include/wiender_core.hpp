@@ -2,6 +2,8 @@
 #define WIENDER_CORE_HPP_ 1
 #include <exception>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -27,8 +29,13 @@ namespace wiender {
             SSO,
             CPU_SIDE_VERTEX,
             GPU_SIDE_VERTEX,
-            CPU_SIDE_INDEX,
-            GPU_SIDE_INDEX,
+            CPU_SIDE_INDEX,     // 32-bit indices
+            GPU_SIDE_INDEX,     // 32-bit indices
+            CPU_SIDE_INDEX16,   // 16-bit indices, half the memory and bandwidth for meshes under 65536 vertices
+            GPU_SIDE_INDEX16,   // 16-bit indices
+            CPU_SIDE_STORAGE,   // host-visible, writes through `map` are seen by the GPU directly
+            GPU_SIDE_STORAGE,   // device-local, filled from a staging copy by `update_data`
+            INDIRECT,           // device-local draw parameters and counts, filled by `update_data` or written by shaders as a storage buffer
         };
 
         public:
@@ -42,6 +49,25 @@ namespace wiender {
         virtual void update_data() = 0;
 
     };
+    /**
+     * @brief Layout of a single draw in `buffer::type::INDIRECT` buffers, see `wienderer::draw_indirect`.
+     */
+    struct draw_indirect_command {
+        uint32_t vertexCount;
+        uint32_t instanceCount;
+        uint32_t firstVertex;
+        uint32_t firstInstance;
+    };
+    /**
+     * @brief Layout of a single draw in `buffer::type::INDIRECT` buffers, see `wienderer::draw_indexed_indirect`.
+     */
+    struct draw_indexed_indirect_command {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
 
     // segment: Textures
 
@@ -82,11 +108,19 @@ namespace wiender {
             }
         };
 
+        public:
+        static constexpr uint32_t invalidBindlessIndex = ~0u;
+
         public:
         virtual ~texture() {}
 
         public:
         WIENDER_NODISCARD virtual extent get_extent() const noexcept = 0;
+        /**
+         * @brief Index of the texture in the device-wide texture table, stable for the texture lifetime.
+         * @return `invalidBindlessIndex` if `wienderer::feature::BINDLESS_TEXTURES` is not supported.
+         */
+        WIENDER_NODISCARD virtual uint32_t get_bindless_index() const noexcept = 0;
         WIENDER_NODISCARD virtual bool is_mapped() const noexcept = 0;
         WIENDER_NODISCARD virtual void* map() = 0;
         virtual void unmap() = 0;
@@ -95,6 +129,131 @@ namespace wiender {
 
     };
 
+    // segment: Render targets
+    /**
+     * @brief Offscreen color image drawn between `wienderer::begin_render(target)` and `end_render`, sampled like any texture.
+     *
+     * Outside of render passes the image stays shader-readable, layout transitions are part of the render passes.
+     * Shaders without `clearScreen` keep its content, so a cached layer (e.g. a static background) can be rendered
+     * once and composited every frame. Shaders drawing into it have to be created for its format and sample count,
+     * see `shader::create_info::target`. A target cannot be sampled by the render pass drawing into it.
+     */
+    struct render_target : public texture {
+        public:
+        enum struct format {
+            SWAPCHAIN,      // same as window images
+            RGBA8_UNORM,
+            RGBA16_SFLOAT,  // HDR
+        };
+        struct description {
+            public:
+            format targetFormat;
+            uint32_t samples;   // 1 for a single-sampled target, 0 for the window, rounded down to a supported count
+
+            public:
+            description() : targetFormat(format::SWAPCHAIN), samples(0) {}
+            description(format targetFormat, uint32_t samples) : targetFormat(targetFormat), samples(samples) {}
+        };
+
+        public:
+        virtual ~render_target() {}
+
+        public:
+        WIENDER_NODISCARD virtual description get_description() const noexcept = 0;
+        /**
+         * @brief Limits render passes recorded after the call to the top-left part of the target, e.g. for dynamic resolution.
+         *
+         * Sample the part with texture coordinates scaled by render extent / target extent. Zero width or height is the whole target.
+         */
+        virtual void set_render_extent(const extent& renderExtent) = 0;
+        WIENDER_NODISCARD virtual extent get_render_extent() const noexcept = 0;
+    };
+
+    // segment: Post-processing
+    /**
+     * @brief Window render pass of a scene subpass followed by fullscreen post subpasses.
+     *
+     * Every post subpass reads the color written by the previous subpass at its own pixel as an input attachment,
+     * `layout(input_attachment_index = 0, set = 3, binding = n) uniform subpassInput`, the last one writes the window.
+     * Intermediate results live only inside of the render pass, tiled GPUs keep them in tile memory instead of
+     * writing and reading full-screen images between effects. Effects sampling neighbouring pixels (blur, bloom)
+     * cannot be chained this way, draw them through a render target.
+     *
+     * Shaders of the chain are created with `shader::create_info::chain` and `subpass`. Recording: set a scene shader,
+     * `wienderer::begin_render_chain`, draw the scene, then for every post subpass `next_subpass`, set its shader and
+     * draw a fullscreen triangle, and `end_render`. The last subpass has to cover every window pixel.
+     * The scene subpass starts cleared, `clearScreen` and `clearDepth` of chain shaders are ignored.
+     */
+    struct postprocess_chain {
+        public:
+        struct description {
+            public:
+            render_target::format intermediateFormat;   // of the scene and intermediate results, e.g. RGBA16_SFLOAT before tone mapping
+            uint32_t postSubpassCount;                  // at least 1
+            bool depth;                                 // the scene subpass has a depth attachment, its shaders have to test depth
+
+            public:
+            description() : intermediateFormat(render_target::format::SWAPCHAIN), postSubpassCount(1), depth(false) {}
+            description(render_target::format intermediateFormat, uint32_t postSubpassCount, bool depth = false)
+                :   intermediateFormat(intermediateFormat),
+                    postSubpassCount(postSubpassCount),
+                    depth(depth) {}
+        };
+
+        public:
+        virtual ~postprocess_chain() {}
+
+        public:
+        WIENDER_NODISCARD virtual description get_description() const noexcept = 0;
+    };
+
+    // segment: Readback
+    /**
+     * @brief Texel rectangle of `wienderer::request_readback`.
+     */
+    struct readback_region {
+        public:
+        uint32_t x;
+        uint32_t y;
+        uint32_t width;     // 0 up to the right edge
+        uint32_t height;    // 0 up to the bottom edge
+
+        public:
+        readback_region() : x(0), y(0), width(0), height(0) {}
+        readback_region(uint32_t x, uint32_t y, uint32_t width, uint32_t height) : x(x), y(y), width(width), height(height) {}
+    };
+    /**
+     * @brief Copy from the GPU queued by `wienderer::request_readback`.
+     *
+     * The copy runs behind frames executed before the request, so frame N can be read back while frames N+1 and N+2
+     * are rendered. Data is read in place from persistently mapped memory and stays valid until the ticket is destroyed.
+     * Live tickets hold readback memory, destroy them once data is consumed.
+     */
+    struct readback_ticket {
+        public:
+        virtual ~readback_ticket() {}
+
+        public:
+        /**
+         * @brief Polls the copy, never blocks.
+         */
+        WIENDER_NODISCARD virtual bool is_ready() const = 0;
+        /**
+         * @brief Blocks until the copy is finished.
+         */
+        virtual void wait() const = 0;
+        /**
+         * @brief Copied bytes. Texture rows are tightly packed texels of the texture format.
+         * @throw std::runtime_error If the copy is not finished yet.
+         */
+        WIENDER_NODISCARD virtual const void* get_data() const = 0;
+        WIENDER_NODISCARD virtual std::size_t get_size() const noexcept = 0;
+        /**
+         * @brief Bytes per texture row, the whole size for a buffer.
+         */
+        WIENDER_NODISCARD virtual std::size_t get_row_pitch() const noexcept = 0;
+    };
+
     // segment: Shaders
     struct shader {
         public:
@@ -107,17 +266,80 @@ namespace wiender {
 
         public:
         struct stage {
+            /**
+             * @brief Value for a `layout(constant_id = id)` declaration in the stage code.
+             *
+             * Every scalar specialization constant (bool, int, uint, float) is 4 bytes wide,
+             * so the value is stored as raw bits.
+             */
+            struct specialization_constant {
+                public:
+                uint32_t id;
+                uint32_t value;
+
+                public:
+                specialization_constant() : id(0), value(0) {}
+                specialization_constant(uint32_t id, uint32_t value) : id(id), value(value) {}
+                specialization_constant(uint32_t id, int32_t value) : id(id), value(static_cast<uint32_t>(value)) {}
+                specialization_constant(uint32_t id, bool value) : id(id), value(value ? 1u : 0u) {}
+                specialization_constant(uint32_t id, float value) : id(id), value(0) {
+                    std::memcpy(&this->value, &value, sizeof(value));
+                }
+            };
             enum struct kind {
                 VERTEX,
                 FRAGMENT,
                 COMPUTE,
             } stageKind;
             std::vector<uint32_t> data;
+            std::vector<specialization_constant> specializationConstants;
+            const uint32_t* externalData;       // used instead of `data` if not null, not owned
+            std::size_t externalDataCount;
+            uint64_t codeHash;                  // content hash of the code if known ahead (shader archive), 0 otherwise
+            public:
+            stage() : stageKind(kind::VERTEX), data(), specializationConstants(), externalData(nullptr), externalDataCount(0), codeHash(0) {}
+            stage(kind stageKind, const std::vector<uint32_t>& data) : stageKind(stageKind), data(data), specializationConstants(), externalData(nullptr), externalDataCount(0), codeHash(0) {}
+            stage(kind stageKind, const uint32_t* dataPtr, std::size_t dataCount) : stageKind(stageKind), data(dataPtr, dataPtr + dataCount), specializationConstants(), externalData(nullptr), externalDataCount(0), codeHash(0) {}
+            stage(kind stageKind, const std::vector<uint32_t>& data, const std::vector<specialization_constant>& specializationConstants)
+                :   stageKind(stageKind),
+                    data(data),
+                    specializationConstants(specializationConstants),
+                    externalData(nullptr),
+                    externalDataCount(0),
+                    codeHash(0) {}
+            stage(kind stageKind, const uint32_t* dataPtr, std::size_t dataCount, const std::vector<specialization_constant>& specializationConstants)
+                :   stageKind(stageKind),
+                    data(dataPtr, dataPtr + dataCount),
+                    specializationConstants(specializationConstants),
+                    externalData(nullptr),
+                    externalDataCount(0),
+                    codeHash(0) {}
+
+            /**
+             * @brief Creates a stage referencing SPIR-V without copying it.
+             *
+             * The memory has to outlive every shader created from the stage.
+             */
+            WIENDER_NODISCARD static stage from_memory(kind stageKind, const uint32_t* dataPtr, std::size_t dataCount, uint64_t codeHash = 0) {
+                stage result(stageKind, std::vector<uint32_t>());
+                result.externalData = dataPtr;
+                result.externalDataCount = dataCount;
+                result.codeHash = codeHash;
+                return result;
+            }
+
             public:
-            stage() : stageKind(kind::VERTEX), data() {}
-            stage(kind stageKind, const std::vector<uint32_t>& data) : stageKind(stageKind), data(data) {}
-            stage(kind stageKind, const uint32_t* dataPtr, std::size_t dataCount) : stageKind(stageKind), data(dataPtr, dataPtr + dataCount) {}
+            WIENDER_NODISCARD const uint32_t* code() const noexcept {
+                return externalData != nullptr ? externalData : data.data();
+            }
+            WIENDER_NODISCARD std::size_t code_size() const noexcept { // in bytes
+                return (externalData != nullptr ? externalDataCount : data.size()) * sizeof(uint32_t);
+            }
         };
+        /**
+         * @brief Vertex attribute of a shader. Normalized formats are read as float in [0, 1] (UNORM) or [-1, 1] (SNORM),
+         * integer formats have to be declared as uint/int (uvecN/ivecN) inputs in the shader.
+         */
         struct vertex_input_attribute {
             public:
             enum struct format {
@@ -125,6 +347,32 @@ namespace wiender {
                 FLOAT_VEC2,
                 FLOAT_VEC3,
                 FLOAT_VEC4,
+                HALF_SCALAR,        // 16-bit float
+                HALF_VEC2,
+                HALF_VEC4,
+                UNORM8_VEC2,
+                UNORM8_VEC4,        // e.g. RGBA color in 4 bytes
+                SNORM8_VEC2,
+                SNORM8_VEC4,
+                UNORM16_VEC2,       // e.g. texture coordinates in 4 bytes
+                UNORM16_VEC4,
+                SNORM16_VEC2,
+                SNORM16_VEC4,
+                UNORM_A2B10G10R10,  // packed in 4 bytes, x in the lowest bits, e.g. normals or HDR-less colors
+                UINT8_SCALAR,
+                UINT8_VEC2,
+                UINT8_VEC4,
+                UINT16_SCALAR,
+                UINT16_VEC2,
+                UINT16_VEC4,
+                UINT_SCALAR,        // 32-bit unsigned
+                UINT_VEC2,
+                UINT_VEC3,
+                UINT_VEC4,
+                INT_SCALAR,         // 32-bit signed
+                INT_VEC2,
+                INT_VEC3,
+                INT_VEC4,
             } inputFormat;
             uint32_t location;
             uint32_t binding;
@@ -141,6 +389,25 @@ namespace wiender {
                     offset(offset) {} 
 
         };
+        /**
+         * @brief Vertex buffer binding of a shader, binding 0 is set by `buffer::bind`, others by `wienderer::bind_instance_buffer`.
+         */
+        struct vertex_input_binding {
+            public:
+            enum struct input_rate {
+                PER_VERTEX,
+                PER_INSTANCE,
+            } inputRate;
+            uint32_t binding;
+            uint32_t stride;    // in bytes, 0 for the end of the last attribute of the binding, set it explicitly if the vertex struct has trailing padding
+
+            public:
+            vertex_input_binding() : inputRate(input_rate::PER_VERTEX), binding(0), stride(0) {}
+            vertex_input_binding(input_rate inputRate, uint32_t binding, uint32_t stride = 0)
+                :   inputRate(inputRate),
+                    binding(binding),
+                    stride(stride) {}
+        };
         enum struct primitive_topology {
             TRIANGLES_LIST,
             TRIANGLES_FAN,
@@ -158,14 +425,29 @@ namespace wiender {
             FRONT,
             ALL
         };
+        /**
+         * @brief Depth testing against the shared depth attachment, created on first use. Fragments pass
+         * if they are not farther than the stored depth, so opaque draws sorted front to back skip hidden fragments early.
+         */
+        enum struct depth_mode {
+            DISABLED,
+            TEST,           // for translucent draws over opaque ones
+            TEST_AND_WRITE,
+        };
         struct create_info {
             std::vector<stage> stages;
             std::vector<vertex_input_attribute> vertexInputAttributes;  // for graphics shaders only
+            std::vector<vertex_input_binding> vertexInputBindings;      // for graphics shaders only, empty for a single per-vertex binding 0
             primitive_topology topology;                                // for graphics shaders only
             polygon_mode polygonMode;                                   // for graphics shaders only
             cull_mode cullMode;                                         // for graphics shaders only
             bool clearScreen;                                           // for graphics shaders only
             bool alphaBlend;                                            // for graphics shaders only
+            depth_mode depthMode;                                       // for graphics shaders only
+            bool clearDepth;                                            // for graphics shaders with depth only, clears to the far plane at `begin_render`
+            render_target::description target;                         // for graphics shaders only, the window by default
+            const postprocess_chain* chain;                             // for graphics shaders only, nullptr outside of chains, has to outlive the shader
+            uint32_t subpass;                                           // of the chain, 0 for the scene subpass
 
             public:
             create_info()
@@ -173,7 +455,12 @@ namespace wiender {
                 polygonMode(polygon_mode::FILL),
                 cullMode(cull_mode::BACK),
                 clearScreen(false),
-                alphaBlend(false) {}
+                alphaBlend(false),
+                depthMode(depth_mode::DISABLED),
+                clearDepth(false),
+                target(),
+                chain(nullptr),
+                subpass(0) {}
 
             create_info(const std::vector<stage>& stages,
                         const std::vector<vertex_input_attribute>& vertexInputAttributes,
@@ -188,7 +475,12 @@ namespace wiender {
                     polygonMode(polygonMode),
                     cullMode(cullMode),
                     clearScreen(clearScreen),
-                    alphaBlend(alphaBlend) {}
+                    alphaBlend(alphaBlend),
+                    depthMode(depth_mode::DISABLED),
+                    clearDepth(false),
+                    target(),
+                    chain(nullptr),
+                    subpass(0) {}
 
             create_info(const std::vector<stage>& stages)
                 :   stages(stages),
@@ -196,16 +488,90 @@ namespace wiender {
                     polygonMode(polygon_mode::FILL),                // default
                     cullMode(cull_mode::BACK),                      // default
                     clearScreen(false),                                // default
-                    alphaBlend(false) {}                            // default
+                    alphaBlend(false),                              // default
+                    depthMode(depth_mode::DISABLED),                // default
+                    clearDepth(false),                              // default
+                    target(),                                       // default
+                    chain(nullptr),                                 // default
+                    subpass(0) {}                                   // default
         };
 
+        public:
+        /**
+         * @brief Conventional descriptor set numbers, from the least to the most frequently changed.
+         *
+         * Frame and pass sets are shared by every shader declaring them identically: data written through
+         * one shader is seen by all of them, and switching between such shaders doesn't rebind the set.
+         * Material and draw sets are owned by the shader. Set 4 is reserved, see `wienderer::feature::BINDLESS_TEXTURES`.
+         */
+        static constexpr std::size_t frameSet = 0;
+        static constexpr std::size_t passSet = 1;
+        static constexpr std::size_t materialSet = 2;
+        static constexpr std::size_t drawSet = 3;
+
         public:
         virtual ~shader() {}
 
         public:
         virtual void set() = 0;
-        WIENDER_NODISCARD virtual uniform_buffer_info get_uniform_buffer_info(std::size_t binding) = 0;
+        /**
+         * @brief Returns CPU memory of a uniform block, it stays valid for the shader lifetime.
+         *
+         * Writes are picked up by the next `wienderer::execute`, frames still in flight are not affected.
+         */
+        WIENDER_NODISCARD virtual uniform_buffer_info get_uniform_buffer_info(std::size_t set, std::size_t binding) = 0;
+        /**
+         * @brief Binds a texture to an element of a sampler array, same as `bind_textures` with a single texture.
+         */
+        virtual void bind_texture(std::size_t set, std::size_t binding, std::size_t arrayIndex, const texture* tetr) = 0;
+        /**
+         * @brief Binds `count` textures to elements [first, first + count) of a sampler array.
+         *
+         * Writes are collected and applied by the next `wienderer::execute` with one update per set,
+         * frames still in flight are not affected. Rebinding the same textures costs nothing on the GPU side.
+         */
+        virtual void bind_textures(std::size_t set, std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) = 0;
+        WIENDER_NODISCARD uniform_buffer_info get_uniform_buffer_info(std::size_t binding) {
+            return get_uniform_buffer_info(frameSet, binding);
+        }
+        void bind_texture(std::size_t binding, std::size_t arrayIndex, const texture* tetr) {
+            bind_texture(frameSet, binding, arrayIndex, tetr);
+        }
+        /**
+         * @brief Binds [offset, offset + range) of a storage buffer, zero range means up to the end of the buffer.
+         *
+         * The buffer has to be created with a `STORAGE` type and outlive its binding. Writes are applied like `bind_textures`.
+         * Devices without storage buffer update-after-bind only allow rebinding while no commands are recorded.
+         */
+        virtual void bind_buffer(std::size_t set, std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) = 0;
+        void bind_textures(std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) {
+            bind_textures(frameSet, binding, first, textures, count);
+        }
+        void bind_buffer(std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) {
+            bind_buffer(frameSet, binding, buff, offset, range);
+        }
+    };
+
+    // segment: Materials
+    /**
+     * @brief Own `shader::materialSet` resources of objects drawn with the same shader.
+     *
+     * A material holds only its descriptor set and uniform blocks, the pipeline stays in the shader,
+     * so switching materials of one shader rebinds only the material set. The shader has to outlive its materials.
+     */
+    struct material {
+        public:
+        virtual ~material() {}
+
+        public:
+        /**
+         * @brief Sets the shader of the material with the material set instead of the shader one.
+         */
+        virtual void set() = 0;
+        WIENDER_NODISCARD virtual shader::uniform_buffer_info get_uniform_buffer_info(std::size_t binding) = 0;
         virtual void bind_texture(std::size_t binding, std::size_t arrayIndex, const texture* tetr) = 0;
+        virtual void bind_textures(std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) = 0;
+        virtual void bind_buffer(std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) = 0;
     };
 
     // segment: Wenderer
@@ -221,6 +587,30 @@ namespace wiender {
     };
     // I HATE p******ism
     class wienderer {
+        public:
+        /**
+         * @brief Optional backend capabilities, everything works without them but slower.
+         */
+        enum struct feature {
+            FAST_PIPELINE_LINKING,  // shader fixed-function variants are linked from precompiled parts instead of a full compile
+            BINDLESS_TEXTURES,      // every texture is visible to shaders as `layout(set = 4, binding = 0) uniform sampler2D textures[]`
+            INDIRECT_DRAW_COUNT,    // `draw_indirect_count` and `draw_indexed_indirect_count` are available
+            GPU_TIMESTAMPS,         // `get_gpu_frame_time` measures frames
+        };
+        /**
+         * @brief Binds requested by recorded commands, issued to the backend or skipped as already bound.
+         */
+        struct bind_statistics {
+            struct counter {
+                std::size_t issued;
+                std::size_t skipped;
+            };
+            counter pipelines;
+            counter descriptorSets;
+            counter vertexBuffers;  // per binding
+            counter indexBuffers;
+        };
+
         public:
         virtual ~wienderer() {}
 
@@ -228,19 +618,166 @@ namespace wiender {
         WIENDER_NODISCARD virtual std::unique_ptr<buffer> create_buffer(buffer::type type, std::size_t byte) = 0;
         WIENDER_NODISCARD virtual std::unique_ptr<shader> create_shader(const shader::create_info& createInfo) = 0;
         WIENDER_NODISCARD virtual std::unique_ptr<texture> create_texture(const texture::create_info& createInfo) = 0;
-        WIENDER_NODISCARD virtual std::unique_ptr<texture> get_postproc_texture() = 0;
+        /**
+         * @brief Creates a material for a shader declaring `shader::materialSet`.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<material> create_material(const shader* shad) = 0;
+        /**
+         * @param samples 1 for a single-sampled target, multisampled ones are resolved at `end_render`.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<render_target> create_render_target(const texture::extent& targetExtent, render_target::format targetFormat, uint32_t samples) = 0;
+        /**
+         * @brief Creates a single-sampled render target of the window extent and format.
+         *
+         * Draw the scene into it, then sample it in a fullscreen pass into the window.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<render_target> get_postproc_texture() = 0;
+        /**
+         * @brief Creates a post-process chain of the window extent, see `postprocess_chain`.
+         * @throw std::exeption If there are no post subpasses or the intermediate format can't be an attachment.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<postprocess_chain> create_postprocess_chain(const postprocess_chain::description& chainDescription) = 0;
         WIENDER_NODISCARD virtual std::unique_ptr<wiender_commands_frame> get_commands_frame() const = 0;
         virtual void clear_commands_frame() = 0;
         virtual void set_commands_frame(const wiender_commands_frame* frame) = 0;
         virtual void concat_commands_frame(const wiender_commands_frame* frame) = 0;
         virtual void begin_record() = 0;
         virtual void begin_render() = 0;
+        /**
+         * @brief Starts the render pass of the current shader in a render target instead of the window.
+         *
+         * The target has to outlive recorded commands. Viewport and scissor cover its render extent, the whole target by default.
+         */
+        virtual void begin_render(render_target* target) = 0;
+        /**
+         * @brief Starts the render pass of a post-process chain in its scene subpass, the current shader has to be a scene shader of it.
+         *
+         * The chain has to outlive recorded commands. `end_render` has to follow the last subpass.
+         */
+        virtual void begin_render_chain(postprocess_chain* chain) = 0;
+        /**
+         * @brief Moves to the next subpass of the chain started by `begin_render_chain`, draws after it need a shader of that subpass.
+         */
+        virtual void next_subpass() = 0;
         virtual void draw_verteces(uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount) = 0;
-        virtual void draw_indexed(uint32_t indecesCount, uint32_t firstIndex, uint32_t instanceCount) = 0;
+        /**
+         * @brief Draws with the bound index buffer, index width is taken from its type.
+         * @param baseVertex Added to every index, so meshes can share a vertex buffer.
+         */
+        virtual void draw_indexed(uint32_t indecesCount, uint32_t firstIndex, uint32_t instanceCount, int32_t baseVertex) = 0;
+        /**
+         * @brief Binds a vertex buffer to an additional binding of the current shader, usually a per-instance one.
+         *
+         * Stays bound for the following draws until another buffer is bound to the binding.
+         */
+        virtual void bind_instance_buffer(const buffer* buff, uint32_t binding, std::size_t offset) = 0;
+        /**
+         * @brief Records `drawCount` draws with parameters read from an indirect buffer at execution time.
+         * @param buff Buffer of `buffer::type::INDIRECT` with `draw_indirect_command` entries.
+         * @param stride Distance between entries in bytes, 0 for tightly packed entries.
+         */
+        virtual void draw_indirect(const buffer* buff, std::size_t offset, uint32_t drawCount, uint32_t stride) = 0;
+        /**
+         * @brief Same as `draw_indirect` with `draw_indexed_indirect_command` entries.
+         */
+        virtual void draw_indexed_indirect(const buffer* buff, std::size_t offset, uint32_t drawCount, uint32_t stride) = 0;
+        /**
+         * @brief Same as `draw_indirect`, the draw count is a uint32_t read from `countBuff`, clamped to `maxDrawCount`.
+         *
+         * Requires `feature::INDIRECT_DRAW_COUNT`. Lets shaders produce draw lists without a CPU readback.
+         */
+        virtual void draw_indirect_count(const buffer* buff, std::size_t offset, const buffer* countBuff, std::size_t countOffset, uint32_t maxDrawCount, uint32_t stride) = 0;
+        virtual void draw_indexed_indirect_count(const buffer* buff, std::size_t offset, const buffer* countBuff, std::size_t countOffset, uint32_t maxDrawCount, uint32_t stride) = 0;
+        /**
+         * @brief Records a dispatch of the current compute shader, has to be called outside of `begin_render`/`end_render`.
+         *
+         * A compute shader is a shader created from a single `stage::kind::COMPUTE` stage.
+         * Reads by previous commands, earlier frames included, finish before it starts.
+         * Its writes are visible to every following command, indirect draw parameters included.
+         */
+        virtual void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) = 0;
+        /**
+         * @brief Records filling of a device-local buffer range with a repeated value, outside of `begin_render`/`end_render`.
+         *
+         * Usually resets counters written by compute shaders. Previous reads of the range are finished before the fill.
+         */
+        virtual void fill_buffer(const buffer* buff, std::size_t offset, std::size_t size, uint32_t value) = 0;
+        /**
+         * @brief Records push constants update for the following draws with the shader.
+         *
+         * Data is copied into the command, so it can be changed per draw without any synchronization.
+         * The range has to lie inside push constant blocks declared by the shader, at most 128 bytes.
+         */
+        virtual void push_constants(const shader* shad, uint32_t offset, const void* data, std::size_t size) = 0;
         virtual void end_render() = 0;
         virtual void end_record() = 0;
         virtual void execute() = 0;
         virtual void wait_executing() = 0;
+        /**
+         * @brief Queues a copy of a texture region into host memory behind the frames already executed, never waits.
+         *
+         * Works with textures and with render targets a render pass has been recorded into. Poll or wait the ticket before reading its data.
+         * @param tetr The texture, nullptr for the last executed frame of a headless wienderer.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<readback_ticket> request_readback(const texture* tetr, const readback_region& region) = 0;
+        /**
+         * @brief Same for a range of a device-local buffer, e.g. counters written by compute shaders.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<readback_ticket> request_readback(const buffer* buff, std::size_t offset, std::size_t size) = 0;
+
+        /**
+         * @brief Returns backend caches (shader reflection, compiled pipelines) as an opaque blob.
+         *
+         * Store it on disk and pass it to `load_cache_data` on the next run to skip repeated shader work.
+         */
+        WIENDER_NODISCARD virtual std::vector<char> get_cache_data() const = 0;
+        /**
+         * @brief Loads a blob produced by `get_cache_data`. Should be called before shaders are created.
+         *
+         * Data from another wiender version or another device is silently ignored.
+         */
+        virtual void load_cache_data(const void* data, std::size_t size) = 0;
+        WIENDER_NODISCARD virtual bool is_feature_supported(feature f) const noexcept = 0;
+        /**
+         * @brief Returns bind counters of the commands recorded since the last `begin_record`.
+         */
+        WIENDER_NODISCARD virtual bind_statistics get_bind_statistics() const noexcept = 0;
+        /**
+         * @brief GPU time between the begin and the end of recorded commands of the last finished frame, in milliseconds.
+         * Measuring starts when the window image is available, waiting for presentation isn't included.
+         * @return 0 until a frame is finished or without `feature::GPU_TIMESTAMPS`.
+         */
+        WIENDER_NODISCARD virtual double get_gpu_frame_time() const noexcept = 0;
+    };
+
+    // segment: Context
+    /**
+     * @brief A wienderer presenting into a window of a shared context.
+     */
+    using surface_renderer = wienderer;
+    /**
+     * @brief Device shared by several wienderers, e.g. one per window of an application.
+     *
+     * The first wienderer creates the instance, the device, the pipeline cache and the default texture,
+     * later ones only create their surface, swapchain and command buffers. Buffers, textures and render targets
+     * created by one wienderer can be used by the others while it is alive. Shaders and materials belong to
+     * their wienderer, but compiled pipelines and shader reflection are shared through the context caches.
+     *
+     * Wienderers keep the context alive. Only one of them can record at a time, they are not thread safe.
+     */
+    class context {
+        public:
+        virtual ~context() {}
+
+        public:
+        /**
+         * @throw std::exeption If the device of the context cannot present to the window.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<surface_renderer> create_surface_renderer(const window_handle& whandle) = 0;
+        /**
+         * @brief Same as `create_headless_wienderer`, but on the device of the context.
+         */
+        WIENDER_NODISCARD virtual std::unique_ptr<wienderer> create_headless_renderer(uint32_t width, uint32_t height) = 0;
     };
 
 } // namespace wiender
@@ -0,0 +1,98 @@
+#ifndef WIENDER_CULLING_HPP_
+#define WIENDER_CULLING_HPP_ 1
+
+#include "wiender_core.hpp"
+
+namespace wiender {
+    /**
+     * @brief GPU visibility culling of objects into an indirect draw buffer.
+     *
+     * Every object is a bounding sphere with its draw parameters. A compute shader (`assets/culling.comp`)
+     * tests spheres against the frustum and writes draws of the survivors, so recorded commands and CPU cost
+     * don't depend on the scene size. With `wienderer::feature::INDIRECT_DRAW_COUNT` survivors are compacted
+     * and counted, otherwise culled objects are drawn with 0 instances.
+     *
+     * Frame usage: `record_cull` before `begin_render`, then set the drawing shader, bind vertex and index buffers
+     * and call `record_draw` inside the render pass. Frustum and object count changes don't need re-recording.
+     */
+    class culling_pass {
+        public:
+        /**
+         * @brief Element of the objects buffer, std430 layout. Non-indexed draws use `indexCount` as vertex count
+         * and `firstIndex` as first vertex.
+         */
+        struct object {
+            float center[3];
+            float radius;
+            draw_indexed_indirect_command draw;
+            uint32_t reserved[3];
+        };
+        /**
+         * @brief Planes pointing inside, a point p is inside if dot(xyz, p) + w >= 0 for each plane.
+         */
+        struct frustum {
+            float planes[6][4];
+
+            /**
+             * @brief Extracts planes from a column-major view-projection matrix with vulkan clip space (z in [0, 1]).
+             */
+            WIENDER_NODISCARD static frustum from_view_projection(const float* viewProjection) noexcept;
+            /**
+             * @brief 2D culling against a world-space rectangle, z of objects is ignored.
+             */
+            WIENDER_NODISCARD static frustum from_view_rect(float minX, float minY, float maxX, float maxY) noexcept;
+        };
+
+        private:
+        wienderer* owner_;
+        std::unique_ptr<shader> shader_;
+        std::unique_ptr<buffer> objectsBuffer_;
+        std::unique_ptr<buffer> drawsBuffer_;
+        std::unique_ptr<buffer> countBuffer_;
+        uint32_t maxObjectCount_;
+        bool indexed_;
+        bool compact_;
+
+        public:
+        /**
+         * @param cullStage Compute stage compiled from `assets/culling.comp`.
+         * @param indexed Whether draws are written as `draw_indexed_indirect_command` or `draw_indirect_command`.
+         * @throw std::runtime_error If the shader or buffers can't be created.
+         */
+        culling_pass(wienderer* owner, const shader::stage& cullStage, uint32_t maxObjectCount, bool indexed);
+        culling_pass(const culling_pass&) = delete;
+        culling_pass& operator=(const culling_pass&) = delete;
+
+        public:
+        /**
+         * @brief Device-local storage buffer of `maxObjectCount` objects, filled by `map` and `update_data`.
+         */
+        WIENDER_NODISCARD buffer* get_objects_buffer() const noexcept {
+            return objectsBuffer_.get();
+        }
+        WIENDER_NODISCARD const buffer* get_draws_buffer() const noexcept {
+            return drawsBuffer_.get();
+        }
+        WIENDER_NODISCARD const buffer* get_count_buffer() const noexcept {
+            return countBuffer_.get();
+        }
+        WIENDER_NODISCARD uint32_t get_max_object_count() const noexcept {
+            return maxObjectCount_;
+        }
+        /**
+         * @brief Both are picked up by the next `wienderer::execute`.
+         */
+        void set_frustum(const frustum& f);
+        void set_object_count(uint32_t objectCount);
+        /**
+         * @brief Records the culling dispatch, has to be called outside of `begin_render`/`end_render`. Leaves the culling shader set.
+         */
+        void record_cull();
+        /**
+         * @brief Records indirect draws of the survivors with the current shader and buffers.
+         */
+        void record_draw();
+    };
+} // namespace wiender
+
+#endif // WIENDER_CULLING_HPP_
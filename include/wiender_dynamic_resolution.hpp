@@ -0,0 +1,96 @@
+#ifndef WIENDER_DYNAMIC_RESOLUTION_HPP_
+#define WIENDER_DYNAMIC_RESOLUTION_HPP_ 1
+
+#include "wiender_core.hpp"
+
+namespace wiender {
+    /**
+     * @brief Renders the scene at a lower resolution when the GPU can't keep up and upscales it into the window.
+     *
+     * The scene is drawn into a render target of the window size limited to `scale` of it by its render extent,
+     * `record_upscale` stretches that part over the window with a bilinear or a sharpening filter
+     * (`assets/upscale.vert`, `assets/upscale.frag`). `update` compares GPU frame time against the budget and moves the scale
+     * in steps within the bounds, so frame rate stays stable on weak GPUs and software rasterizers.
+     *
+     * Frame usage: draw the scene with shaders created for `get_target()->get_description()` between
+     * `begin_render(get_target())` and `end_render`, then call `record_upscale`. Call `update` after every `execute`,
+     * commands have to be re-recorded when it returns true. Without `wienderer::feature::GPU_TIMESTAMPS` the scale stays at `maxScale`.
+     */
+    class dynamic_resolution {
+        public:
+        enum struct filter {
+            BILINEAR,
+            SHARPEN,    // contrast-adaptive sharpening, restores some detail lost by upscaling
+        };
+        struct settings {
+            public:
+            float minScale;         // of the window extent per axis
+            float maxScale;
+            float scaleStep;        // scales are multiples of it, each change costs a re-recording
+            double frameTimeBudget; // GPU milliseconds per frame
+            filter upscaleFilter;
+            float sharpness;        // 0 to 1, `filter::SHARPEN` only, can be changed without re-recording
+
+            public:
+            settings() : minScale(0.5f), maxScale(1.0f), scaleStep(0.05f), frameTimeBudget(16.0), upscaleFilter(filter::BILINEAR), sharpness(0.5f) {}
+        };
+
+        private:
+        wienderer* owner_;
+        settings settings_;
+        texture::extent windowExtent_;
+        std::unique_ptr<render_target> target_;
+        std::unique_ptr<shader> upscaleShader_;
+        float scale_;
+        double averageFrameTime_;   // of frames rendered at the current scale, 0 until measured
+        uint32_t framesAtScale_;
+
+        public:
+        /**
+         * @param vertexStage Vertex stage compiled from `assets/upscale.vert`, `upscale_vert.spirv` in the shader archive.
+         * @param fragmentStage Fragment stage compiled from `assets/upscale.frag`, `upscale_frag.spirv` in the shader archive.
+         * @param windowExtent Extent of the window images, the target is created with it.
+         * @throw std::runtime_error If settings are out of range or the target or the shader can't be created.
+         */
+        dynamic_resolution(wienderer* owner, const shader::stage& vertexStage, const shader::stage& fragmentStage, const texture::extent& windowExtent, render_target::format targetFormat, const settings& s = settings());
+        dynamic_resolution(const dynamic_resolution&) = delete;
+        dynamic_resolution& operator=(const dynamic_resolution&) = delete;
+
+        public:
+        WIENDER_NODISCARD render_target* get_target() const noexcept {
+            return target_.get();
+        }
+        WIENDER_NODISCARD float get_scale() const noexcept {
+            return scale_;
+        }
+        WIENDER_NODISCARD const settings& get_settings() const noexcept {
+            return settings_;
+        }
+        /**
+         * @brief Sets the scale clamped to the bounds and quantized to the step, commands have to be re-recorded.
+         */
+        void set_scale(float scale);
+        /**
+         * @brief Picked up by the next `wienderer::execute`.
+         */
+        void set_sharpness(float sharpness);
+        /**
+         * @brief Records a window render pass drawing the upscaled target. Leaves the upscale shader set.
+         *
+         * Overlays drawn at the window resolution (e.g. UI) go into a following pass of shaders without `clearScreen`.
+         */
+        void record_upscale();
+        /**
+         * @brief Feeds the last GPU frame time to the controller.
+         * @return Whether the scale changed and commands have to be re-recorded.
+         */
+        bool update();
+
+        private:
+        WIENDER_NODISCARD float quantize_scale(float scale) const noexcept;
+        void apply_scale(float scale);
+        void write_params();
+    };
+} // namespace wiender
+
+#endif // WIENDER_DYNAMIC_RESOLUTION_HPP_
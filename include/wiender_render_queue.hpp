@@ -0,0 +1,128 @@
+#ifndef WIENDER_RENDER_QUEUE_HPP_
+#define WIENDER_RENDER_QUEUE_HPP_ 1
+
+#include "wiender_core.hpp"
+
+#include <unordered_map>
+
+namespace wiender {
+    /**
+     * @brief Collects draws of a frame and records them sorted by a 64-bit key with minimal state changes.
+     *
+     * Draws are submitted in any order as packets with a sort key. `record` radix-sorts them and sets
+     * shaders, materials and buffers only when they differ from the previous draw, so interleaved submissions
+     * cost O(materials) state changes instead of O(draws). Sorting is stable, draws with equal keys keep submission order.
+     *
+     * Key layout, most significant first:
+     * - layer, 8 bits, lower layers are drawn first;
+     * - translucent flag, 1 bit, opaque draws of a layer go before translucent ones;
+     * - opaque: pipeline 15 bits, material 16 bits, depth 24 bits front to back;
+     * - translucent: inverted depth 24 bits back to front, pipeline 15 bits, material 16 bits.
+     */
+    class render_queue {
+        public:
+        /**
+         * @brief What a draw needs, pointers have to stay valid until `record`.
+         */
+        struct draw_packet {
+            public:
+            shader* shad;
+            material* mat;          // nullptr to draw with the shader sets, otherwise a material of `shad`
+            buffer* vertexBuffer;   // nullptr to keep the bound one
+            buffer* indexBuffer;    // nullptr for a non-indexed draw
+            uint32_t count;         // indices or vertices
+            uint32_t first;         // first index or first vertex
+            uint32_t instanceCount;
+            int32_t baseVertex;     // indexed draws only
+
+            public:
+            draw_packet() : shad(nullptr), mat(nullptr), vertexBuffer(nullptr), indexBuffer(nullptr), count(0), first(0), instanceCount(1), baseVertex(0) {}
+            draw_packet(shader* shad, material* mat, buffer* vertexBuffer, buffer* indexBuffer, uint32_t count, uint32_t first = 0, uint32_t instanceCount = 1, int32_t baseVertex = 0)
+                :   shad(shad),
+                    mat(mat),
+                    vertexBuffer(vertexBuffer),
+                    indexBuffer(indexBuffer),
+                    count(count),
+                    first(first),
+                    instanceCount(instanceCount),
+                    baseVertex(baseVertex) {}
+        };
+        struct sort_key {
+            public:
+            static constexpr uint32_t pipelineBits = 15;
+            static constexpr uint32_t materialBits = 16;
+            static constexpr uint32_t depthBits = 24;
+
+            public:
+            /**
+             * @param depth View depth in [0, 1], clamped.
+             */
+            WIENDER_NODISCARD static uint64_t opaque(uint8_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept;
+            WIENDER_NODISCARD static uint64_t translucent(uint8_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept;
+        };
+        /**
+         * @brief Counters of the last `record`.
+         */
+        struct statistics {
+            uint32_t draws;
+            uint32_t pipelineChanges;
+            uint32_t materialChanges;
+            uint32_t vertexBufferChanges;
+            uint32_t indexBufferChanges;
+        };
+
+        private:
+        struct entry {
+            uint64_t key;
+            uint32_t packet;
+        };
+
+        private:
+        wienderer* owner_;
+        std::vector<draw_packet> packets_;
+        std::vector<entry> entries_;
+        std::vector<entry> scratch_;
+        std::unordered_map<const shader*, uint32_t> pipelineIds_;
+        std::unordered_map<const material*, uint32_t> materialIds_;
+        statistics statistics_;
+
+        public:
+        /**
+         * @throw std::runtime_error If owner is nullptr.
+         */
+        explicit render_queue(wienderer* owner);
+        render_queue(const render_queue&) = delete;
+        render_queue& operator=(const render_queue&) = delete;
+
+        public:
+        void reserve(std::size_t packetCount);
+        /**
+         * @brief Submits a draw with a caller-built key, see `sort_key`.
+         */
+        void submit(uint64_t key, const draw_packet& packet);
+        /**
+         * @brief Submits a draw keyed by its shader and material, ids are assigned on first use and kept between frames.
+         */
+        void submit(uint8_t layer, bool translucent, float depth, const draw_packet& packet);
+        /**
+         * @brief Sorts and records submitted draws into the owner, then clears the queue.
+         * Has to be called between `begin_render` and `end_render`.
+         */
+        void record();
+        /**
+         * @brief Drops submitted draws, keeps allocated memory and bucket ids.
+         */
+        void clear() noexcept;
+        WIENDER_NODISCARD std::size_t size() const noexcept {
+            return packets_.size();
+        }
+        WIENDER_NODISCARD const statistics& get_statistics() const noexcept {
+            return statistics_;
+        }
+
+        private:
+        void sort_entries();
+    };
+} // namespace wiender
+
+#endif // WIENDER_RENDER_QUEUE_HPP_
@@ -0,0 +1,98 @@
+#ifndef WIENDER_SHADER_ARCHIVE_HPP_
+#define WIENDER_SHADER_ARCHIVE_HPP_ 1
+
+#include "wiender_core.hpp"
+
+namespace wiender {
+    /**
+     * @brief Read-only shader archive, mapped into memory.
+     *
+     * Layout (native endianness, every section 8 byte aligned):
+     *  - header
+     *  - entry index, sorted by name hash
+     *  - entry names (not null terminated)
+     *  - SPIR-V blobs
+     *  - cache data blob, suitable for `wienderer::load_cache_data` (precomputed reflection)
+     *
+     * Stages returned by `get_stage` reference the mapped memory, so SPIR-V is never copied
+     * and the archive must outlive every shader created from it.
+     * Archives are built by the `shader_packer` tool.
+     */
+    class shader_archive {
+        public:
+        struct header {
+            static constexpr uint32_t archiveMagic = 0x52415357; // "WSAR"
+            static constexpr uint32_t archiveVersion = 1;
+
+            uint32_t magic;
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t reserved;
+            uint64_t cacheDataOffset;
+            uint64_t cacheDataSize;
+        };
+        struct entry {
+            uint64_t nameHash;
+            uint64_t codeHash;      // content hash of the SPIR-V, same as the backend reflection cache key
+            uint64_t nameOffset;
+            uint64_t nameSize;
+            uint64_t codeOffset;
+            uint64_t codeSize;      // in bytes
+        };
+
+        private:
+        void* mapping_;
+        std::size_t size_;
+        void* fileHandle_;          // used on windows only
+        void* mappingHandle_;       // used on windows only
+
+        public:
+        /**
+         * @brief Maps the archive file into memory.
+         * @throw std::runtime_error If the file can't be opened, mapped or isn't a valid archive.
+         */
+        explicit shader_archive(const char* path);
+        ~shader_archive();
+        shader_archive(const shader_archive&) = delete;
+        shader_archive& operator=(const shader_archive&) = delete;
+
+        public:
+        /**
+         * @brief Finds an entry by name.
+         * @return Pointer into the mapped index or nullptr if there is no such entry.
+         */
+        WIENDER_NODISCARD const entry* find(const char* name) const noexcept;
+        /**
+         * @brief Creates a stage referencing archive memory, see `shader::stage::from_memory`.
+         * @throw std::runtime_error If there is no such entry.
+         */
+        WIENDER_NODISCARD shader::stage get_stage(shader::stage::kind stageKind, const char* name) const;
+        WIENDER_NODISCARD shader::stage get_stage(shader::stage::kind stageKind, const char* name, const std::vector<shader::stage::specialization_constant>& specializationConstants) const;
+
+        public:
+        WIENDER_NODISCARD const header& get_header() const noexcept {
+            return *static_cast<const header*>(mapping_);
+        }
+        WIENDER_NODISCARD const entry* get_entries() const noexcept {
+            return reinterpret_cast<const entry*>(static_cast<const char*>(mapping_) + sizeof(header));
+        }
+        WIENDER_NODISCARD std::size_t get_entry_count() const noexcept {
+            return get_header().entryCount;
+        }
+        WIENDER_NODISCARD const void* get_cache_data() const noexcept {
+            return static_cast<const char*>(mapping_) + get_header().cacheDataOffset;
+        }
+        WIENDER_NODISCARD std::size_t get_cache_data_size() const noexcept {
+            return static_cast<std::size_t>(get_header().cacheDataSize);
+        }
+
+        public:
+        WIENDER_NODISCARD static uint64_t hash_name(const char* name, std::size_t nameSize) noexcept;
+
+        private:
+        void validate() const;
+        void unmap() noexcept;
+    };
+} // namespace wiender
+
+#endif // WIENDER_SHADER_ARCHIVE_HPP_
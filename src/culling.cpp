@@ -0,0 +1,125 @@
+#include "../include/wiender_culling.hpp"
+
+#include <stdexcept>
+#include <cmath>
+
+namespace wiender {
+    namespace {
+        constexpr uint32_t cullGroupSize = 64; // local_size_x of culling.comp
+
+        struct culling_params { // std140 block of culling.comp
+            float planes[6][4];
+            uint32_t objectCount;
+            uint32_t maxObjectCount;
+            uint32_t compact;
+            uint32_t indexed;
+        };
+        static_assert(sizeof(culling_pass::object) == 48, "culling_pass::object has to match std430 layout of culling.comp");
+
+        culling_params& get_params(shader* shad) {
+            const shader::uniform_buffer_info info = shad->get_uniform_buffer_info(shader::drawSet, 0);
+            if (info.size < sizeof(culling_params))
+                throw std::runtime_error("wiender::culling_pass culling stage doesn't match culling.comp");
+            return *static_cast<culling_params*>(info.data);
+        }
+    } // namespace
+
+    culling_pass::frustum culling_pass::frustum::from_view_projection(const float* m) noexcept {
+        // rows of the matrix, m is column-major
+        const auto row = [m](int i, int j) { return m[j * 4 + i]; };
+
+        frustum result{};
+        for (int j = 0; j < 4; ++j) {
+            result.planes[0][j] = row(3, j) + row(0, j);    // left
+            result.planes[1][j] = row(3, j) - row(0, j);    // right
+            result.planes[2][j] = row(3, j) + row(1, j);    // bottom
+            result.planes[3][j] = row(3, j) - row(1, j);    // top
+            result.planes[4][j] = row(2, j);                // near, z >= 0
+            result.planes[5][j] = row(3, j) - row(2, j);    // far
+        }
+        for (auto& plane : result.planes) {
+            const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            if (length == 0.0f)
+                continue;
+            for (float& value : plane)
+                value /= length;
+        }
+        return result;
+    }
+    culling_pass::frustum culling_pass::frustum::from_view_rect(float minX, float minY, float maxX, float maxY) noexcept {
+        return frustum{{
+            {  1.0f,  0.0f, 0.0f, -minX },
+            { -1.0f,  0.0f, 0.0f,  maxX },
+            {  0.0f,  1.0f, 0.0f, -minY },
+            {  0.0f, -1.0f, 0.0f,  maxY },
+            {  0.0f,  0.0f, 0.0f,  1.0f }, // always inside
+            {  0.0f,  0.0f, 0.0f,  1.0f },
+        }};
+    }
+
+    culling_pass::culling_pass(wienderer* owner, const shader::stage& cullStage, uint32_t maxObjectCount, bool indexed)
+        :   owner_(owner),
+            shader_{},
+            objectsBuffer_{},
+            drawsBuffer_{},
+            countBuffer_{},
+            maxObjectCount_(maxObjectCount),
+            indexed_(indexed),
+            compact_(false) {
+
+        if (owner_ == nullptr)
+            throw std::runtime_error("wiender::culling_pass::culling_pass owner cannot be nullptr");
+        if (maxObjectCount_ == 0)
+            throw std::runtime_error("wiender::culling_pass::culling_pass max object count cannot be 0");
+        if (cullStage.stageKind != shader::stage::kind::COMPUTE)
+            throw std::runtime_error("wiender::culling_pass::culling_pass culling stage has to be a compute stage");
+
+        compact_ = owner_->is_feature_supported(wienderer::feature::INDIRECT_DRAW_COUNT);
+
+        shader_ = owner_->create_shader(shader::create_info({ cullStage }));
+        objectsBuffer_ = owner_->create_buffer(buffer::type::GPU_SIDE_STORAGE, maxObjectCount_ * sizeof(object));
+        const std::size_t drawSize = indexed_ ? sizeof(draw_indexed_indirect_command) : sizeof(draw_indirect_command);
+        drawsBuffer_ = owner_->create_buffer(buffer::type::INDIRECT, maxObjectCount_ * drawSize);
+        countBuffer_ = owner_->create_buffer(buffer::type::INDIRECT, sizeof(uint32_t));
+
+        shader_->bind_buffer(shader::drawSet, 1, objectsBuffer_.get(), 0, 0);
+        shader_->bind_buffer(shader::drawSet, 2, drawsBuffer_.get(), 0, 0);
+        shader_->bind_buffer(shader::drawSet, 3, countBuffer_.get(), 0, 0);
+
+        culling_params& params = get_params(shader_.get());
+        params = culling_params{};
+        params.maxObjectCount = maxObjectCount_;
+        params.compact = compact_ ? 1u : 0u;
+        params.indexed = indexed_ ? 1u : 0u;
+        const frustum everything = frustum::from_view_rect(-INFINITY, -INFINITY, INFINITY, INFINITY);
+        std::memcpy(params.planes, everything.planes, sizeof(params.planes));
+    }
+
+    void culling_pass::set_frustum(const frustum& f) {
+        std::memcpy(get_params(shader_.get()).planes, f.planes, sizeof(f.planes));
+    }
+    void culling_pass::set_object_count(uint32_t objectCount) {
+        if (objectCount > maxObjectCount_)
+            throw std::runtime_error("wiender::culling_pass::set_object_count object count exceeds max object count");
+        get_params(shader_.get()).objectCount = objectCount;
+    }
+    void culling_pass::record_cull() {
+        if (compact_)
+            owner_->fill_buffer(countBuffer_.get(), 0, sizeof(uint32_t), 0);
+        shader_->set();
+        owner_->dispatch((maxObjectCount_ + cullGroupSize - 1) / cullGroupSize, 1, 1);
+    }
+    void culling_pass::record_draw() {
+        if (compact_) {
+            if (indexed_)
+                owner_->draw_indexed_indirect_count(drawsBuffer_.get(), 0, countBuffer_.get(), 0, maxObjectCount_, 0);
+            else
+                owner_->draw_indirect_count(drawsBuffer_.get(), 0, countBuffer_.get(), 0, maxObjectCount_, 0);
+        } else {
+            if (indexed_)
+                owner_->draw_indexed_indirect(drawsBuffer_.get(), 0, maxObjectCount_, 0);
+            else
+                owner_->draw_indirect(drawsBuffer_.get(), 0, maxObjectCount_, 0);
+        }
+    }
+} // namespace wiender
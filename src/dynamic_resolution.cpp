@@ -0,0 +1,124 @@
+#include "../include/wiender_dynamic_resolution.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+namespace wiender {
+    namespace {
+        constexpr uint32_t settleFrames = 8;    // frames in flight at a scale change still measure the previous scale
+        constexpr uint32_t sampleFrames = 8;    // measured frames before the next decision
+        constexpr double smoothing = 0.2;       // weight of a new frame time in the average
+        constexpr double raiseHeadroom = 0.85;  // the next step up has to fit into this part of the budget
+
+        struct upscale_params { // std140 block of upscale.frag
+            float uvScale[2];
+            float texelSize[2];
+            float sharpness;
+        };
+
+        upscale_params& get_params(shader* shad) {
+            const shader::uniform_buffer_info info = shad->get_uniform_buffer_info(shader::drawSet, 1);
+            if (info.size < sizeof(upscale_params))
+                throw std::runtime_error("wiender::dynamic_resolution upscale stage doesn't match upscale.frag");
+            return *static_cast<upscale_params*>(info.data);
+        }
+    } // namespace
+
+    dynamic_resolution::dynamic_resolution(wienderer* owner, const shader::stage& vertexStage, const shader::stage& fragmentStage, const texture::extent& windowExtent, render_target::format targetFormat, const settings& s)
+        :   owner_(owner),
+            settings_(s),
+            windowExtent_(windowExtent),
+            target_{},
+            upscaleShader_{},
+            scale_(s.maxScale),
+            averageFrameTime_(0.0),
+            framesAtScale_(0) {
+
+        if (owner_ == nullptr)
+            throw std::runtime_error("wiender::dynamic_resolution::dynamic_resolution owner cannot be nullptr");
+        if (!(settings_.minScale > 0.0f) || !(settings_.minScale <= settings_.maxScale) || !(settings_.maxScale <= 1.0f))
+            throw std::runtime_error("wiender::dynamic_resolution::dynamic_resolution scale bounds have to be in (0, 1]");
+        if (!(settings_.scaleStep > 0.0f) || !(settings_.frameTimeBudget > 0.0))
+            throw std::runtime_error("wiender::dynamic_resolution::dynamic_resolution scale step and frame time budget have to be positive");
+        if ((vertexStage.stageKind != shader::stage::kind::VERTEX) || (fragmentStage.stageKind != shader::stage::kind::FRAGMENT))
+            throw std::runtime_error("wiender::dynamic_resolution::dynamic_resolution upscale stages have to be a vertex and a fragment stage");
+
+        target_ = owner_->create_render_target(texture::extent(windowExtent_.width, windowExtent_.height), targetFormat, 1);
+
+        shader::stage upscaleStage = fragmentStage;
+        upscaleStage.specializationConstants.emplace_back(0u, settings_.upscaleFilter == filter::SHARPEN);
+        shader::create_info createInfo({ vertexStage, upscaleStage });
+        createInfo.cullMode = shader::cull_mode::NONE;
+        upscaleShader_ = owner_->create_shader(createInfo);
+        upscaleShader_->bind_texture(shader::drawSet, 0, 0, target_.get());
+
+        apply_scale(settings_.maxScale);
+    }
+
+    void dynamic_resolution::set_scale(float scale) {
+        apply_scale(scale);
+    }
+    void dynamic_resolution::set_sharpness(float sharpness) {
+        settings_.sharpness = std::min(std::max(sharpness, 0.0f), 1.0f);
+        write_params();
+    }
+    void dynamic_resolution::record_upscale() {
+        upscaleShader_->set();
+        owner_->begin_render();
+        owner_->draw_verteces(3, 0, 1); // fullscreen triangle
+        owner_->end_render();
+    }
+    bool dynamic_resolution::update() {
+        const double frameTime = owner_->get_gpu_frame_time();
+        if (frameTime <= 0.0)
+            return false;
+        if (++framesAtScale_ <= settleFrames)
+            return false;
+
+        averageFrameTime_ = (averageFrameTime_ == 0.0) ? frameTime : averageFrameTime_ + (frameTime - averageFrameTime_) * smoothing;
+        if (framesAtScale_ < settleFrames + sampleFrames)
+            return false;
+
+        // GPU time is taken as proportional to the pixel count, scale squared
+        float newScale = scale_;
+        if (averageFrameTime_ > settings_.frameTimeBudget) {
+            newScale = scale_ * static_cast<float>(std::sqrt(settings_.frameTimeBudget / averageFrameTime_)); // may drop several steps at once
+        } else {
+            const double raisedScale = static_cast<double>(scale_ + settings_.scaleStep);
+            const double raisedTime = averageFrameTime_ * (raisedScale * raisedScale) / (static_cast<double>(scale_) * scale_);
+            if (raisedTime < settings_.frameTimeBudget * raiseHeadroom)
+                newScale = scale_ + settings_.scaleStep; // one step at a time, a wrong raise costs a dropped frame
+        }
+        newScale = quantize_scale(newScale);
+        if (newScale == scale_) {
+            framesAtScale_ = settleFrames; // keep averaging at the current scale
+            return false;
+        }
+        apply_scale(newScale);
+        return true;
+    }
+
+    float dynamic_resolution::quantize_scale(float scale) const noexcept {
+        const float quantized = std::floor(scale / settings_.scaleStep + 0.001f) * settings_.scaleStep;
+        return std::min(std::max(quantized, settings_.minScale), settings_.maxScale);
+    }
+    void dynamic_resolution::apply_scale(float scale) {
+        scale_ = quantize_scale(scale);
+        const uint32_t width = std::max(1u, static_cast<uint32_t>(std::lround(windowExtent_.width * scale_)));
+        const uint32_t height = std::max(1u, static_cast<uint32_t>(std::lround(windowExtent_.height * scale_)));
+        target_->set_render_extent(texture::extent(std::min(width, windowExtent_.width), std::min(height, windowExtent_.height)));
+        averageFrameTime_ = 0.0;
+        framesAtScale_ = 0;
+        write_params();
+    }
+    void dynamic_resolution::write_params() {
+        const texture::extent renderExtent = target_->get_render_extent();
+        upscale_params& params = get_params(upscaleShader_.get());
+        params.uvScale[0] = static_cast<float>(renderExtent.width) / static_cast<float>(windowExtent_.width);
+        params.uvScale[1] = static_cast<float>(renderExtent.height) / static_cast<float>(windowExtent_.height);
+        params.texelSize[0] = 1.0f / static_cast<float>(windowExtent_.width);
+        params.texelSize[1] = 1.0f / static_cast<float>(windowExtent_.height);
+        params.sharpness = settings_.sharpness;
+    }
+} // namespace wiender
@@ -0,0 +1,142 @@
+#include "../include/wiender_render_queue.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+namespace wiender {
+    namespace {
+        constexpr uint32_t layerShift = 56;
+        constexpr uint32_t translucentShift = 55;
+        constexpr uint32_t radixBits = 8;
+        constexpr uint32_t radixPasses = 64 / radixBits;
+        constexpr uint32_t radixSize = 1u << radixBits;
+
+        uint64_t quantize_depth(float depth) noexcept {
+            constexpr uint64_t depthMax = (1ull << render_queue::sort_key::depthBits) - 1;
+            const float clamped = std::min(std::max(depth, 0.0f), 1.0f); // NaN goes to 0
+            return static_cast<uint64_t>(clamped * static_cast<float>(depthMax));
+        }
+        uint64_t mask(uint32_t value, uint32_t bits) noexcept {
+            return static_cast<uint64_t>(value) & ((1ull << bits) - 1);
+        }
+        template<class T>
+        uint32_t bucket_id(std::unordered_map<const T*, uint32_t>& ids, const T* object) {
+            if (object == nullptr)
+                return 0;
+            // ids past the key field width wrap around, that only merges buckets
+            return ids.emplace(object, static_cast<uint32_t>(ids.size() + 1)).first->second;
+        }
+    } // namespace
+
+    uint64_t render_queue::sort_key::opaque(uint8_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept {
+        return (static_cast<uint64_t>(layer) << layerShift)
+            | (mask(pipeline, pipelineBits) << (materialBits + depthBits))
+            | (mask(material, materialBits) << depthBits)
+            | quantize_depth(depth);
+    }
+    uint64_t render_queue::sort_key::translucent(uint8_t layer, uint32_t pipeline, uint32_t material, float depth) noexcept {
+        constexpr uint64_t depthMax = (1ull << depthBits) - 1;
+        return (static_cast<uint64_t>(layer) << layerShift)
+            | (1ull << translucentShift)
+            | ((depthMax - quantize_depth(depth)) << (pipelineBits + materialBits))
+            | (mask(pipeline, pipelineBits) << materialBits)
+            | mask(material, materialBits);
+    }
+
+    render_queue::render_queue(wienderer* owner) : owner_(owner), packets_{}, entries_{}, scratch_{}, pipelineIds_{}, materialIds_{}, statistics_{} {
+        if (owner_ == nullptr)
+            throw std::runtime_error("wiender::render_queue::render_queue owner cannot be nullptr");
+    }
+
+    void render_queue::reserve(std::size_t packetCount) {
+        packets_.reserve(packetCount);
+        entries_.reserve(packetCount);
+        scratch_.reserve(packetCount);
+    }
+    void render_queue::submit(uint64_t key, const draw_packet& packet) {
+        if (packet.shad == nullptr)
+            throw std::runtime_error("wiender::render_queue::submit packet shader cannot be nullptr");
+        entries_.push_back(entry{ key, static_cast<uint32_t>(packets_.size()) });
+        packets_.push_back(packet);
+    }
+    void render_queue::submit(uint8_t layer, bool translucent, float depth, const draw_packet& packet) {
+        const uint32_t pipelineId = bucket_id<shader>(pipelineIds_, packet.shad);
+        const uint32_t materialId = bucket_id<material>(materialIds_, packet.mat);
+        submit(translucent ? sort_key::translucent(layer, pipelineId, materialId, depth) : sort_key::opaque(layer, pipelineId, materialId, depth), packet);
+    }
+    void render_queue::record() {
+        sort_entries();
+
+        statistics_ = statistics{};
+        const shader* currentShader = nullptr;
+        const material* currentMaterial = nullptr;
+        const buffer* currentVertexBuffer = nullptr;
+        const buffer* currentIndexBuffer = nullptr;
+        for (const entry& e : entries_) {
+            const draw_packet& packet = packets_[e.packet];
+
+            if (packet.shad != currentShader || packet.mat != currentMaterial) {
+                if (packet.mat != nullptr)
+                    packet.mat->set();
+                else
+                    packet.shad->set();
+                statistics_.pipelineChanges += packet.shad != currentShader ? 1 : 0;
+                statistics_.materialChanges += packet.mat != currentMaterial ? 1 : 0;
+                currentShader = packet.shad;
+                currentMaterial = packet.mat;
+            }
+            if (packet.vertexBuffer != nullptr && packet.vertexBuffer != currentVertexBuffer) {
+                packet.vertexBuffer->bind();
+                currentVertexBuffer = packet.vertexBuffer;
+                ++statistics_.vertexBufferChanges;
+            }
+            if (packet.indexBuffer != nullptr) {
+                if (packet.indexBuffer != currentIndexBuffer) {
+                    packet.indexBuffer->bind();
+                    currentIndexBuffer = packet.indexBuffer;
+                    ++statistics_.indexBufferChanges;
+                }
+                owner_->draw_indexed(packet.count, packet.first, packet.instanceCount, packet.baseVertex);
+            } else {
+                owner_->draw_verteces(packet.count, packet.first, packet.instanceCount);
+            }
+            ++statistics_.draws;
+        }
+        clear();
+    }
+    void render_queue::clear() noexcept {
+        packets_.clear();
+        entries_.clear();
+    }
+
+    void render_queue::sort_entries() {
+        const std::size_t count = entries_.size();
+        if (count < 2)
+            return;
+
+        // LSD radix sort, all digit histograms are counted in one pass
+        std::vector<uint32_t> histograms(radixPasses * radixSize, 0);
+        for (const entry& e : entries_) {
+            for (uint32_t pass = 0; pass < radixPasses; ++pass)
+                ++histograms[pass * radixSize + ((e.key >> (pass * radixBits)) & (radixSize - 1))];
+        }
+
+        scratch_.resize(count);
+        for (uint32_t pass = 0; pass < radixPasses; ++pass) {
+            uint32_t* histogram = histograms.data() + pass * radixSize;
+            const uint32_t shift = pass * radixBits;
+            if (histogram[(entries_.front().key >> shift) & (radixSize - 1)] == count)
+                continue; // every key has the same digit
+
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < radixSize; ++digit) {
+                const uint32_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+            for (const entry& e : entries_)
+                scratch_[histogram[(e.key >> shift) & (radixSize - 1)]++] = e;
+            entries_.swap(scratch_);
+        }
+    }
+} // namespace wiender
@@ -0,0 +1,150 @@
+#include "../include/wiender_shader_archive.hpp"
+
+#include <stdexcept>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace wiender {
+    shader_archive::shader_archive(const char* path) : mapping_(nullptr), size_(0), fileHandle_(nullptr), mappingHandle_(nullptr) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to open archive");
+        fileHandle_ = file;
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            unmap();
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to get archive size");
+        }
+        size_ = static_cast<std::size_t>(fileSize.QuadPart);
+        if (size_ < sizeof(header)) {
+            unmap();
+            throw std::runtime_error("wiender::shader_archive::shader_archive archive is too small");
+        }
+
+        mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle_ == nullptr) {
+            unmap();
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to create file mapping");
+        }
+        mapping_ = MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+        if (mapping_ == nullptr) {
+            unmap();
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to map archive");
+        }
+#else
+        int file = open(path, O_RDONLY);
+        if (file < 0)
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to open archive");
+
+        struct stat fileStat;
+        if (fstat(file, &fileStat) != 0) {
+            close(file);
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to get archive size");
+        }
+        size_ = static_cast<std::size_t>(fileStat.st_size);
+        if (size_ < sizeof(header)) {
+            close(file);
+            throw std::runtime_error("wiender::shader_archive::shader_archive archive is too small");
+        }
+
+        void* mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        close(file); // mapping keeps the file referenced
+        if (mapping == MAP_FAILED)
+            throw std::runtime_error("wiender::shader_archive::shader_archive failed to map archive");
+        mapping_ = mapping;
+#endif
+        try {
+            validate();
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+    shader_archive::~shader_archive() {
+        unmap();
+    }
+
+    const shader_archive::entry* shader_archive::find(const char* name) const noexcept {
+        const std::size_t nameSize = std::strlen(name);
+        const uint64_t nameHash = hash_name(name, nameSize);
+        const entry* first = get_entries();
+        const entry* last = first + get_entry_count();
+        const char* base = static_cast<const char*>(mapping_);
+
+        for (const entry* it = std::lower_bound(first, last, nameHash, [](const entry& e, uint64_t hash) { return e.nameHash < hash; });
+             it != last && it->nameHash == nameHash; ++it) {
+            if (it->nameSize == nameSize && std::memcmp(base + it->nameOffset, name, nameSize) == 0)
+                return it;
+        }
+        return nullptr;
+    }
+    shader::stage shader_archive::get_stage(shader::stage::kind stageKind, const char* name) const {
+        const entry* found = find(name);
+        if (found == nullptr)
+            throw std::runtime_error("wiender::shader_archive::get_stage no such shader in archive");
+
+        const uint32_t* code = reinterpret_cast<const uint32_t*>(static_cast<const char*>(mapping_) + found->codeOffset);
+        return shader::stage::from_memory(stageKind, code, static_cast<std::size_t>(found->codeSize / sizeof(uint32_t)), found->codeHash);
+    }
+    shader::stage shader_archive::get_stage(shader::stage::kind stageKind, const char* name, const std::vector<shader::stage::specialization_constant>& specializationConstants) const {
+        shader::stage result = get_stage(stageKind, name);
+        result.specializationConstants = specializationConstants;
+        return result;
+    }
+
+    uint64_t shader_archive::hash_name(const char* name, std::size_t nameSize) noexcept {
+        uint64_t hash = 14695981039346656037ull; // FNV-1a
+        for (std::size_t i = 0; i < nameSize; ++i) {
+            hash ^= static_cast<unsigned char>(name[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    void shader_archive::validate() const {
+        const header& archiveHeader = get_header();
+        if (archiveHeader.magic != header::archiveMagic || archiveHeader.version != header::archiveVersion)
+            throw std::runtime_error("wiender::shader_archive::validate not a shader archive or unsupported version");
+        if ((size_ - sizeof(header)) / sizeof(entry) < archiveHeader.entryCount)
+            throw std::runtime_error("wiender::shader_archive::validate entry index is out of bounds");
+        if (archiveHeader.cacheDataOffset > size_ || archiveHeader.cacheDataSize > size_ - archiveHeader.cacheDataOffset)
+            throw std::runtime_error("wiender::shader_archive::validate cache data is out of bounds");
+
+        const entry* entries = get_entries();
+        for (uint32_t i = 0; i < archiveHeader.entryCount; ++i) {
+            const entry& e = entries[i];
+            if (e.nameOffset > size_ || e.nameSize > size_ - e.nameOffset)
+                throw std::runtime_error("wiender::shader_archive::validate entry name is out of bounds");
+            if (e.codeOffset > size_ || e.codeSize > size_ - e.codeOffset || e.codeOffset % sizeof(uint32_t) != 0 || e.codeSize % sizeof(uint32_t) != 0)
+                throw std::runtime_error("wiender::shader_archive::validate entry code is out of bounds or misaligned");
+            if (i != 0 && entries[i - 1].nameHash > e.nameHash)
+                throw std::runtime_error("wiender::shader_archive::validate entry index isn't sorted");
+        }
+    }
+    void shader_archive::unmap() noexcept {
+#ifdef _WIN32
+        if (mapping_ != nullptr)
+            UnmapViewOfFile(mapping_);
+        if (mappingHandle_ != nullptr)
+            CloseHandle(static_cast<HANDLE>(mappingHandle_));
+        if (fileHandle_ != nullptr)
+            CloseHandle(static_cast<HANDLE>(fileHandle_));
+#else
+        if (mapping_ != nullptr)
+            munmap(mapping_, size_);
+#endif
+        mapping_ = nullptr;
+        mappingHandle_ = nullptr;
+        fileHandle_ = nullptr;
+    }
+} // namespace wiender
@@ -5,6 +5,9 @@
 #include <vulkan/vulkan.h>
 #include <vector>
 #include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
 
 #include "../wiender_implement_core.hpp"
 
@@ -12,6 +15,32 @@ namespace wiender {
     void spv_reflect_check(SpvReflectResult result, const wcs::tiny_string_view<char>& strv) {
         wiender_assert(result == SPV_REFLECT_RESULT_SUCCESS, strv);
     }
+    struct raii_SpvReflectShaderModule { // 'strong' exception g-tie
+        private:
+        SpvReflectShaderModule value;
+
+        public:
+        ~raii_SpvReflectShaderModule() {
+            spvReflectDestroyShaderModule(&value);
+        }
+
+        public:
+        SpvReflectShaderModule* operator->()  {
+            return &value;
+        }
+        const SpvReflectShaderModule* operator->() const {
+            return &value;
+        }
+
+        public:
+        SpvReflectShaderModule& get() noexcept {
+            return value;
+        }
+        const SpvReflectShaderModule& get() const noexcept {
+            return value;
+        }
+
+    };
     struct descriptor_set_layout_data {
         uint32_t setNumber;
         VkDescriptorSetLayoutCreateInfo createInfo;
@@ -19,59 +48,33 @@ namespace wiender {
         std::vector<size_t> bufferSizes;
         size_t size;
     };
+    /**
+     * @brief Everything wiender needs from a single SPIR-V stage, produced by one spirv-reflect parse.
+     *
+     * Holds no pointers into the spirv-reflect module, so it can be cached and serialized.
+     * `createInfo` of the sets is not filled here, see `merge_descriptor_sets`.
+     */
+    struct shader_stage_reflection {
+        std::vector<descriptor_set_layout_data> descriptorSets;
+        std::vector<uint32_t> specializationConstantIds;
+        VkPushConstantRange pushConstantRange; // covers all push constant blocks of the stage, size is 0 if there are none
+    };
 
-    void get_descriptor_sets(std::vector<descriptor_set_layout_data>& out, size_t codeSize, const uint32_t* code) { // in bytes
-        struct raii_SpvReflectShaderModule { // 'strong' exception g-tie
-            private:
-            SpvReflectShaderModule value;
-
-            public:
-            ~raii_SpvReflectShaderModule() {
-                spvReflectDestroyShaderModule(&value);
-            }
-
-            public:
-            SpvReflectShaderModule* operator->()  {
-                return &value;
-            }
-            const SpvReflectShaderModule* operator->() const {
-                return &value;
-            }
-
-            public:
-            SpvReflectShaderModule& get() noexcept {
-                return value;
-            }
-            const SpvReflectShaderModule& get() const noexcept {
-                return value;
-            }
-
-        };
-        
+    void reflect_shader_stage(shader_stage_reflection& out, size_t codeSize, const uint32_t* code) { // in bytes
         raii_SpvReflectShaderModule module{};
-        spv_reflect_check(spvReflectCreateShaderModule(codeSize, code, &module.get()), "wiender::get_descriptor_sets failed to create spv reflect shader module");
+        spv_reflect_check(spvReflectCreateShaderModule(codeSize, code, &module.get()), "wiender::reflect_shader_stage failed to create spv reflect shader module");
 
         uint32_t count;
-        spv_reflect_check(spvReflectEnumerateDescriptorSets(&module.get(), &count, NULL), "wiender::get_descriptor_sets failed to enumerate descriptor sets 1");
+        spv_reflect_check(spvReflectEnumerateDescriptorSets(&module.get(), &count, NULL), "wiender::reflect_shader_stage failed to enumerate descriptor sets 1");
 
         std::vector<SpvReflectDescriptorSet*> sets(count);
-        spv_reflect_check(spvReflectEnumerateDescriptorSets(&module.get(), &count, sets.data()), "wiender::get_descriptor_sets failed to enumerate descriptor sets 2");
+        spv_reflect_check(spvReflectEnumerateDescriptorSets(&module.get(), &count, sets.data()), "wiender::reflect_shader_stage failed to enumerate descriptor sets 2");
 
         for (size_t iS = 0; iS < sets.size(); ++iS) {
             const SpvReflectDescriptorSet& reflSet = *(sets[iS]);
-            descriptor_set_layout_data* layoutp = nullptr;
 
-            for (auto& set : out) {
-                if (set.setNumber == reflSet.set) {
-                    layoutp = &set;
-                    break;
-                }
-            }
-            if (layoutp == nullptr) {
-                out.emplace_back(descriptor_set_layout_data{});
-                layoutp = &out.back();
-            }
-            descriptor_set_layout_data& layout = *layoutp;
+            out.descriptorSets.emplace_back(descriptor_set_layout_data{});
+            descriptor_set_layout_data& layout = out.descriptorSets.back();
 
             for (uint32_t iB = 0; iB < reflSet.binding_count; ++iB) {
                 const SpvReflectDescriptorBinding& reflBinding = *(reflSet.bindings[iB]);
@@ -92,12 +95,257 @@ namespace wiender {
                 layoutBinding.stageFlags = static_cast<VkShaderStageFlagBits>(module->shader_stage);
                 layoutBindingBufferSize = reflBinding.block.size;
             }
-
             layout.setNumber = reflSet.set;
+        }
+
+        spv_reflect_check(spvReflectEnumerateSpecializationConstants(&module.get(), &count, NULL), "wiender::reflect_shader_stage failed to enumerate specialization constants 1");
+
+        std::vector<SpvReflectSpecializationConstant*> constants(count);
+        spv_reflect_check(spvReflectEnumerateSpecializationConstants(&module.get(), &count, constants.data()), "wiender::reflect_shader_stage failed to enumerate specialization constants 2");
+
+        for (const auto* constant : constants) {
+            out.specializationConstantIds.emplace_back(constant->constant_id);
+        }
+
+        spv_reflect_check(spvReflectEnumeratePushConstantBlocks(&module.get(), &count, NULL), "wiender::reflect_shader_stage failed to enumerate push constant blocks 1");
+
+        std::vector<SpvReflectBlockVariable*> blocks(count);
+        spv_reflect_check(spvReflectEnumeratePushConstantBlocks(&module.get(), &count, blocks.data()), "wiender::reflect_shader_stage failed to enumerate push constant blocks 2");
+
+        out.pushConstantRange = {};
+        for (const auto* block : blocks) {
+            const uint32_t rangeEnd = out.pushConstantRange.offset + out.pushConstantRange.size;
+            const uint32_t blockEnd = block->offset + block->size;
+            const uint32_t newOffset = (out.pushConstantRange.size == 0) ? block->offset : std::min(out.pushConstantRange.offset, block->offset);
+            out.pushConstantRange.size = ((out.pushConstantRange.size == 0) ? blockEnd : std::max(rangeEnd, blockEnd)) - newOffset;
+            out.pushConstantRange.offset = newOffset;
+        }
+        if (out.pushConstantRange.size != 0)
+            out.pushConstantRange.stageFlags = static_cast<VkShaderStageFlagBits>(module->shader_stage);
+    }
+    /**
+     * @brief Merges push constant range of one stage into the range of the whole program.
+     *
+     * Whole program uses a single range visible to every stage that declares push constants.
+     */
+    void merge_push_constant_range(VkPushConstantRange& out, const VkPushConstantRange& range) {
+        if (range.size == 0)
+            return;
+        if (out.size == 0) {
+            out = range;
+            return;
+        }
+        const uint32_t end = std::max(out.offset + out.size, range.offset + range.size);
+        out.offset = std::min(out.offset, range.offset);
+        out.size = end - out.offset;
+        out.stageFlags |= range.stageFlags;
+    }
+    /**
+     * @brief Merges sets of one stage into the sets of the whole program.
+     *
+     * A binding used by several stages is kept once with the stage flags combined.
+     * `createInfo` of every set in `out` points to its own `bindings` after the call.
+     */
+    void merge_descriptor_sets(std::vector<descriptor_set_layout_data>& out, const std::vector<descriptor_set_layout_data>& sets) {
+        for (const auto& set : sets) {
+            descriptor_set_layout_data* layoutp = nullptr;
+
+            for (auto& outSet : out) {
+                if (outSet.setNumber == set.setNumber) {
+                    layoutp = &outSet;
+                    break;
+                }
+            }
+            if (layoutp == nullptr) {
+                out.emplace_back(descriptor_set_layout_data{});
+                layoutp = &out.back();
+                layoutp->setNumber = set.setNumber;
+            }
+            descriptor_set_layout_data& layout = *layoutp;
+
+            for (size_t iB = 0; iB < set.bindings.size(); ++iB) {
+                bool merged = false;
+                for (auto& binding : layout.bindings) {
+                    if (binding.binding == set.bindings[iB].binding) {
+                        binding.stageFlags |= set.bindings[iB].stageFlags;
+                        merged = true;
+                        break;
+                    }
+                }
+                if (!merged) {
+                    layout.bindings.emplace_back(set.bindings[iB]);
+                    layout.bufferSizes.emplace_back(set.bufferSizes[iB]);
+                }
+            }
+        }
+        for (auto& layout : out) {
+            layout.createInfo = {};
             layout.createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            layout.createInfo.bindingCount = layout.bindings.size();
+            layout.createInfo.bindingCount = static_cast<uint32_t>(layout.bindings.size());
             layout.createInfo.pBindings = layout.bindings.data();
         }
     }
+    uint64_t spirv_code_hash(size_t codeSize, const uint32_t* code) { // in bytes
+        return hash_bytes(code, codeSize);
+    }
+
+    /**
+     * @brief Header of `wienderer::get_cache_data` blob, followed by the reflection cache and the pipeline cache data.
+     *
+     * The shader packer writes the same blob (without pipeline data) into shader archives.
+     */
+    struct cache_data_header {
+        static constexpr uint32_t wienderMagic = 0x48434357; // "WCCH"
+
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t reflectionSize;
+        uint64_t pipelineCacheSize;
+    };
+    /**
+     * @brief In-memory cache of `shader_stage_reflection` keyed by the SPIR-V content hash.
+     *
+     * Creating a shader from already seen SPIR-V takes the cached result and skips spirv-reflect entirely.
+     */
+    struct shader_reflection_cache {
+        private:
+        struct entry {
+            uint64_t codeSize;
+            shader_stage_reflection reflection;
+        };
+        static constexpr uint32_t serializedMagic = 0x43525357; // "WSRC"
+        static constexpr uint32_t serializedVersion = 2;
+
+        std::unordered_map<uint64_t, entry> entries_;
+
+        public:
+        const shader_stage_reflection& get(size_t codeSize, const uint32_t* code, uint64_t knownHash = 0) { // in bytes
+            const uint64_t hash = knownHash != 0 ? knownHash : spirv_code_hash(codeSize, code);
+
+            auto found = entries_.find(hash);
+            if ((found != entries_.end()) && (found->second.codeSize == codeSize))
+                return found->second.reflection;
+
+            entry newEntry{ codeSize, {} };
+            reflect_shader_stage(newEntry.reflection, codeSize, code);
+            return (entries_[hash] = std::move(newEntry)).reflection;
+        }
+        std::size_t size() const noexcept {
+            return entries_.size();
+        }
+        void clear() noexcept {
+            entries_.clear();
+        }
+
+        public:
+        void serialize(std::vector<char>& out) const {
+            write(out, serializedMagic);
+            write(out, serializedVersion);
+            write(out, static_cast<uint64_t>(entries_.size()));
+            for (const auto& hashed : entries_) {
+                const shader_stage_reflection& reflection = hashed.second.reflection;
+                write(out, hashed.first);
+                write(out, hashed.second.codeSize);
+
+                write(out, static_cast<uint32_t>(reflection.descriptorSets.size()));
+                for (const auto& set : reflection.descriptorSets) {
+                    write(out, set.setNumber);
+                    write(out, static_cast<uint32_t>(set.bindings.size()));
+                    for (size_t i = 0; i < set.bindings.size(); ++i) {
+                        write(out, set.bindings[i].binding);
+                        write(out, static_cast<uint32_t>(set.bindings[i].descriptorType));
+                        write(out, set.bindings[i].descriptorCount);
+                        write(out, static_cast<uint32_t>(set.bindings[i].stageFlags));
+                        write(out, static_cast<uint64_t>(set.bufferSizes[i]));
+                    }
+                }
+
+                write(out, static_cast<uint32_t>(reflection.specializationConstantIds.size()));
+                for (uint32_t id : reflection.specializationConstantIds)
+                    write(out, id);
+
+                write(out, static_cast<uint32_t>(reflection.pushConstantRange.stageFlags));
+                write(out, reflection.pushConstantRange.offset);
+                write(out, reflection.pushConstantRange.size);
+            }
+        }
+        /**
+         * @brief Adds entries from `serialize` output.
+         * @return false if data is malformed or was written by another version, the cache is left untouched then.
+         */
+        bool deserialize(const char* data, size_t size) {
+            const char* end = data + size;
+            uint32_t magic = 0, version = 0;
+            uint64_t entryCount = 0;
+            if (!read(data, end, magic) || !read(data, end, version) || !read(data, end, entryCount))
+                return false;
+            if ((magic != serializedMagic) || (version != serializedVersion))
+                return false;
+
+            std::unordered_map<uint64_t, entry> loaded;
+            for (uint64_t iE = 0; iE < entryCount; ++iE) {
+                uint64_t hash = 0;
+                entry newEntry{};
+                uint32_t setCount = 0;
+                if (!read(data, end, hash) || !read(data, end, newEntry.codeSize) || !read(data, end, setCount))
+                    return false;
+
+                for (uint32_t iS = 0; iS < setCount; ++iS) {
+                    descriptor_set_layout_data set{};
+                    uint32_t bindingCount = 0;
+                    if (!read(data, end, set.setNumber) || !read(data, end, bindingCount))
+                        return false;
+                    for (uint32_t iB = 0; iB < bindingCount; ++iB) {
+                        VkDescriptorSetLayoutBinding binding{};
+                        uint32_t descriptorType = 0, stageFlags = 0;
+                        uint64_t bufferSize = 0;
+                        if (!read(data, end, binding.binding) || !read(data, end, descriptorType) || !read(data, end, binding.descriptorCount) ||
+                            !read(data, end, stageFlags) || !read(data, end, bufferSize))
+                            return false;
+                        binding.descriptorType = static_cast<VkDescriptorType>(descriptorType);
+                        binding.stageFlags = static_cast<VkShaderStageFlags>(stageFlags);
+                        set.bindings.emplace_back(binding);
+                        set.bufferSizes.emplace_back(static_cast<size_t>(bufferSize));
+                    }
+                    newEntry.reflection.descriptorSets.emplace_back(std::move(set));
+                }
+
+                uint32_t idCount = 0;
+                if (!read(data, end, idCount))
+                    return false;
+                for (uint32_t iI = 0; iI < idCount; ++iI) {
+                    uint32_t id = 0;
+                    if (!read(data, end, id))
+                        return false;
+                    newEntry.reflection.specializationConstantIds.emplace_back(id);
+                }
+
+                uint32_t pushConstantStageFlags = 0;
+                if (!read(data, end, pushConstantStageFlags) || !read(data, end, newEntry.reflection.pushConstantRange.offset) || !read(data, end, newEntry.reflection.pushConstantRange.size))
+                    return false;
+                newEntry.reflection.pushConstantRange.stageFlags = static_cast<VkShaderStageFlags>(pushConstantStageFlags);
+                loaded[hash] = std::move(newEntry);
+            }
+
+            for (auto& hashed : loaded)
+                entries_[hashed.first] = std::move(hashed.second);
+            return true;
+        }
+
+        private:
+        template<class T>
+        static void write(std::vector<char>& out, const T& value) {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            out.insert(out.end(), bytes, bytes + sizeof(T));
+        }
+        template<class T>
+        static bool read(const char*& data, const char* end, T& value) {
+            if (static_cast<size_t>(end - data) < sizeof(T))
+                return false;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return true;
+        }
+    };
 } // namespace wiender
 #endif // WIENDER_SPV_RENFLECTION_SUPPORT_HPP_
\ No newline at end of file
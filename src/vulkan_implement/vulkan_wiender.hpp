@@ -3,6 +3,11 @@
 #include <pickmelib/reado.hpp>
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <unordered_map>
+#include <deque>
+#include <algorithm>
+#include <cstring>
+#include <memory>
 
 #include "../wiender_implement_core.hpp"
 #include "spirv_reflection_support.hpp"
@@ -35,6 +40,17 @@
 
 #define WIENDER_UNIFORM_BUFFER_MAX_COUNT WIENDER_SMALL_ARRAY_SIZE
 #define WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT WIENDER_SMALL_ARRAY_SIZE
+#define WIENDER_FRAMES_IN_FLIGHT 2
+#define WIENDER_HEADLESS_IMAGE_COUNT (WIENDER_FRAMES_IN_FLIGHT + 1) // ring of a headless wienderer
+#define WIENDER_BINDLESS_TEXTURE_SET 4 // sets before it are left to shaders
+#define WIENDER_DESCRIPTOR_SET_MAX_COUNT (WIENDER_BINDLESS_TEXTURE_SET + 1)
+#define WIENDER_BINDLESS_TEXTURE_MAX_COUNT 4096
+#define WIENDER_PUSH_CONSTANTS_MAX_SIZE 128 // minimal maxPushConstantsSize guaranteed by vulkan
+#define WIENDER_VERTEX_BINDING_MAX_COUNT WIENDER_SMALL_ARRAY_SIZE
+#define WIENDER_DESCRIPTOR_POOL_MIN_SET_COUNT 64 // sets of the first shared pool, every next pool is twice bigger
+#define WIENDER_UNIFORM_ARENA_CHUNK_SIZE (256 * 1024)
+#define WIENDER_READBACK_RING_SIZE (16 * 1024 * 1024) // first readback ring, every next one is twice bigger
+#define WIENDER_READBACK_ALIGNMENT 16 // of readback slices, fits texel sizes and copy offset rules
 // #define WIENDER_COMMAND_MAX_COUNT WIENDER_HUGE_ARRAY_SIZE
 
 #define WIENDER_VK_INVALID_FAMILY_INDEX ~0UL
@@ -55,8 +71,11 @@ namespace wiender {
  // constants
     namespace {
         const struct {
-            const char* deviceExtensions[2] { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME };
+            const char* deviceExtensions[2] { VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME }; // swapchain goes first, headless skips it
+            const char* pipelineLibraryExtensions[2] { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME }; // optional
+            const char* drawIndirectCountExtensions[1] { VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME }; // optional
             const char* validationLayers[1] { "VK_LAYER_KHRONOS_validation" };
+            const char* headlessInstanceExtensions[1] { "VK_EXT_debug_utils" };
 #ifdef _WIN32
             const char* instanceExtensions[3] = { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WIN32_SURFACE_EXTENSION_NAME, "VK_EXT_debug_utils" };
 #elif defined(__linux__)
@@ -64,6 +83,8 @@ namespace wiender {
             const char* instanceExtensions[3] = { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME, "VK_EXT_debug_utils" };
 #   elif defined(USE_X11)
             const char* instanceExtensions[3] = { VK_KHR_SURFACE_EXTENSION_NAME, VK_KHR_XLIB_SURFACE_EXTENSION_NAME, "VK_EXT_debug_utils" };
+#   else
+            const char* instanceExtensions[2] = { VK_KHR_SURFACE_EXTENSION_NAME, "VK_EXT_debug_utils" }; // no window system, headless only
 #   endif // USE_WAYLAND
 #elif defined(__APPLE__)
             const char* instanceExtensions[3] = { VK_KHR_SURFACE_EXTENSION_NAME, VK_MVK_MACOS_SURFACE_EXTENSION_NAME, "VK_EXT_debug_utils" };
@@ -88,16 +109,76 @@ namespace wiender {
             case shader::vertex_input_attribute::format::FLOAT_VEC2:    return VK_FORMAT_R32G32_SFLOAT;
             case shader::vertex_input_attribute::format::FLOAT_VEC3:    return VK_FORMAT_R32G32B32_SFLOAT;
             case shader::vertex_input_attribute::format::FLOAT_VEC4:    return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case shader::vertex_input_attribute::format::HALF_SCALAR:   return VK_FORMAT_R16_SFLOAT;
+            case shader::vertex_input_attribute::format::HALF_VEC2:     return VK_FORMAT_R16G16_SFLOAT;
+            case shader::vertex_input_attribute::format::HALF_VEC4:     return VK_FORMAT_R16G16B16A16_SFLOAT;
+            case shader::vertex_input_attribute::format::UNORM8_VEC2:   return VK_FORMAT_R8G8_UNORM;
+            case shader::vertex_input_attribute::format::UNORM8_VEC4:   return VK_FORMAT_R8G8B8A8_UNORM;
+            case shader::vertex_input_attribute::format::SNORM8_VEC2:   return VK_FORMAT_R8G8_SNORM;
+            case shader::vertex_input_attribute::format::SNORM8_VEC4:   return VK_FORMAT_R8G8B8A8_SNORM;
+            case shader::vertex_input_attribute::format::UNORM16_VEC2:  return VK_FORMAT_R16G16_UNORM;
+            case shader::vertex_input_attribute::format::UNORM16_VEC4:  return VK_FORMAT_R16G16B16A16_UNORM;
+            case shader::vertex_input_attribute::format::SNORM16_VEC2:  return VK_FORMAT_R16G16_SNORM;
+            case shader::vertex_input_attribute::format::SNORM16_VEC4:  return VK_FORMAT_R16G16B16A16_SNORM;
+            case shader::vertex_input_attribute::format::UNORM_A2B10G10R10: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+            case shader::vertex_input_attribute::format::UINT8_SCALAR:  return VK_FORMAT_R8_UINT;
+            case shader::vertex_input_attribute::format::UINT8_VEC2:    return VK_FORMAT_R8G8_UINT;
+            case shader::vertex_input_attribute::format::UINT8_VEC4:    return VK_FORMAT_R8G8B8A8_UINT;
+            case shader::vertex_input_attribute::format::UINT16_SCALAR: return VK_FORMAT_R16_UINT;
+            case shader::vertex_input_attribute::format::UINT16_VEC2:   return VK_FORMAT_R16G16_UINT;
+            case shader::vertex_input_attribute::format::UINT16_VEC4:   return VK_FORMAT_R16G16B16A16_UINT;
+            case shader::vertex_input_attribute::format::UINT_SCALAR:   return VK_FORMAT_R32_UINT;
+            case shader::vertex_input_attribute::format::UINT_VEC2:     return VK_FORMAT_R32G32_UINT;
+            case shader::vertex_input_attribute::format::UINT_VEC3:     return VK_FORMAT_R32G32B32_UINT;
+            case shader::vertex_input_attribute::format::UINT_VEC4:     return VK_FORMAT_R32G32B32A32_UINT;
+            case shader::vertex_input_attribute::format::INT_SCALAR:    return VK_FORMAT_R32_SINT;
+            case shader::vertex_input_attribute::format::INT_VEC2:      return VK_FORMAT_R32G32_SINT;
+            case shader::vertex_input_attribute::format::INT_VEC3:      return VK_FORMAT_R32G32B32_SINT;
+            case shader::vertex_input_attribute::format::INT_VEC4:      return VK_FORMAT_R32G32B32A32_SINT;
             default: throw std::runtime_error("wiender::shader_vertex_input_attribute_format_to_vk_format unknown vertex input attribute format");
         }
         // unreachable
     }
+    VkVertexInputRate shader_vertex_input_rate_to_vk_vertex_input_rate(shader::vertex_input_binding::input_rate rate) {
+        switch (rate) {
+            case shader::vertex_input_binding::input_rate::PER_VERTEX:      return VK_VERTEX_INPUT_RATE_VERTEX;
+            case shader::vertex_input_binding::input_rate::PER_INSTANCE:    return VK_VERTEX_INPUT_RATE_INSTANCE;
+            default: throw std::runtime_error("wiender::shader_vertex_input_rate_to_vk_vertex_input_rate unknown vertex input rate");
+        }
+        // unreachable
+    }
     size_t sizeof_shader_vertex_input_attribute_format(shader::vertex_input_attribute::format f) {
         switch (f) {
             case shader::vertex_input_attribute::format::FLOAT_SCALAR:  return sizeof(float);
             case shader::vertex_input_attribute::format::FLOAT_VEC2:    return sizeof(float) * 2;
             case shader::vertex_input_attribute::format::FLOAT_VEC3:    return sizeof(float) * 3;
             case shader::vertex_input_attribute::format::FLOAT_VEC4:    return sizeof(float) * 4;
+            case shader::vertex_input_attribute::format::HALF_SCALAR:   return sizeof(uint16_t);
+            case shader::vertex_input_attribute::format::HALF_VEC2:     return sizeof(uint16_t) * 2;
+            case shader::vertex_input_attribute::format::HALF_VEC4:     return sizeof(uint16_t) * 4;
+            case shader::vertex_input_attribute::format::UNORM8_VEC2:   return sizeof(uint8_t) * 2;
+            case shader::vertex_input_attribute::format::UNORM8_VEC4:   return sizeof(uint8_t) * 4;
+            case shader::vertex_input_attribute::format::SNORM8_VEC2:   return sizeof(int8_t) * 2;
+            case shader::vertex_input_attribute::format::SNORM8_VEC4:   return sizeof(int8_t) * 4;
+            case shader::vertex_input_attribute::format::UNORM16_VEC2:  return sizeof(uint16_t) * 2;
+            case shader::vertex_input_attribute::format::UNORM16_VEC4:  return sizeof(uint16_t) * 4;
+            case shader::vertex_input_attribute::format::SNORM16_VEC2:  return sizeof(int16_t) * 2;
+            case shader::vertex_input_attribute::format::SNORM16_VEC4:  return sizeof(int16_t) * 4;
+            case shader::vertex_input_attribute::format::UNORM_A2B10G10R10: return sizeof(uint32_t);
+            case shader::vertex_input_attribute::format::UINT8_SCALAR:  return sizeof(uint8_t);
+            case shader::vertex_input_attribute::format::UINT8_VEC2:    return sizeof(uint8_t) * 2;
+            case shader::vertex_input_attribute::format::UINT8_VEC4:    return sizeof(uint8_t) * 4;
+            case shader::vertex_input_attribute::format::UINT16_SCALAR: return sizeof(uint16_t);
+            case shader::vertex_input_attribute::format::UINT16_VEC2:   return sizeof(uint16_t) * 2;
+            case shader::vertex_input_attribute::format::UINT16_VEC4:   return sizeof(uint16_t) * 4;
+            case shader::vertex_input_attribute::format::UINT_SCALAR:   return sizeof(uint32_t);
+            case shader::vertex_input_attribute::format::UINT_VEC2:     return sizeof(uint32_t) * 2;
+            case shader::vertex_input_attribute::format::UINT_VEC3:     return sizeof(uint32_t) * 3;
+            case shader::vertex_input_attribute::format::UINT_VEC4:     return sizeof(uint32_t) * 4;
+            case shader::vertex_input_attribute::format::INT_SCALAR:    return sizeof(int32_t);
+            case shader::vertex_input_attribute::format::INT_VEC2:      return sizeof(int32_t) * 2;
+            case shader::vertex_input_attribute::format::INT_VEC3:      return sizeof(int32_t) * 3;
+            case shader::vertex_input_attribute::format::INT_VEC4:      return sizeof(int32_t) * 4;
             default: throw std::runtime_error("wiender::sizeof_shader_vertex_input_attribute_format unknown vertex input attribute format");
         }
         // unreachable
@@ -139,15 +220,139 @@ namespace wiender {
         }
         // unreachable
     }
+    uint32_t sizeof_vk_color_format(VkFormat f) {
+        switch (f) {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_A2B10G10R10_UNORM_PACK32:    return 4;
+            case VK_FORMAT_R16G16B16A16_SFLOAT:         return 8;
+            default: throw std::runtime_error("wiender::sizeof_vk_color_format unsupported color format");
+        }
+        // unreachable
+    }
 
     struct binded_buffer_state {
         VkBuffer buffer;
+        VkDeviceSize offset;
+        uint32_t binding;       // for vertex buffers only
+        VkIndexType indexType;  // for index buffers only
+    };
+    struct fill_buffer_data {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        uint32_t value;
+    };
+    struct indirect_draw_data {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkBuffer countBuffer;       // 0 for a fixed draw count
+        VkDeviceSize countOffset;
+        uint32_t drawCount;         // max draw count if countBuffer is set
+        uint32_t stride;
+        bool indexed;
+    };
+    /**
+     * @brief Descriptor sets bound for a shader, indexed by set number and then by swapchain image.
+     *
+     * Pipeline layouts compatible for set n (same push constant ranges and identically defined
+     * layouts of sets [0, n]) have equal `compatibilityHashes[n]`, so the recorder keeps such sets bound.
+     */
+    struct descriptor_sets_state {
+        VkDescriptorSet sets[WIENDER_DESCRIPTOR_SET_MAX_COUNT][WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT]; // null for set numbers without bindings
+        uint64_t compatibilityHashes[WIENDER_DESCRIPTOR_SET_MAX_COUNT];
+        uint32_t setCount;
     };
     struct active_shader_state {
         VkPipeline pipeline;
         VkPipelineLayout layout;
+        VkRenderPass renderPass;                        // 0 for compute shaders
+        const descriptor_sets_state* descriptorSets;    // owned by the shader
+        VkPipelineBindPoint bindPoint;
+        bool depthAttachment;                           // render pass uses the shared depth attachment
+        VkFormat targetFormat;                          // VK_FORMAT_UNDEFINED if the shader draws into the window
+        VkSampleCountFlagBits targetSamples;            // render target sample count, see `targetFormat`
+        uint32_t subpass;                               // of the render pass
+        uint32_t chainSubpassCount;                     // subpasses of the post-process chain the shader draws in, 0 outside of chains
+    };
+    /**
+     * @brief What `vulkan_wienderer::begin_render` needs from a render target.
+     */
+    struct render_target_state {
+        VkFramebuffer framebuffer;
+        VkExtent2D extent;
+        VkFormat format;
+        VkSampleCountFlagBits samples;
+    };
+    /**
+     * @brief What `vulkan_wienderer::begin_render_chain` and shaders of a chain need from a post-process chain.
+     */
+    struct postprocess_chain_state {
         VkRenderPass renderPass;
-        VkDescriptorSet descriptorSet;
+        const VkFramebuffer* framebuffers;  // by swapchain image
+        VkImageView intermediateViews[2];   // subpass n > 0 reads intermediateViews[(n - 1) % 2]
+        VkFormat intermediateFormat;
+        uint32_t subpassCount;              // scene subpass included
+        uint32_t attachmentCount;           // window, intermediates, depth if used
+        bool depthAttachment;               // of the scene subpass
+    };
+    /**
+     * @brief Uniform blocks of a shader, versioned per swapchain image.
+     *
+     * User writes the shadow copy at any time, `vulkan_wienderer::execute` copies it
+     * into the slot of the acquired image after the previous frame using this image is finished.
+     */
+    struct frame_uniform_storage {
+        const char* shadowMemory;
+        char* mappedMemory;         // slot i starts at i * slotSize
+        VkDeviceSize slotSize;      // aligned to minUniformBufferOffsetAlignment
+        VkDeviceSize dataSize;      // bytes copied per frame
+    };
+    /**
+     * @brief Part of a host-visible uniform buffer shared by many descriptor sets, see `vulkan_wienderer::allocate_uniform_slice`.
+     */
+    struct uniform_slice {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        char* mappedMemory;     // points to offset
+        uint32_t chunkIndex;
+    };
+    /**
+     * @brief Part of a host-visible readback ring, see `vulkan_wienderer::allocate_readback_slice`.
+     */
+    struct readback_slice {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+        char* mappedMemory;     // points to offset
+        uint32_t ringIndex;
+    };
+    /**
+     * @brief Descriptor writes of a set waiting for `vulkan_wienderer::execute`.
+     *
+     * `data` holds update template data for every swapchain image. Writes go to every copy and mark the images dirty,
+     * an image gets one templated update when it is acquired and its previous frame is finished.
+     */
+    struct frame_descriptor_writes {
+        VkDescriptorUpdateTemplate updateTemplate;
+        const VkDescriptorSet* sets;    // one per swapchain image
+        const char* data;               // copy i starts at i * dataStride
+        size_t dataStride;
+        uint32_t dirtyImages;           // bit per swapchain image
+    };
+    struct push_constants_state {
+        VkPipelineLayout layout;
+        VkPushConstantRange range;
+    };
+    struct push_constants_data {
+        VkPipelineLayout layout;
+        VkShaderStageFlags stageFlags;
+        uint32_t offset;
+        uint32_t size;
+        uint32_t bytesOffset;   // of the payload in `pushConstantBytes` of the command list
     };
     struct vulkan_image {
         VkImage image;
@@ -159,60 +364,199 @@ namespace wiender {
         wiender_assert(vkr == VK_SUCCESS, strv);
     }
 
+    /**
+     * @brief Common part of buffer implementations, lets descriptor sets reference any of them.
+     */
+    struct vulkan_buffer : public buffer {
+        public:
+        WIENDER_NODISCARD virtual VkBuffer get_buffer() const noexcept = 0;
+        WIENDER_NODISCARD virtual std::size_t get_size() const noexcept = 0;
+        WIENDER_NODISCARD virtual VkBufferUsageFlags get_usage() const noexcept = 0;
+    };
+    /**
+     * @brief Common part of texture implementations, lets descriptor sets sample any of them.
+     *
+     * It is not a `texture` itself: render targets are textures through `render_target`, see `get_sampled_image`.
+     */
+    struct vulkan_sampled_image {
+        public:
+        virtual ~vulkan_sampled_image() {}
+
+        public:
+        WIENDER_NODISCARD virtual VkSampler get_sampler() const noexcept = 0;
+        WIENDER_NODISCARD virtual VkImageView get_view() const noexcept = 0;
+        /**
+         * @brief The image, kept in `get_layout()` between command buffers.
+         */
+        WIENDER_NODISCARD virtual VkImage get_image() const noexcept = 0;
+        WIENDER_NODISCARD virtual VkFormat get_format() const noexcept = 0;
+        /**
+         * @brief Layout render passes and uploads leave the image in.
+         */
+        WIENDER_NODISCARD virtual VkImageLayout get_layout() const noexcept = 0;
+        /**
+         * @brief Whether texels are defined, render targets get them from the first render pass recorded into them.
+         */
+        WIENDER_NODISCARD virtual bool has_content() const noexcept = 0;
+    };
+    WIENDER_NODISCARD const vulkan_sampled_image& get_sampled_image(const texture* tetr) {
+        const vulkan_sampled_image* result = dynamic_cast<const vulkan_sampled_image*>(tetr);
+        wiender_assert(result != nullptr, "wiender::get_sampled_image texture is not created by the vulkan backend");
+        return *result;
+    }
+
     struct vulkan_wienderer;
-    WIENDER_NODISCARD std::unique_ptr<buffer> create_gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage);
-    WIENDER_NODISCARD std::unique_ptr<buffer> create_cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage);
+    struct vulkan_context;
+    struct vulkan_descriptor_set;
+    WIENDER_NODISCARD std::unique_ptr<wienderer> create_vulkan_wienderer(std::shared_ptr<vulkan_context> context, const window_handle* whandle, VkExtent2D headlessExtent);
+    WIENDER_NODISCARD std::unique_ptr<buffer> create_gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+    WIENDER_NODISCARD std::unique_ptr<buffer> create_cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
     WIENDER_NODISCARD std::unique_ptr<shader> create_vulkan_shader(vulkan_wienderer* owner, const shader::create_info& createInfo);
+    WIENDER_NODISCARD push_constants_state get_vulkan_shader_push_constants_state(const shader* shad);
     WIENDER_NODISCARD std::unique_ptr<texture> create_image_texture(vulkan_wienderer* owner, const texture::create_info& createInfo);
-    
-    struct vulkan_wienderer final : public wienderer {
-        private:
-        struct queue_family_indices {
-            public:
-            union {
-                struct {
-                    uint32_t graphicsFamily;
-                    uint32_t presentFamily;
-                };
-                uint32_t indeces[2]{WIENDER_VK_INVALID_FAMILY_INDEX, WIENDER_VK_INVALID_FAMILY_INDEX};
+    WIENDER_NODISCARD std::unique_ptr<material> create_vulkan_material(vulkan_wienderer* owner, const shader* shad);
+    WIENDER_NODISCARD std::unique_ptr<render_target> create_vulkan_render_target(vulkan_wienderer* owner, const texture::extent& targetExtent, render_target::format targetFormat, VkFormat format, VkSampleCountFlagBits samples);
+    WIENDER_NODISCARD render_target_state get_vulkan_render_target_state(render_target* target, bool withDepth);
+    WIENDER_NODISCARD std::unique_ptr<postprocess_chain> create_vulkan_postprocess_chain(vulkan_wienderer* owner, const postprocess_chain::description& chainDescription, VkFormat intermediateFormat);
+    WIENDER_NODISCARD const postprocess_chain_state& get_vulkan_postprocess_chain_state(const postprocess_chain* chain);
+    WIENDER_NODISCARD std::unique_ptr<readback_ticket> create_vulkan_readback_ticket(vulkan_wienderer* owner, VkCommandBuffer commandBuffer, VkFence fence, const readback_slice& slice, std::size_t size, std::size_t rowPitch);
+
+    struct queue_family_indices {
+        public:
+        union {
+            struct {
+                uint32_t graphicsFamily;
+                uint32_t presentFamily;
             };
-            uint32_t falimiesCount;
-
-            bool is_complete() const noexcept {
-                return (graphicsFamily != WIENDER_VK_INVALID_FAMILY_INDEX) && (presentFamily != WIENDER_VK_INVALID_FAMILY_INDEX);
-            }
+            uint32_t indeces[2]{WIENDER_VK_INVALID_FAMILY_INDEX, WIENDER_VK_INVALID_FAMILY_INDEX};
         };
-        struct physical_device_info {
-            public:
-            VkPhysicalDevice device;
-            VkPhysicalDeviceFeatures2 features;
-            VkPhysicalDeviceProperties2 properties;
-            queue_family_indices queueIndeces;
+        uint32_t falimiesCount;
 
-            VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures;
+        bool is_complete() const noexcept {
+            return (graphicsFamily != WIENDER_VK_INVALID_FAMILY_INDEX) && (presentFamily != WIENDER_VK_INVALID_FAMILY_INDEX);
+        }
+    };
+    struct physical_device_info {
+        public:
+        VkPhysicalDevice device;
+        VkPhysicalDeviceFeatures2 features;
+        VkPhysicalDeviceProperties2 properties;
+        queue_family_indices queueIndeces;
 
-            public:
-            operator const VkPhysicalDevice& () const noexcept{
-                return device;
-            }
-            operator VkPhysicalDevice& () noexcept {
-                return device;
-            }
-        };
-        struct logical_device_info {
-            public:
-            VkDevice device;
-            VkQueue graphicsQueue;
-            VkQueue presentQueue;
+        VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures;
+        VkPhysicalDeviceDescriptorIndexingProperties indexingProperties;
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures;
+        bool drawIndirectCount; // VK_KHR_draw_indirect_count
 
-            public:
-            operator const VkDevice& () const {
-                return device;
-            }
-            operator VkDevice& () {
-                return device;
+        public:
+        operator const VkPhysicalDevice& () const noexcept{
+            return device;
+        }
+        operator VkPhysicalDevice& () noexcept {
+            return device;
+        }
+    };
+    struct logical_device_info {
+        public:
+        VkDevice device;
+        VkQueue graphicsQueue;
+        VkQueue presentQueue;
+        PFN_vkCmdDrawIndirectCountKHR cmdDrawIndirectCount;                 // null without VK_KHR_draw_indirect_count
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount;   // null without VK_KHR_draw_indirect_count
+
+        public:
+        operator const VkDevice& () const {
+            return device;
+        }
+        operator VkDevice& () {
+            return device;
+        }
+    };
+    struct bindless_texture_table {
+        VkDescriptorSetLayout layout;
+        VkDescriptorPool pool;
+        VkDescriptorSet set;
+        std::vector<uint32_t> freeIndices;
+        uint32_t indexCount;    // indices ever allocated
+    };
+    /**
+     * @brief Device objects shared by every vulkan_wienderer created from one context, see `wiender::context`.
+     *
+     * Filled by the first wienderer, each object when it is first needed, and destroyed with the last one.
+     */
+    struct vulkan_context final : public context, public std::enable_shared_from_this<vulkan_context> {
+        public:
+        bool headless;  // created without window system extensions, only headless wienderers can use it
+        VkInstance instance;
+        physical_device_info pdevice;
+        logical_device_info ldevice;
+        VkPipelineCache pipelineCache;
+        std::unordered_map<uint64_t, VkPipeline> pipelineLibraries;
+        shader_reflection_cache reflectionCache;
+        vulkan_image defaultTextureImage;
+        VkSampler defaultSampler;
+        bindless_texture_table bindlessTextures;
+        vulkan_wienderer* recorder; // between its begin_record and end_record, binds of shared buffers are recorded into it
+
+        public:
+        explicit vulkan_context(bool headless)
+                        :   headless(headless),
+                            instance{},
+                            pdevice{},
+                            ldevice{},
+                            pipelineCache{},
+                            pipelineLibraries{},
+                            reflectionCache{},
+                            defaultTextureImage{},
+                            defaultSampler{},
+                            bindlessTextures{},
+                            recorder(nullptr) {
+
+        }
+        vulkan_context(const vulkan_context&) = delete;
+        vulkan_context& operator=(const vulkan_context&) = delete;
+        ~vulkan_context() override {
+            if (ldevice != 0) {
+                vkDeviceWaitIdle(ldevice);
+
+                if (bindlessTextures.pool != 0)
+                    vkDestroyDescriptorPool(ldevice, bindlessTextures.pool, WIENDER_ALLOCATOR_NAME);
+                if (bindlessTextures.layout != 0)
+                    vkDestroyDescriptorSetLayout(ldevice, bindlessTextures.layout, WIENDER_ALLOCATOR_NAME);
+
+                if (defaultSampler != 0)
+                    vkDestroySampler(ldevice, defaultSampler, WIENDER_ALLOCATOR_NAME);
+                if (defaultTextureImage.view != 0)
+                    vkDestroyImageView(ldevice, defaultTextureImage.view, WIENDER_ALLOCATOR_NAME);
+                if (defaultTextureImage.image != 0)
+                    vkDestroyImage(ldevice, defaultTextureImage.image, WIENDER_ALLOCATOR_NAME);
+                if (defaultTextureImage.memory != 0)
+                    vkFreeMemory(ldevice, defaultTextureImage.memory, WIENDER_ALLOCATOR_NAME);
+
+                for (const auto& library : pipelineLibraries)
+                    vkDestroyPipeline(ldevice, library.second, WIENDER_ALLOCATOR_NAME);
+
+                if (pipelineCache != 0)
+                    vkDestroyPipelineCache(ldevice, pipelineCache, WIENDER_ALLOCATOR_NAME);
+
+                vkDestroyDevice(ldevice, WIENDER_ALLOCATOR_NAME);
             }
-        };
+            if (instance != 0)
+                vkDestroyInstance(instance, WIENDER_ALLOCATOR_NAME);
+        }
+
+        public:
+        WIENDER_NODISCARD std::unique_ptr<surface_renderer> create_surface_renderer(const window_handle& whandle) override {
+            wiender_assert(!headless, "wiender::vulkan_context::create_surface_renderer a headless context cannot present to windows");
+            return create_vulkan_wienderer(shared_from_this(), &whandle, VkExtent2D{});
+        }
+        WIENDER_NODISCARD std::unique_ptr<wienderer> create_headless_renderer(uint32_t width, uint32_t height) override {
+            return create_vulkan_wienderer(shared_from_this(), nullptr, VkExtent2D{ width, height });
+        }
+    };
+
+    struct vulkan_wienderer final : public wienderer {
+        private:
         struct swapchain_support_info {
             uint32_t imageCount;
             VkSurfaceFormatKHR imageFormat;
@@ -225,13 +569,55 @@ namespace wiender {
             VkImage image;
             VkImageView view;
             VkFramebuffer framebuffer;
+            VkFramebuffer depthFramebuffer; // 0 until a shader uses depth
+            VkDeviceMemory memory;          // headless ring only, swapchain images aren't owned
         };
         using swapchain_images = wcs::inplace_vector<swapchain_image, WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT>;
         using command_buffers = wcs::inplace_vector<VkCommandBuffer, WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT>;
 
+        struct memory_range {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+        };
+        struct uniform_arena_chunk {
+            VkBuffer buffer;
+            VkDeviceMemory memory;
+            char* mappedMemory;
+            std::vector<memory_range> freeRanges; // sorted by offset
+        };
+        struct readback_range {
+            VkDeviceSize offset;
+            VkDeviceSize size;
+            bool released;
+        };
+        struct readback_ring {
+            VkBuffer buffer;
+            VkDeviceMemory memory;
+            char* mappedMemory;
+            VkDeviceSize size;
+            VkDeviceSize head;                  // next allocation starts here or wraps to 0
+            std::deque<readback_range> ranges;  // allocation order, the oldest one is the ring tail
+        };
+        struct bound_descriptor_set {
+            VkDescriptorSet set;            // set of the first swapchain image identifies the whole group
+            uint64_t compatibilityHash;     // see descriptor_sets_state
+        };
+        /**
+         * @brief What recorded command buffers have bound. They are recorded in lockstep, so the state is the same for all of them.
+         */
+        struct recorder_state {
+            VkPipeline pipelines[2];                                                // graphics, compute
+            bound_descriptor_set descriptorSets[2][WIENDER_DESCRIPTOR_SET_MAX_COUNT];  // graphics, compute
+            binded_buffer_state vertexBuffers[WIENDER_VERTEX_BINDING_MAX_COUNT];
+            binded_buffer_state indexBuffer;
+            VkExtent2D viewport;                                                    // viewport and scissor extent, zero before the first render pass
+            uint32_t subpass;                                                       // of the current render pass
+            uint32_t subpassCount;                                                  // of the current post-process chain render pass, 0 outside of it
+        };
         struct sync_object {
             VkFence fence;
-            VkSemaphore semaphore;
+            VkSemaphore semaphore;                  // image acquired
+            VkSemaphore renderFinishedSemaphore;    // waited by present
         };
         enum struct render_command_type {
             SET_SHADER,             // data: [ activeShaderState ]
@@ -240,9 +626,15 @@ namespace wiender {
             BEGIN_RECORD,           // data: null
             RECORD_UPDATE_SCISSOR,  // data: null
             RECORD_UPDATE_VIEWPORT, // data: null
-            RECORD_BEGIN_RENDER,    // data: null
+            RECORD_BEGIN_RENDER,    // data: [ renderTarget ] (null for the window)
+            RECORD_BEGIN_RENDER_CHAIN, // data: [ postprocessChain ]
+            RECORD_NEXT_SUBPASS,    // data: null
             RECORD_DRAW_VERTECES,   // data: [ drawData ]
             RECORD_DRAW_INDEXED,    // data: [ drawData ]
+            RECORD_DRAW_INDIRECT,   // data: [ indirectDrawData ]
+            RECORD_DISPATCH,        // data: [ drawData ] (group counts)
+            RECORD_FILL_BUFFER,     // data: [ fillBufferData ]
+            RECORD_PUSH_CONSTANTS,  // data: [ pushConstantsData ]
             RECORD_END_RENDER,      // data: null
             END_RECORD,             // data: null
         };
@@ -251,19 +643,36 @@ namespace wiender {
             union {
                 binded_buffer_state bindedBufferState;
                 active_shader_state activeShaderState;
+                push_constants_data pushConstantsData;
+                indirect_draw_data indirectDrawData;
+                fill_buffer_data fillBufferData;
+                render_target* renderTarget;
+                postprocess_chain* postprocessChain;
                 struct {
                     uint32_t count;
                     uint32_t first;
                     uint32_t instanceCount;
+                    int32_t vertexOffset;   // indexed draws only
                 } drawData;
             } data;
         };
-        using render_commands = std::vector<render_command>;// wcs::inplace_vector<render_command, WIENDER_COMMAND_MAX_COUNT>;
+        /**
+         * @brief Recorded commands, push constant payloads are kept aside so every command stays small.
+         */
+        struct render_commands {
+            std::vector<render_command> commands;           // wcs::inplace_vector<render_command, WIENDER_COMMAND_MAX_COUNT>;
+            std::vector<unsigned char> pushConstantBytes;   // payloads of RECORD_PUSH_CONSTANTS commands
+
+            void clear() noexcept {
+                commands.clear();
+                pushConstantBytes.clear();
+            }
+        };
         struct commands_frame : public wiender_commands_frame, render_commands {
-            commands_frame() : wiender_commands_frame{}, render_commands() {
+            commands_frame() : wiender_commands_frame{}, render_commands{} {
 
             }
-            commands_frame(const commands_frame& other) : wiender_commands_frame{}, render_commands(other.begin(), other.end()) {
+            commands_frame(const commands_frame& other) : wiender_commands_frame{}, render_commands(other) {
 
             }
             commands_frame(const render_commands& other) : wiender_commands_frame{}, render_commands(other) {
@@ -273,75 +682,150 @@ namespace wiender {
 
 
         private:
+        std::shared_ptr<vulkan_context> context_;
         bool validationEnable_;
+        bool headless_; // no surface and no swapchain, frames are rendered into a ring of owned images
      // VkAllocationCallbacks allocationCallbacks_;
-        VkInstance instance_;
+        VkInstance instance_;               // copies of the context objects
         physical_device_info pdevice_;
         VkSampleCountFlagBits msaaSamples_;
         logical_device_info ldevice_;
+        VkPipelineCache pipelineCache_;
         VkSurfaceKHR surface_;
         swapchain_support_info swapchainSupportInfo_;
         vulkan_image colorRenderTarget_;
         VkRenderPass defaultRenderPass_;
+        VkFormat depthFormat_;
+        vulkan_image depthRenderTarget_;    // shared by every shader with depth, created on first use
+        VkRenderPass depthRenderPass_;      // depth framebuffers are created with it
         VkSwapchainKHR swapchain_;
         swapchain_images swapchainImages_;
         VkCommandPool commandPool_;
         command_buffers commandBuffers_;
-        sync_object syncObject_;
-        vulkan_image defaultTextureImage_;
-        VkSampler defaultSampler_;
+        sync_object syncObjects_[WIENDER_FRAMES_IN_FLIGHT];
+        VkFence imageFences_[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT]; // fence of the frame last rendered to the image, not owned
+        uint32_t frameIndex_;
+        std::vector<const frame_uniform_storage*> uniformStorages_;
+        std::vector<frame_descriptor_writes*> descriptorWrites_;
+        std::unique_ptr<buffer> defaultStorageBuffer_; // bound to storage buffer bindings until user binds its own
+        VkDescriptorSetLayout emptySetLayout_; // fills unused set numbers of pipeline layouts
+        std::unordered_map<uint64_t, std::weak_ptr<vulkan_descriptor_set>> sharedDescriptorSets_; // frame and pass sets by layout hash
+        std::vector<VkDescriptorPool> descriptorPools_; // shared by every descriptor set, only grows
+        uint32_t descriptorPoolSetCount_;               // set count of the next pool
+        std::vector<uniform_arena_chunk> uniformArena_;
+        std::vector<readback_ring> readbackRings_; // older rings live until their slices are freed, destroyed ones leave reusable slots
+        uint32_t readbackRing_;                     // index of the ring taking new slices
         active_shader_state currentShader_;
-        binded_buffer_state vertexBindedBuffer_;
+        recorder_state boundState_;
+        bind_statistics bindStatistics_; // since the last begin_record
+        binded_buffer_state vertexBindedBuffers_[WIENDER_VERTEX_BINDING_MAX_COUNT]; // by binding
         binded_buffer_state indexBindedBuffer_;
         uint32_t imageIndex_;
+        uint64_t frameCount_; // frames submitted by execute
+        VkQueryPool timestampPool_;     // begin and end of the command buffer of each swapchain image, 0 without timestamp support
+        uint32_t pendingTimestamps_;    // bit per swapchain image submitted with timestamps that aren't read yet
+        double gpuFrameTime_;           // milliseconds of the last finished frame
         render_commands appliedCommands_;
         bool recording_;
 
         public:
-        vulkan_wienderer(const window_handle& whandle) 
-                        :   validationEnable_(true),
+        explicit vulkan_wienderer(const window_handle& whandle) : vulkan_wienderer(std::make_shared<vulkan_context>(false), &whandle, VkExtent2D{}) {}
+        /**
+         * @brief Headless wienderer, renders into WIENDER_HEADLESS_IMAGE_COUNT images of RGBA8 instead of a window.
+         */
+        vulkan_wienderer(uint32_t width, uint32_t height) : vulkan_wienderer(std::make_shared<vulkan_context>(true), nullptr, VkExtent2D{ width, height }) {}
+        /**
+         * @brief Wienderer of a shared context, device objects missing in the context are created and stored in it.
+         *
+         * @param whandle The window, nullptr for a headless wienderer of `headlessExtent`.
+         */
+        vulkan_wienderer(std::shared_ptr<vulkan_context> context, const window_handle* whandle, VkExtent2D headlessExtent)
+                        :   context_(std::move(context)),
+                            validationEnable_(true),
+                            headless_(whandle == nullptr),
                             instance_{},
                             pdevice_{},
                             msaaSamples_{},
                             ldevice_{},
+                            pipelineCache_{},
                             surface_{},
                             swapchainSupportInfo_{},
                             colorRenderTarget_{},
                             defaultRenderPass_{},
+                            depthFormat_(VK_FORMAT_UNDEFINED),
+                            depthRenderTarget_{},
+                            depthRenderPass_{},
                             swapchain_{},
                             swapchainImages_{},
                             commandPool_{},
                             commandBuffers_{},
-                            syncObject_{},
-                            defaultTextureImage_{},
-                            defaultSampler_{},
+                            syncObjects_{},
+                            imageFences_{},
+                            frameIndex_{},
+                            uniformStorages_{},
+                            descriptorWrites_{},
+                            defaultStorageBuffer_{},
+                            emptySetLayout_{},
+                            sharedDescriptorSets_{},
+                            descriptorPools_{},
+                            descriptorPoolSetCount_(WIENDER_DESCRIPTOR_POOL_MIN_SET_COUNT),
+                            uniformArena_{},
+                            readbackRings_{},
+                            readbackRing_{},
                             currentShader_{},
-                            vertexBindedBuffer_{},
+                            boundState_{},
+                            bindStatistics_{},
+                            vertexBindedBuffers_{},
                             indexBindedBuffer_{},
                             imageIndex_{},
+                            frameCount_{},
+                            timestampPool_{},
+                            pendingTimestamps_{},
+                            gpuFrameTime_{},
                             appliedCommands_{},
                             recording_(false) {
 
             try {
-                instance_ = create_vulkan_instance();
+                wiender_assert(context_ != nullptr, "wiender::vulkan_wienderer::vulkan_wienderer context cannot be nullptr");
+                wiender_assert(headless_ || !context_->headless, "wiender::vulkan_wienderer::vulkan_wienderer a headless context cannot present to windows");
 
-                pdevice_ = get_physical_device();
+                if (context_->instance == 0)
+                    context_->instance = create_vulkan_instance();
+                instance_ = context_->instance;
+
+                if (context_->pdevice.device == 0) {
+                    context_->pdevice = get_physical_device();
+                    initialize_device_features(context_->pdevice);
+                }
+                pdevice_ = context_->pdevice;
 
                 msaaSamples_ = get_max_usable_sample_count(VK_SAMPLE_COUNT_4_BIT);
 
-                surface_ = create_platform_spec_surface(whandle);
+                if (!headless_)
+                    surface_ = create_platform_spec_surface(*whandle);
 
-                pdevice_.queueIndeces = create_falimy_indices();
+                if (context_->ldevice.device == 0) {
+                    context_->pdevice.queueIndeces = pdevice_.queueIndeces = create_falimy_indices();
+                    context_->ldevice = create_logical_device();
+                } else if (!headless_) { // the device is chosen by the first surface, later ones have to be presentable from it
+                    VkBool32 presentSupport = VK_FALSE;
+                    vulkan_check(vkGetPhysicalDeviceSurfaceSupportKHR(pdevice_, pdevice_.queueIndeces.presentFamily, surface_, &presentSupport), "wiender::vulkan_wienderer::vulkan_wienderer failed to get surface support");
+                    wiender_assert(presentSupport == VK_TRUE, "wiender::vulkan_wienderer::vulkan_wienderer the context device cannot present to the window");
+                }
+                ldevice_ = context_->ldevice;
 
-                ldevice_ = create_logical_device();
+                if (context_->pipelineCache == 0)
+                    context_->pipelineCache = create_pipeline_cache();
+                pipelineCache_ = context_->pipelineCache;
 
-                swapchainSupportInfo_ = create_swapchain_info();
+                swapchainSupportInfo_ = headless_ ? create_headless_swapchain_info(headlessExtent) : create_swapchain_info();
 
                 colorRenderTarget_ = create_color_render_target();
 
                 defaultRenderPass_ = create_default_render_pass(VK_ATTACHMENT_LOAD_OP_DONT_CARE);
 
-                swapchain_ = create_swapchain();
+                if (!headless_)
+                    swapchain_ = create_swapchain();
 
                 initialize_swapchain_images(swapchainImages_);
 
@@ -349,11 +833,24 @@ namespace wiender {
 
                 allocate_command_buffers(commandBuffers_);
 
-                intitialize_sync_object(syncObject_);
+                if (is_feature_supported(feature::GPU_TIMESTAMPS))
+                    timestampPool_ = create_timestamp_pool();
+
+                for (auto& syncObject : syncObjects_)
+                    intitialize_sync_object(syncObject);
 
-                defaultTextureImage_ = create_default_texture_image();
+                if (context_->defaultTextureImage.image == 0)
+                    context_->defaultTextureImage = create_default_texture_image();
 
-                defaultSampler_ = create_default_texture_sampler();
+                if (context_->defaultSampler == 0)
+                    context_->defaultSampler = create_default_texture_sampler();
+
+                defaultStorageBuffer_ = create_gpu_side_buffer(this, 16, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+                emptySetLayout_ = create_empty_set_layout();
+
+                if (is_feature_supported(feature::BINDLESS_TEXTURES) && (context_->bindlessTextures.set == 0))
+                    initialize_bindless_textures(context_->bindlessTextures);
 
             } catch (...) {
                 accurate_destroy();
@@ -368,10 +865,13 @@ namespace wiender {
 
         public:
         WIENDER_NODISCARD VkSampler get_default_sampler() const noexcept {
-            return defaultSampler_;
+            return context_->defaultSampler;
         }
         WIENDER_NODISCARD const vulkan_image& get_default_texture_image() const noexcept {
-            return defaultTextureImage_;
+            return context_->defaultTextureImage;
+        }
+        WIENDER_NODISCARD VkBuffer get_default_storage_buffer() const noexcept {
+            return static_cast<const vulkan_buffer*>(defaultStorageBuffer_.get())->get_buffer();
         }
         WIENDER_NODISCARD std::unique_ptr<buffer> create_buffer(buffer::type type, std::size_t sizeb) override {
             switch (type) {
@@ -384,6 +884,18 @@ namespace wiender {
                 return create_gpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
             case buffer::type::CPU_SIDE_INDEX :
                 return create_cpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+            case buffer::type::GPU_SIDE_INDEX16 :
+                return create_gpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_INDEX_TYPE_UINT16);
+            case buffer::type::CPU_SIDE_INDEX16 :
+                return create_cpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_INDEX_TYPE_UINT16);
+
+            case buffer::type::GPU_SIDE_STORAGE :
+                return create_gpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+            case buffer::type::CPU_SIDE_STORAGE :
+                return create_cpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+            case buffer::type::INDIRECT :
+                return create_gpu_side_buffer(this, sizeb, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
             default:
                 throw std::runtime_error("wiender::vulkan_wienderer::create_buffer unknown buffer type");
@@ -396,13 +908,38 @@ namespace wiender {
         WIENDER_NODISCARD std::unique_ptr<texture> create_texture(const texture::create_info& createInfo) override {
             return create_image_texture(this, createInfo);
         }
-        WIENDER_NODISCARD std::unique_ptr<texture> get_postproc_texture() override {
-            return nullptr;
+        WIENDER_NODISCARD std::unique_ptr<material> create_material(const shader* shad) override {
+            return create_vulkan_material(this, shad);
+        }
+        WIENDER_NODISCARD std::unique_ptr<render_target> create_render_target(const texture::extent& targetExtent, render_target::format targetFormat, uint32_t samples) override {
+            wiender_assert(samples != 0, "wiender::vulkan_wienderer::create_render_target sample count cannot be 0");
+            const VkFormat format = get_render_target_format(targetFormat);
+
+            VkFormatProperties formatProperties{};
+            vkGetPhysicalDeviceFormatProperties(pdevice_, format, &formatProperties);
+            const VkFormatFeatureFlags requiredFeatures = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+            wiender_assert((formatProperties.optimalTilingFeatures & requiredFeatures) == requiredFeatures, "wiender::vulkan_wienderer::create_render_target format isn't supported by the device as a sampled color attachment");
+
+            return create_vulkan_render_target(this, targetExtent, targetFormat, format, get_render_target_samples(samples));
+        }
+        WIENDER_NODISCARD std::unique_ptr<render_target> get_postproc_texture() override {
+            return create_render_target(texture::extent(swapchainSupportInfo_.extent.width, swapchainSupportInfo_.extent.height), render_target::format::SWAPCHAIN, 1);
+        }
+        WIENDER_NODISCARD std::unique_ptr<postprocess_chain> create_postprocess_chain(const postprocess_chain::description& chainDescription) override {
+            wiender_assert(chainDescription.postSubpassCount != 0, "wiender::vulkan_wienderer::create_postprocess_chain chain needs at least one post subpass");
+            const VkFormat format = get_render_target_format(chainDescription.intermediateFormat);
+
+            VkFormatProperties formatProperties{};
+            vkGetPhysicalDeviceFormatProperties(pdevice_, format, &formatProperties);
+            wiender_assert((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT) != 0, "wiender::vulkan_wienderer::create_postprocess_chain intermediate format isn't supported by the device as a color attachment");
+
+            return create_vulkan_postprocess_chain(this, chainDescription, format);
         }
         WIENDER_NODISCARD std::unique_ptr<wiender_commands_frame> get_commands_frame() const override {
             return std::unique_ptr<commands_frame>(new commands_frame(appliedCommands_));
         }
         void clear_commands_frame() override {
+            wait_executing(); // buffers can't be reset while pending
             for (const auto& buffer : commandBuffers_)
                 vkResetCommandBuffer(buffer, static_cast<VkFlags>(0));
             appliedCommands_.clear();
@@ -413,21 +950,22 @@ namespace wiender {
 
             const commands_frame& aframe = *(commands_frame*)frame;
 
-            appliedCommands_.assign(aframe.begin(), aframe.end());
+            appliedCommands_.clear(); // replaying the frame records its commands again
+            wait_executing(); // buffers can't be reset while pending
             for (const auto& buffer : commandBuffers_)
                 vkResetCommandBuffer(buffer, static_cast<VkFlags>(0));
-            concat_vulkan_buffers(appliedCommands_);
+            concat_vulkan_buffers(aframe);
         }
         void concat_commands_frame(const wiender_commands_frame* frame) override {
             wiender_assert(frame != nullptr, "wiender::vulkan_wienderer::concat_commands failed to cancat BRAAAND new command frame");
 
             const commands_frame& aframe = *(commands_frame*)frame;
 
-            appliedCommands_.insert(appliedCommands_.end(), aframe.begin(), aframe.end());
-            concat_vulkan_buffers(aframe);
+            concat_vulkan_buffers(aframe); // appends the replayed commands to appliedCommands_
         }
         void begin_record() override {
             wiender_assert(!recording_, "wiender::vulkan_wenerer::begin_record buffers already in record state");
+            wiender_assert(context_->recorder == nullptr, "wiender::vulkan_wenerer::begin_record another wienderer of the context is recording");
 
             for (uint32_t i = 0; i < commandBuffers_.size(); ++i) {
                 const auto& buffer = commandBuffers_[i];
@@ -437,7 +975,7 @@ namespace wiender {
              // inheritanceInfo.pNext = nullptr;
                 inheritanceInfo.renderPass = currentShader_.renderPass;
              // inheritanceInfo.subpass = {};
-                inheritanceInfo.framebuffer = swapchainImages_[i].framebuffer;
+                inheritanceInfo.framebuffer = get_framebuffer(i, currentShader_);
                 inheritanceInfo.occlusionQueryEnable = VK_FALSE;
              // inheritanceInfo.queryFlags = static_cast<VkQueryControlFlags>(0);
              // inheritanceInfo.pipelineStatistics = {};
@@ -449,128 +987,451 @@ namespace wiender {
                 beginInfo.pInheritanceInfo = &inheritanceInfo;
 
                 vulkan_check(vkBeginCommandBuffer(buffer, &beginInfo), "wiender::vulkan_wienderer::begin_record failed to begin recording buffers");
+                if (timestampPool_ != 0) {
+                    vkCmdResetQueryPool(buffer, timestampPool_, 2 * i, 2);
+                    // the acquire semaphore is waited at this stage, a top of pipe timestamp would count the vsync wait
+                    vkCmdWriteTimestamp(buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, timestampPool_, 2 * i);
+                }
             }
-            appliedCommands_.emplace_back(render_command{ render_command_type::BEGIN_RECORD, { }});
+            boundState_ = recorder_state{};
+            bindStatistics_ = bind_statistics{};
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::BEGIN_RECORD, { }});
             recording_ = true;
+            context_->recorder = this;
         }
         void begin_render() override {
+            begin_render(nullptr);
+        }
+        void begin_render(render_target* target) override {
             if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
                 return;
             wiender_assert(currentShader_.pipeline != 0, "wiender::vulkan_wienderer::begin_render you should set shader before render");
+            wiender_assert(currentShader_.chainSubpassCount == 0, "wiender::vulkan_wienderer::begin_render shader draws in a post-process chain, use begin_render_chain");
+
+            render_target_state targetState{ 0, swapchainSupportInfo_.extent, VK_FORMAT_UNDEFINED, msaaSamples_ };
+            if (target != nullptr) {
+                targetState = get_vulkan_render_target_state(target, currentShader_.depthAttachment);
+                wiender_assert((targetState.format == currentShader_.targetFormat) && (targetState.samples == currentShader_.targetSamples), "wiender::vulkan_wienderer::begin_render shader has to be created for the render target format and sample count");
+            } else {
+                wiender_assert(currentShader_.targetFormat == VK_FORMAT_UNDEFINED, "wiender::vulkan_wienderer::begin_render shader draws into render targets, pass one");
+            }
 
             for (uint32_t i = 0; i < commandBuffers_.size(); ++i) {
                 const auto& buffer = commandBuffers_[i];
 
-                const VkClearValue clearVal{};
+                // color, resolve if multisampled, depth if used
+                VkClearValue clearVals[3]{};
+                const uint32_t colorAttachmentCount = (targetState.samples != VK_SAMPLE_COUNT_1_BIT) ? 2u : 1u;
+                clearVals[colorAttachmentCount].depthStencil = { 1.0f, 0 };
+
                 VkRenderPassBeginInfo beginRenderPassInfo{};
                 beginRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
              // beginRenderPassInfo.pNext = nullptr;
                 beginRenderPassInfo.renderPass = currentShader_.renderPass;
-                beginRenderPassInfo.framebuffer = swapchainImages_[i].framebuffer;
-                beginRenderPassInfo.renderArea = {{0, 0}, swapchainSupportInfo_.extent};
-                beginRenderPassInfo.clearValueCount = 1;
-                beginRenderPassInfo.pClearValues = &clearVal;
+                beginRenderPassInfo.framebuffer = (target != nullptr) ? targetState.framebuffer : get_framebuffer(i, currentShader_);
+                beginRenderPassInfo.renderArea = {{0, 0}, targetState.extent};
+                beginRenderPassInfo.clearValueCount = colorAttachmentCount + (currentShader_.depthAttachment ? 1u : 0u);
+                beginRenderPassInfo.pClearValues = clearVals;
 
                 vkCmdBeginRenderPass(buffer, &beginRenderPassInfo, {});
+            }
+            record_viewport(targetState.extent);
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_BEGIN_RENDER, { }});
+            appliedCommands_.commands.back().data.renderTarget = target;
+
+        }
+        void begin_render_chain(postprocess_chain* chain) override {
+            if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
+                return;
+            wiender_assert(chain != nullptr, "wiender::vulkan_wienderer::begin_render_chain chain cannot be nullptr");
+            wiender_assert(currentShader_.pipeline != 0, "wiender::vulkan_wienderer::begin_render_chain you should set shader before render");
+
+            const postprocess_chain_state& chainState = get_vulkan_postprocess_chain_state(chain);
+            wiender_assert(
+                (currentShader_.chainSubpassCount == chainState.subpassCount) &&
+                (currentShader_.subpass == 0) &&
+                (currentShader_.targetFormat == chainState.intermediateFormat) &&
+                (currentShader_.depthAttachment == chainState.depthAttachment),
+                "wiender::vulkan_wienderer::begin_render_chain shader has to be a scene shader created for the chain");
+
+            // the first intermediate and depth are cleared, the window and the second intermediate are not loaded
+            VkClearValue clearVals[4]{};
+            if (chainState.depthAttachment) // otherwise the last clear value is a color, depth would turn it red
+                clearVals[chainState.attachmentCount - 1].depthStencil = { 1.0f, 0 };
+
+            for (uint32_t i = 0; i < commandBuffers_.size(); ++i) {
+                VkRenderPassBeginInfo beginRenderPassInfo{};
+                beginRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+             // beginRenderPassInfo.pNext = nullptr;
+                beginRenderPassInfo.renderPass = chainState.renderPass;
+                beginRenderPassInfo.framebuffer = chainState.framebuffers[i];
+                beginRenderPassInfo.renderArea = {{0, 0}, swapchainSupportInfo_.extent};
+                beginRenderPassInfo.clearValueCount = chainState.attachmentCount;
+                beginRenderPassInfo.pClearValues = clearVals;
 
-                vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentShader_.layout, 0, 1, &currentShader_.descriptorSet, 0, nullptr );
+                vkCmdBeginRenderPass(commandBuffers_[i], &beginRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
             }
-            appliedCommands_.emplace_back(render_command{ render_command_type::RECORD_BEGIN_RENDER, { }});
+            record_viewport(swapchainSupportInfo_.extent);
+            boundState_.subpass = 0;
+            boundState_.subpassCount = chainState.subpassCount;
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_BEGIN_RENDER_CHAIN, { }});
+            appliedCommands_.commands.back().data.postprocessChain = chain;
+        }
+        void next_subpass() override {
+            if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
+                return;
+            wiender_assert(boundState_.subpass + 1 < boundState_.subpassCount, "wiender::vulkan_wienderer::next_subpass no post-process chain subpass left");
 
+            for (const auto& buffer : commandBuffers_)
+                vkCmdNextSubpass(buffer, VK_SUBPASS_CONTENTS_INLINE);
+            ++boundState_.subpass;
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_NEXT_SUBPASS, { }});
         }
         void draw_verteces(uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount) override {
             if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
                 return;
+            validate_subpass();
 
-            for (const auto& buffer : commandBuffers_) {
-                const VkDeviceSize offsets[] {
-                    0,
-                };
-                vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentShader_.pipeline);
-                vkCmdBindVertexBuffers(buffer, 0, 1, &vertexBindedBuffer_.buffer, offsets);
-
+            record_descriptor_sets();
+            record_pipeline();
+            record_vertex_buffers();
+            for (const auto& buffer : commandBuffers_)
                 vkCmdDraw(buffer, vertexCount, instanceCount, firstVertex, 0);
-            }
 
-            appliedCommands_.emplace_back(render_command{ render_command_type::RECORD_DRAW_VERTECES, { }});
-            appliedCommands_.back().data.drawData = {vertexCount, firstVertex, instanceCount};
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_DRAW_VERTECES, { }});
+            appliedCommands_.commands.back().data.drawData = {vertexCount, firstVertex, instanceCount};
         }
-        void draw_indexed(uint32_t indecesCount, uint32_t firstIndex, uint32_t instanceCount) override {
+        void draw_indexed(uint32_t indecesCount, uint32_t firstIndex, uint32_t instanceCount, int32_t baseVertex) override {
             if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
                 return;
+            validate_subpass();
 
-            for (const auto& buffer : commandBuffers_) {
-                const VkDeviceSize offsets[] {
-                    0,
-                };
-                vkCmdBindPipeline(buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, currentShader_.pipeline);
-                vkCmdBindVertexBuffers(buffer, 0, 1, &vertexBindedBuffer_.buffer, offsets);
-                vkCmdBindIndexBuffer(buffer, indexBindedBuffer_.buffer, 0, VK_INDEX_TYPE_UINT32);
+            record_descriptor_sets();
+            record_pipeline();
+            record_vertex_buffers();
+            record_index_buffer();
+            for (const auto& buffer : commandBuffers_)
+                vkCmdDrawIndexed(buffer, indecesCount, instanceCount, firstIndex, baseVertex, 0);
 
-                vkCmdDrawIndexed(buffer, indecesCount, instanceCount, firstIndex, 0, 0);
-            }
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_DRAW_INDEXED, { }});
+            appliedCommands_.commands.back().data.drawData = {indecesCount, firstIndex, instanceCount, baseVertex};
+        }
+        void bind_instance_buffer(const buffer* buff, uint32_t binding, std::size_t offset) override {
+            wiender_assert(buff != nullptr, "wiender::vulkan_wienderer::bind_instance_buffer buffer cannot be nullptr");
+            wiender_assert(binding < WIENDER_VERTEX_BINDING_MAX_COUNT, "wiender::vulkan_wienderer::bind_instance_buffer binding has to be less than " WIENDER_TOSTRING(WIENDER_VERTEX_BINDING_MAX_COUNT));
+            const vulkan_buffer* vbuff = static_cast<const vulkan_buffer*>(buff);
+            wiender_assert((vbuff->get_usage() & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) != 0, "wiender::vulkan_wienderer::bind_instance_buffer buffer has to be created with a vertex type");
+            wiender_assert(offset < vbuff->get_size(), "wiender::vulkan_wienderer::bind_instance_buffer offset is out of the buffer");
+
+            bind_vertex_buffer_state(binded_buffer_state{ vbuff->get_buffer(), offset, binding });
+        }
+        void draw_indirect(const buffer* buff, std::size_t offset, uint32_t drawCount, uint32_t stride) override {
+            record_draw_indirect(create_indirect_draw_data(buff, offset, nullptr, 0, drawCount, stride, false));
+        }
+        void draw_indexed_indirect(const buffer* buff, std::size_t offset, uint32_t drawCount, uint32_t stride) override {
+            record_draw_indirect(create_indirect_draw_data(buff, offset, nullptr, 0, drawCount, stride, true));
+        }
+        void draw_indirect_count(const buffer* buff, std::size_t offset, const buffer* countBuff, std::size_t countOffset, uint32_t maxDrawCount, uint32_t stride) override {
+            wiender_assert(countBuff != nullptr, "wiender::vulkan_wienderer::draw_indirect_count count buffer cannot be nullptr");
+            record_draw_indirect(create_indirect_draw_data(buff, offset, countBuff, countOffset, maxDrawCount, stride, false));
+        }
+        void draw_indexed_indirect_count(const buffer* buff, std::size_t offset, const buffer* countBuff, std::size_t countOffset, uint32_t maxDrawCount, uint32_t stride) override {
+            wiender_assert(countBuff != nullptr, "wiender::vulkan_wienderer::draw_indexed_indirect_count count buffer cannot be nullptr");
+            record_draw_indirect(create_indirect_draw_data(buff, offset, countBuff, countOffset, maxDrawCount, stride, true));
+        }
+        void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override {
+            wiender_assert((currentShader_.pipeline != 0) && (currentShader_.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE), "wiender::vulkan_wienderer::dispatch you should set compute shader before dispatch");
+            const uint32_t* maxGroupCount = pdevice_.properties.properties.limits.maxComputeWorkGroupCount;
+            wiender_assert((groupCountX <= maxGroupCount[0]) && (groupCountY <= maxGroupCount[1]) && (groupCountZ <= maxGroupCount[2]), "wiender::vulkan_wienderer::dispatch group count exceeds maxComputeWorkGroupCount");
+
+            record_dispatch(groupCountX, groupCountY, groupCountZ);
+        }
+        void fill_buffer(const buffer* buff, std::size_t offset, std::size_t size, uint32_t value) override {
+            wiender_assert(buff != nullptr, "wiender::vulkan_wienderer::fill_buffer buffer cannot be nullptr");
+            const vulkan_buffer* vbuff = static_cast<const vulkan_buffer*>(buff);
+            wiender_assert((vbuff->get_usage() & VK_BUFFER_USAGE_TRANSFER_DST_BIT) != 0, "wiender::vulkan_wienderer::fill_buffer buffer has to be device-local");
+            wiender_assert((offset % 4 == 0) && (size % 4 == 0) && (size != 0) && (offset + size <= vbuff->get_size()), "wiender::vulkan_wienderer::fill_buffer range has to be a non-empty multiple of 4 inside the buffer");
 
-            appliedCommands_.emplace_back(render_command{ render_command_type::RECORD_DRAW_VERTECES, { }});
-            appliedCommands_.back().data.drawData = {indecesCount, firstIndex, instanceCount};
+            record_fill_buffer(fill_buffer_data{ vbuff->get_buffer(), offset, size, value });
+        }
+        void push_constants(const shader* shad, uint32_t offset, const void* data, std::size_t size) override {
+            wiender_assert((shad != nullptr) && (data != nullptr), "wiender::vulkan_wienderer::push_constants invalid shader or data");
+            wiender_assert(size <= WIENDER_PUSH_CONSTANTS_MAX_SIZE, "wiender::vulkan_wienderer::push_constants size has to be not greater than " WIENDER_TOSTRING(WIENDER_PUSH_CONSTANTS_MAX_SIZE));
+            wiender_assert((offset % 4 == 0) && (size % 4 == 0) && (size != 0), "wiender::vulkan_wienderer::push_constants offset and size have to be multiples of 4");
+
+            const push_constants_state state = get_vulkan_shader_push_constants_state(shad);
+            wiender_assert((offset >= state.range.offset) && (offset + size <= state.range.offset + state.range.size), "wiender::vulkan_wienderer::push_constants range is out of shader push constant blocks");
+
+            push_constants_data pushConstantsData{};
+            pushConstantsData.layout = state.layout;
+            pushConstantsData.stageFlags = state.range.stageFlags;
+            pushConstantsData.offset = offset;
+            pushConstantsData.size = static_cast<uint32_t>(size);
+            record_push_constants(pushConstantsData, static_cast<const unsigned char*>(data));
         }
         void end_render() override {
             if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
                 return;
+            wiender_assert(boundState_.subpass + 1 >= boundState_.subpassCount, "wiender::vulkan_wienderer::end_render post-process chain has subpasses left, call next_subpass");
 
             for (const auto& buffer : commandBuffers_)
                 vkCmdEndRenderPass(buffer);
-            appliedCommands_.emplace_back(render_command{ render_command_type::RECORD_END_RENDER, { }});
+            boundState_.subpass = 0;
+            boundState_.subpassCount = 0;
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_END_RENDER, { }});
         }
         void end_record() override {
             wiender_assert(recording_, "wiender::vulkan_wenerer::end_record buffers are not in record state");
 
-            for (const auto& buffer : commandBuffers_)
-                vulkan_check(vkEndCommandBuffer(buffer), "wiender::vulkan_wienderer::end_record failed to end recording buffers");
-            appliedCommands_.emplace_back(render_command{ render_command_type::END_RECORD, { }});
+            for (uint32_t i = 0; i < commandBuffers_.size(); ++i) {
+                if (timestampPool_ != 0)
+                    vkCmdWriteTimestamp(commandBuffers_[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool_, 2 * i + 1);
+                vulkan_check(vkEndCommandBuffer(commandBuffers_[i]), "wiender::vulkan_wienderer::end_record failed to end recording buffers");
+            }
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::END_RECORD, { }});
             recording_ = false;
+            context_->recorder = nullptr;
         }
         void execute() override {
             if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
                 return;
 
-            const VkSemaphore& semaphore = syncObject_.semaphore;
-            const VkFence& fence = syncObject_.fence;
+            const sync_object& syncObject = syncObjects_[frameIndex_];
+            const VkSemaphore& semaphore = syncObject.semaphore;
+            const VkFence& fence = syncObject.fence;
             vkWaitForFences(ldevice_, 1, &fence, VK_TRUE, UINT64_MAX);
-            vkAcquireNextImageKHR(ldevice_, swapchain_, UINT64_MAX, semaphore, 0, &imageIndex_);
+            if (headless_)
+                imageIndex_ = (imageIndex_ + 1) % static_cast<uint32_t>(swapchainImages_.size());
+            else
+                vkAcquireNextImageKHR(ldevice_, swapchain_, UINT64_MAX, semaphore, 0, &imageIndex_);
+
+            // command buffer and uniform slot of the image may still be used by an older frame
+            if ((imageFences_[imageIndex_] != 0) && (imageFences_[imageIndex_] != fence))
+                vkWaitForFences(ldevice_, 1, &imageFences_[imageIndex_], VK_TRUE, UINT64_MAX);
+            imageFences_[imageIndex_] = fence;
+            if ((pendingTimestamps_ & (1u << imageIndex_)) != 0)
+                read_gpu_frame_time(imageIndex_);
+            flush_uniform_storages(imageIndex_);
+            flush_descriptor_writes(imageIndex_);
 
             vkResetFences(ldevice_, 1, &fence);
             const VkPipelineStageFlags waitStages[] { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
             VkSubmitInfo submit{};
             submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
             // submit.pNext = nullptr;
-            submit.waitSemaphoreCount = 1;
+            submit.waitSemaphoreCount = headless_ ? 0u : 1u;
             submit.pWaitSemaphores = &semaphore;
             submit.pWaitDstStageMask = waitStages;
             submit.commandBufferCount = static_cast<uint32_t>(WIENDER_ARRSIZE(waitStages));
             submit.pCommandBuffers = &commandBuffers_[imageIndex_];
-         // submit.signalSemaphoreCount = 0;
-         // submit.pSignalSemaphores = nullptr;
+            submit.signalSemaphoreCount = headless_ ? 0u : 1u;
+            submit.pSignalSemaphores = &syncObject.renderFinishedSemaphore;
 
             vkQueueSubmit(ldevice_.graphicsQueue, 1, &submit, fence);
+            ++frameCount_;
+            if (timestampPool_ != 0)
+                pendingTimestamps_ |= 1u << imageIndex_;
+            if (headless_) { // the fence is the only thing that waits for the frame
+                frameIndex_ = (frameIndex_ + 1) % WIENDER_FRAMES_IN_FLIGHT;
+                return;
+            }
             VkPresentInfoKHR presentInfo{};
             presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
             // presentInfo.pNext = nullptr;
-            // presentInfo.waitSemaphoreCount = 0;
-            // presentInfo.pWaitSemaphores = nullptr;
+            presentInfo.waitSemaphoreCount = 1;
+            presentInfo.pWaitSemaphores = &syncObject.renderFinishedSemaphore;
             presentInfo.swapchainCount = 1;
             presentInfo.pSwapchains = &swapchain_;
             presentInfo.pImageIndices = &imageIndex_;
             // presentInfo.pResults = nullptr; // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkPresentInfoKHR.html
 
             vkQueuePresentKHR(ldevice_.presentQueue, &presentInfo);
+            frameIndex_ = (frameIndex_ + 1) % WIENDER_FRAMES_IN_FLIGHT;
         }
         void wait_executing() override {
-            const VkFence& fence = syncObject_.fence;
-            vkWaitForFences(ldevice_, 1, &fence, VK_TRUE, UINT64_MAX);
+            VkFence fences[WIENDER_FRAMES_IN_FLIGHT];
+            for (uint32_t i = 0; i < WIENDER_FRAMES_IN_FLIGHT; ++i)
+                fences[i] = syncObjects_[i].fence;
+            vkWaitForFences(ldevice_, WIENDER_FRAMES_IN_FLIGHT, fences, VK_TRUE, UINT64_MAX);
 
          // vkQueueWaitIdle(ldevice_.graphicsQueue); // SLOW SLOW SLOW
          // vkQueueWaitIdle(ldevice_.presentQueue);
         }
+        WIENDER_NODISCARD std::unique_ptr<readback_ticket> request_readback(const texture* tetr, const readback_region& region) override {
+            VkImage image = 0;
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkExtent2D extent{};
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            if (tetr == nullptr) {
+                wiender_assert(headless_ && (frameCount_ != 0), "wiender::vulkan_wienderer::request_readback only an executed frame of a headless wienderer can be read back without a texture");
+                image = swapchainImages_[imageIndex_].image;
+                layout = get_window_final_layout();
+                extent = swapchainSupportInfo_.extent;
+                format = swapchainSupportInfo_.imageFormat.format;
+            } else {
+                const vulkan_sampled_image& sampledImage = get_sampled_image(tetr);
+                const texture::extent textureExtent = tetr->get_extent();
+                wiender_assert(textureExtent.depth == 0, "wiender::vulkan_wienderer::request_readback 3d textures cannot be read back");
+                wiender_assert(sampledImage.has_content(), "wiender::vulkan_wienderer::request_readback render target has to be rendered before it is read back");
+                image = sampledImage.get_image();
+                layout = sampledImage.get_layout();
+                extent = { textureExtent.width, std::max(textureExtent.height, 1u) };
+                format = sampledImage.get_format();
+            }
+            wiender_assert((region.x < extent.width) && (region.y < extent.height), "wiender::vulkan_wienderer::request_readback region is out of the texture");
+            const uint32_t width = (region.width != 0) ? region.width : extent.width - region.x;
+            const uint32_t height = (region.height != 0) ? region.height : extent.height - region.y;
+            wiender_assert((width <= extent.width - region.x) && (height <= extent.height - region.y), "wiender::vulkan_wienderer::request_readback region is out of the texture");
+
+            const std::size_t rowPitch = static_cast<std::size_t>(width) * sizeof_vk_color_format(format);
+            const readback_slice slice = allocate_readback_slice(rowPitch * height);
+            VkCommandBuffer cmdbuff = 0;
+            try {
+                cmdbuff = begin_readback_commands();
+
+                // render passes and uploads of executed frames are finished before the copy
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+             // barrier.pNext = nullptr;
+                barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                barrier.oldLayout = layout;
+                barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = image;
+                barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+             // barrier.subresourceRange.baseMipLevel = 0;
+                barrier.subresourceRange.levelCount = 1;
+             // barrier.subresourceRange.baseArrayLayer = 0;
+                barrier.subresourceRange.layerCount = 1;
+                vkCmdPipelineBarrier(cmdbuff, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+                VkBufferImageCopy copyRegion{};
+                copyRegion.bufferOffset = slice.offset;
+             // copyRegion.bufferRowLength = 0; // tightly packed
+             // copyRegion.bufferImageHeight = 0;
+                copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+             // copyRegion.imageSubresource.mipLevel = 0;
+             // copyRegion.imageSubresource.baseArrayLayer = 0;
+                copyRegion.imageSubresource.layerCount = 1;
+                copyRegion.imageOffset = { static_cast<int32_t>(region.x), static_cast<int32_t>(region.y), 0 };
+                copyRegion.imageExtent = { width, height, 1 };
+                vkCmdCopyImageToBuffer(cmdbuff, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slice.buffer, 1, &copyRegion);
+
+                // back to the layout render passes and shaders expect, later frames touch the image after the copy
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = 0;
+                barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+                barrier.newLayout = layout;
+                vkCmdPipelineBarrier(cmdbuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+                return submit_readback(cmdbuff, slice, rowPitch * height, rowPitch);
+            } catch (...) {
+                if (cmdbuff != 0)
+                    vkFreeCommandBuffers(ldevice_, commandPool_, 1, &cmdbuff);
+                free_readback_slice(slice);
+                throw;
+            }
+        }
+        WIENDER_NODISCARD std::unique_ptr<readback_ticket> request_readback(const buffer* buff, std::size_t offset, std::size_t size) override {
+            wiender_assert(buff != nullptr, "wiender::vulkan_wienderer::request_readback buffer cannot be nullptr");
+            const vulkan_buffer* vbuff = static_cast<const vulkan_buffer*>(buff);
+            wiender_assert((vbuff->get_usage() & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) != 0, "wiender::vulkan_wienderer::request_readback buffer has to be device-local, host-visible ones are read through map");
+            wiender_assert((size != 0) && (offset + size <= vbuff->get_size()), "wiender::vulkan_wienderer::request_readback range has to be non-empty and inside the buffer");
+
+            const readback_slice slice = allocate_readback_slice(size);
+            VkCommandBuffer cmdbuff = 0;
+            try {
+                cmdbuff = begin_readback_commands();
+
+                // shader and transfer writes of executed frames are finished before the copy
+                VkMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+             // barrier.pNext = nullptr;
+                barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+                vkCmdPipelineBarrier(cmdbuff, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+                VkBufferCopy copyRegion{};
+                copyRegion.srcOffset = offset;
+                copyRegion.dstOffset = slice.offset;
+                copyRegion.size = size;
+                vkCmdCopyBuffer(cmdbuff, vbuff->get_buffer(), slice.buffer, 1, &copyRegion);
+
+                // later frames overwrite the range after the copy
+                vkCmdPipelineBarrier(cmdbuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+                return submit_readback(cmdbuff, slice, size, size);
+            } catch (...) {
+                if (cmdbuff != 0)
+                    vkFreeCommandBuffers(ldevice_, commandPool_, 1, &cmdbuff);
+                free_readback_slice(slice);
+                throw;
+            }
+        }
+        WIENDER_NODISCARD std::vector<char> get_cache_data() const override {
+            std::vector<char> reflectionData;
+            context_->reflectionCache.serialize(reflectionData);
+
+            size_t pipelineCacheSize = 0;
+            vulkan_check(vkGetPipelineCacheData(ldevice_, pipelineCache_, &pipelineCacheSize, nullptr), "wiender::vulkan_wienderer::get_cache_data failed to get pipeline cache data 1");
+
+            cache_data_header header{};
+            header.magic = cache_data_header::wienderMagic;
+            header.reflectionSize = reflectionData.size();
+            header.pipelineCacheSize = pipelineCacheSize;
+
+            std::vector<char> result(sizeof(header) + reflectionData.size() + pipelineCacheSize);
+            std::memcpy(result.data(), &header, sizeof(header));
+            std::memcpy(result.data() + sizeof(header), reflectionData.data(), reflectionData.size());
+            if (pipelineCacheSize != 0) {
+                vulkan_check(vkGetPipelineCacheData(ldevice_, pipelineCache_, &pipelineCacheSize, result.data() + sizeof(header) + reflectionData.size()), "wiender::vulkan_wienderer::get_cache_data failed to get pipeline cache data 2");
+            }
+            result.resize(sizeof(header) + reflectionData.size() + pipelineCacheSize);
+            return result;
+        }
+        void load_cache_data(const void* data, std::size_t size) override {
+            cache_data_header header{};
+            if ((data == nullptr) || (size < sizeof(header)))
+                return;
+            std::memcpy(&header, data, sizeof(header));
+            if ((header.magic != cache_data_header::wienderMagic) || (sizeof(header) + header.reflectionSize + header.pipelineCacheSize > size))
+                return; // stale or foreign data is not an error, everything is just rebuilt
+
+            const char* bytes = static_cast<const char*>(data) + sizeof(header);
+            context_->reflectionCache.deserialize(bytes, static_cast<size_t>(header.reflectionSize));
+
+            if (header.pipelineCacheSize == 0)
+                return;
+            VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+            pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+         // pipelineCacheCreateInfo.pNext = nullptr;
+         // pipelineCacheCreateInfo.flags = static_cast<VkFlags>(0);
+            pipelineCacheCreateInfo.initialDataSize = static_cast<size_t>(header.pipelineCacheSize);
+            pipelineCacheCreateInfo.pInitialData = bytes + header.reflectionSize;
+
+            VkPipelineCache loadedCache;
+            vulkan_check(vkCreatePipelineCache(ldevice_, &pipelineCacheCreateInfo, WIENDER_ALLOCATOR_NAME, &loadedCache), "wiender::vulkan_wienderer::load_cache_data failed to create pipeline cache");
+            const VkResult mergeResult = vkMergePipelineCaches(ldevice_, pipelineCache_, 1, &loadedCache);
+            vkDestroyPipelineCache(ldevice_, loadedCache, WIENDER_ALLOCATOR_NAME);
+            vulkan_check(mergeResult, "wiender::vulkan_wienderer::load_cache_data failed to merge pipeline caches");
+        }
+        WIENDER_NODISCARD bool is_feature_supported(feature f) const noexcept override {
+            switch (f) {
+                case feature::FAST_PIPELINE_LINKING: return pdevice_.graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE;
+                case feature::BINDLESS_TEXTURES: return pdevice_.indexingFeatures.runtimeDescriptorArray == VK_TRUE;
+                case feature::INDIRECT_DRAW_COUNT: return pdevice_.drawIndirectCount;
+                case feature::GPU_TIMESTAMPS: return pdevice_.properties.properties.limits.timestampComputeAndGraphics == VK_TRUE;
+                default: return false;
+            }
+        }
+        WIENDER_NODISCARD bind_statistics get_bind_statistics() const noexcept override {
+            return bindStatistics_;
+        }
+        WIENDER_NODISCARD double get_gpu_frame_time() const noexcept override {
+            return gpuFrameTime_;
+        }
 
         public:
         void destroy_vulkan_image(vulkan_image& image) const {
@@ -596,6 +1457,201 @@ namespace wiender {
         WIENDER_NODISCARD VkExtent2D get_swapchain_extent() const noexcept {
             return swapchainSupportInfo_.extent;
         }
+        WIENDER_NODISCARD VkDescriptorSetLayout get_empty_set_layout() const noexcept {
+            return emptySetLayout_;
+        }
+        WIENDER_NODISCARD VkDescriptorSetLayout get_bindless_texture_layout() const noexcept {
+            return context_->bindlessTextures.layout;
+        }
+        WIENDER_NODISCARD VkDescriptorSet get_bindless_texture_set() const noexcept {
+            return context_->bindlessTextures.set;
+        }
+        WIENDER_NODISCARD std::unordered_map<uint64_t, std::weak_ptr<vulkan_descriptor_set>>& get_shared_descriptor_sets() noexcept {
+            return sharedDescriptorSets_;
+        }
+        /**
+         * @brief Puts the texture into the bindless table, the returned index is valid until `release_bindless_index`.
+         */
+        WIENDER_NODISCARD uint32_t allocate_bindless_index(VkImageView view, VkSampler sampler) {
+            uint32_t index;
+            if (!context_->bindlessTextures.freeIndices.empty()) {
+                index = context_->bindlessTextures.freeIndices.back();
+                context_->bindlessTextures.freeIndices.pop_back();
+            } else {
+                wiender_assert(context_->bindlessTextures.indexCount < WIENDER_BINDLESS_TEXTURE_MAX_COUNT, "wiender::vulkan_wienderer::allocate_bindless_index texture count has to be not greater than " WIENDER_TOSTRING(WIENDER_BINDLESS_TEXTURE_MAX_COUNT));
+                index = context_->bindlessTextures.indexCount++;
+            }
+            write_bindless_texture(index, view, sampler);
+            return index;
+        }
+        void release_bindless_index(uint32_t index) {
+            write_bindless_texture(index, context_->defaultTextureImage.view, context_->defaultSampler); // stale slot must not reference a destroyed view
+            context_->bindlessTextures.freeIndices.emplace_back(index);
+        }
+        WIENDER_NODISCARD uint32_t get_swapchain_image_count() const noexcept {
+            return static_cast<uint32_t>(swapchainImages_.size());
+        }
+        WIENDER_NODISCARD VkImageView get_swapchain_image_view(uint32_t imageIndex) const noexcept {
+            return swapchainImages_[imageIndex].view;
+        }
+        /**
+         * @brief Whether command buffers may reference descriptor sets, sets without update-after-bind can't be written then.
+         */
+        WIENDER_NODISCARD bool has_recorded_commands() const noexcept {
+            return recording_ || !appliedCommands_.commands.empty();
+        }
+        /**
+         * @brief Registers uniform storage to be flushed in `execute`, storage has to stay alive until unregistered.
+         */
+        void register_uniform_storage(const frame_uniform_storage* storage) {
+            uniformStorages_.emplace_back(storage);
+        }
+        void unregister_uniform_storage(const frame_uniform_storage* storage) noexcept {
+            auto found = std::find(uniformStorages_.begin(), uniformStorages_.end(), storage);
+            if (found != uniformStorages_.end())
+                uniformStorages_.erase(found);
+        }
+        /**
+         * @brief Allocates sets from shared pools, a new twice bigger pool is created when every pool is exhausted.
+         * @param setPoolSizes Descriptors needed by one set.
+         * @return Pool the sets have to be freed to.
+         */
+        WIENDER_NODISCARD VkDescriptorPool allocate_descriptor_sets(const VkDescriptorSetLayout* layouts, uint32_t count, const std::vector<VkDescriptorPoolSize>& setPoolSizes, VkDescriptorSet* sets) {
+            VkDescriptorSetAllocateInfo allocationInfo{};
+            allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+         // allocationInfo.pNext = nullptr;
+            allocationInfo.descriptorSetCount = count;
+            allocationInfo.pSetLayouts = layouts;
+
+            for (auto it = descriptorPools_.rbegin(); it != descriptorPools_.rend(); ++it) { // newer pools have more room
+                allocationInfo.descriptorPool = *it;
+                const VkResult result = vkAllocateDescriptorSets(ldevice_, &allocationInfo, sets);
+                if (result == VK_SUCCESS)
+                    return *it;
+                if ((result != VK_ERROR_OUT_OF_POOL_MEMORY) && (result != VK_ERROR_FRAGMENTED_POOL))
+                    vulkan_check(result, "wiender::vulkan_wienderer::allocate_descriptor_sets failed to allocate descriptor sets");
+            }
+
+            descriptorPools_.emplace_back(create_shared_descriptor_pool(count, setPoolSizes));
+            allocationInfo.descriptorPool = descriptorPools_.back();
+            vulkan_check(vkAllocateDescriptorSets(ldevice_, &allocationInfo, sets), "wiender::vulkan_wienderer::allocate_descriptor_sets failed to allocate descriptor sets from a new pool");
+            return descriptorPools_.back();
+        }
+        void free_descriptor_sets(VkDescriptorPool pool, uint32_t count, const VkDescriptorSet* sets) const noexcept {
+            vkFreeDescriptorSets(ldevice_, pool, count, sets);
+        }
+        /**
+         * @brief Sub-allocates zeroed host-visible uniform memory, first fit over chunks of WIENDER_UNIFORM_ARENA_CHUNK_SIZE.
+         *
+         * Offset and size are aligned to minUniformBufferOffsetAlignment.
+         */
+        WIENDER_NODISCARD uniform_slice allocate_uniform_slice(VkDeviceSize size) {
+            size = align_up(size, pdevice_.properties.properties.limits.minUniformBufferOffsetAlignment);
+            for (uint32_t iC = 0; iC < uniformArena_.size(); ++iC) {
+                uniform_arena_chunk& chunk = uniformArena_[iC];
+                for (auto it = chunk.freeRanges.begin(); it != chunk.freeRanges.end(); ++it) {
+                    if (it->size < size)
+                        continue;
+                    const uniform_slice result{ chunk.buffer, it->offset, size, chunk.mappedMemory + it->offset, iC };
+                    it->offset += size;
+                    it->size -= size;
+                    if (it->size == 0)
+                        chunk.freeRanges.erase(it);
+                    std::memset(result.mappedMemory, 0, static_cast<size_t>(size));
+                    return result;
+                }
+            }
+
+            uniformArena_.emplace_back(create_uniform_arena_chunk(std::max<VkDeviceSize>(size, WIENDER_UNIFORM_ARENA_CHUNK_SIZE)));
+            uniform_arena_chunk& chunk = uniformArena_.back();
+            const uniform_slice result{ chunk.buffer, 0, size, chunk.mappedMemory, static_cast<uint32_t>(uniformArena_.size() - 1) };
+            chunk.freeRanges.front().offset += size;
+            chunk.freeRanges.front().size -= size;
+            if (chunk.freeRanges.front().size == 0)
+                chunk.freeRanges.clear();
+            return result;
+        }
+        void free_uniform_slice(const uniform_slice& slice) {
+            if (slice.size == 0)
+                return;
+            std::vector<memory_range>& freeRanges = uniformArena_[slice.chunkIndex].freeRanges;
+            auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), slice.offset, [](const memory_range& range, VkDeviceSize offset) { return range.offset < offset; });
+            auto it = freeRanges.insert(next, memory_range{ slice.offset, slice.size });
+            if ((it + 1 != freeRanges.end()) && (it->offset + it->size == (it + 1)->offset)) {
+                it->size += (it + 1)->size;
+                freeRanges.erase(it + 1);
+            }
+            if ((it != freeRanges.begin()) && ((it - 1)->offset + (it - 1)->size == it->offset)) {
+                (it - 1)->size += it->size;
+                freeRanges.erase(it);
+            }
+        }
+        /**
+         * @brief Sub-allocates host-visible memory for a readback copy from the current readback ring.
+         *
+         * Slices are freed in any order, ring space is reused once every older slice is freed. A ring without room is
+         * replaced by a twice bigger one, the old one is destroyed with its last slice and its slot is reused.
+         */
+        WIENDER_NODISCARD readback_slice allocate_readback_slice(VkDeviceSize size) {
+            size = align_up(size, WIENDER_READBACK_ALIGNMENT);
+            VkDeviceSize offset = 0;
+            if (!readbackRings_.empty() && try_allocate_readback_range(readbackRings_[readbackRing_], size, offset)) {
+                const readback_ring& ring = readbackRings_[readbackRing_];
+                return readback_slice{ ring.buffer, offset, size, ring.mappedMemory + offset, readbackRing_ };
+            }
+
+            VkDeviceSize ringSize = WIENDER_READBACK_RING_SIZE;
+            if (!readbackRings_.empty()) {
+                readback_ring& current = readbackRings_[readbackRing_];
+                ringSize = std::max(current.size * 2, ringSize);
+                if (current.ranges.empty()) { // too small even when empty
+                    destroy_readback_ring(current);
+                    current = readback_ring{};
+                }
+            }
+            // slices keep ring indices, so only slots of destroyed rings are reused
+            uint32_t slot = 0;
+            while ((slot < readbackRings_.size()) && (readbackRings_[slot].buffer != 0))
+                ++slot;
+            if (slot == readbackRings_.size())
+                readbackRings_.emplace_back();
+            readbackRings_[slot] = create_readback_ring(std::max(size, ringSize));
+            readbackRing_ = slot;
+
+            readback_ring& ring = readbackRings_[slot];
+            const bool allocated = try_allocate_readback_range(ring, size, offset);
+            wiender_assert(allocated, "wiender::vulkan_wienderer::allocate_readback_slice new ring has no room");
+            return readback_slice{ ring.buffer, offset, size, ring.mappedMemory + offset, slot };
+        }
+        void free_readback_slice(const readback_slice& slice) {
+            readback_ring& ring = readbackRings_[slice.ringIndex];
+            for (auto& range : ring.ranges) {
+                if (range.offset == slice.offset && !range.released) {
+                    range.released = true;
+                    break;
+                }
+            }
+            while (!ring.ranges.empty() && ring.ranges.front().released)
+                ring.ranges.pop_front();
+
+            if (ring.ranges.empty() && (slice.ringIndex != readbackRing_)) {
+                destroy_readback_ring(ring);
+                ring = readback_ring{};
+                while ((readbackRings_.size() > readbackRing_ + 1) && (readbackRings_.back().buffer == 0))
+                    readbackRings_.pop_back();
+            }
+        }
+        /**
+         * @brief Registers descriptor writes to be flushed in `execute`, writes have to stay alive until unregistered.
+         */
+        void register_descriptor_writes(frame_descriptor_writes* writes) {
+            descriptorWrites_.emplace_back(writes);
+        }
+        void unregister_descriptor_writes(frame_descriptor_writes* writes) noexcept {
+            auto found = std::find(descriptorWrites_.begin(), descriptorWrites_.end(), writes);
+            if (found != descriptorWrites_.end())
+                descriptorWrites_.erase(found);
+        }
         WIENDER_NODISCARD uint32_t find_memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
             VkPhysicalDeviceMemoryProperties memProperties;
             vkGetPhysicalDeviceMemoryProperties(pdevice_, &memProperties);
@@ -608,12 +1664,67 @@ namespace wiender {
 
             throw std::runtime_error("wiender::vulkan_wienderer::find_memory_type failed to find a suitable memory type");
         }
+        /**
+         * @brief Same, prefers types with `preferred` properties too, e.g. cached memory for host reads.
+         */
+        WIENDER_NODISCARD uint32_t find_memory_type(uint32_t typeFilter, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred) const {
+            VkPhysicalDeviceMemoryProperties memProperties;
+            vkGetPhysicalDeviceMemoryProperties(pdevice_, &memProperties);
+
+            const VkMemoryPropertyFlags wanted = properties | preferred;
+            for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+                if (((typeFilter & (1u << i)) != 0) && ((memProperties.memoryTypes[i].propertyFlags & wanted) == wanted)) {
+                    return i;
+                }
+            }
+            return find_memory_type(typeFilter, properties);
+        }
         WIENDER_NODISCARD const logical_device_info& get_ldevice() const {
             return ldevice_;
         }
+        WIENDER_NODISCARD VkCommandPool get_command_pool() const noexcept {
+            return commandPool_;
+        }
+        /**
+         * @brief Returns the wienderer of the context that is recording, buffers bind into it even if another one created them.
+         */
+        WIENDER_NODISCARD vulkan_wienderer* get_recorder() noexcept {
+            return (context_->recorder != nullptr) ? context_->recorder : this;
+        }
         WIENDER_NODISCARD const physical_device_info& get_pdevice() const {
             return pdevice_;
         }
+        WIENDER_NODISCARD VkPipelineCache get_pipeline_cache() const noexcept {
+            return pipelineCache_;
+        }
+        WIENDER_NODISCARD shader_reflection_cache& get_reflection_cache() noexcept {
+            return context_->reflectionCache;
+        }
+        /**
+         * @brief Returns a graphics pipeline library for one part of a pipeline, creating it on first use.
+         *
+         * `key` has to describe all the state of `createInfo` used by `part`, libraries live until the context is destroyed.
+         */
+        WIENDER_NODISCARD VkPipeline get_pipeline_library(uint64_t key, VkGraphicsPipelineLibraryFlagsEXT part, const VkGraphicsPipelineCreateInfo& createInfo) {
+            key = hash_value(part, key);
+            const auto found = context_->pipelineLibraries.find(key);
+            if (found != context_->pipelineLibraries.end())
+                return found->second;
+
+            VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+            libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+         // libraryInfo.pNext = nullptr;
+            libraryInfo.flags = part;
+
+            VkGraphicsPipelineCreateInfo partInfo = createInfo;
+            partInfo.pNext = &libraryInfo;
+            partInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+            VkPipeline result;
+            vulkan_check(vkCreateGraphicsPipelines(ldevice_, pipelineCache_, 1, &partInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::get_pipeline_library failed to create pipeline library");
+            context_->pipelineLibraries.emplace(key, result);
+            return result;
+        }
         void copy_buffer(VkCommandBuffer cmdbuff, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) const {
             VkBufferCopy copyRegion{};
          // copyRegion.srcOffset = 0;
@@ -685,7 +1796,7 @@ namespace wiender {
             barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             barrier.image = image;
-            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.aspectMask = (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
             barrier.subresourceRange.baseMipLevel = 0;
             barrier.subresourceRange.levelCount = 1;
             barrier.subresourceRange.baseArrayLayer = 0;
@@ -730,6 +1841,12 @@ namespace wiender {
 
                 sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
                 destinationStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
+                barrier.srcAccessMask = 0;
+                barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+                sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                destinationStage = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
             } else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR) {
                 barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
                 barrier.dstAccessMask = 0;
@@ -750,34 +1867,288 @@ namespace wiender {
             );
         }
         void set_shader_state(const active_shader_state& newCurrentShader) noexcept {
-            appliedCommands_.emplace_back(render_command{ render_command_type::SET_SHADER, { }});
-            appliedCommands_.back().data.activeShaderState = newCurrentShader;
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::SET_SHADER, { }});
+            appliedCommands_.commands.back().data.activeShaderState = newCurrentShader;
             currentShader_ = newCurrentShader;
         }
-        void bind_vertex_buffer_state(const binded_buffer_state& newBindedBuffer) noexcept {
-            appliedCommands_.emplace_back(render_command{ render_command_type::BIND_VERTEX_BUFFER, { }});
-            appliedCommands_.back().data.bindedBufferState = newBindedBuffer;
-            vertexBindedBuffer_ = newBindedBuffer;
+        /**
+         * @brief Binds sets of the current shader that differ from the bound state.
+         *
+         * A bound set stays valid while layouts are compatible up to its number, so shared frame and pass sets
+         * survive shader changes and switching materials of one shader rebinds only the material set.
+         */
+        void record_descriptor_sets() noexcept {
+            const descriptor_sets_state& state = *currentShader_.descriptorSets;
+            bound_descriptor_set* boundSets = boundState_.descriptorSets[get_bind_point_index()];
+            for (uint32_t setNumber = 0; setNumber < state.setCount; ++setNumber) {
+                if (state.sets[setNumber][0] == 0)
+                    continue; // unused set number
+                if ((boundSets[setNumber].set == state.sets[setNumber][0]) &&
+                    (boundSets[setNumber].compatibilityHash == state.compatibilityHashes[setNumber])) {
+                    ++bindStatistics_.descriptorSets.skipped;
+                    continue;
+                }
+
+                for (uint32_t i = 0; i < commandBuffers_.size(); ++i)
+                    vkCmdBindDescriptorSets(commandBuffers_[i], currentShader_.bindPoint, currentShader_.layout, setNumber, 1, &state.sets[setNumber][i], 0, nullptr);
+                boundSets[setNumber] = bound_descriptor_set{ state.sets[setNumber][0], state.compatibilityHashes[setNumber] };
+                ++bindStatistics_.descriptorSets.issued;
+
+                // higher sets bound with a layout incompatible with the current one are disturbed
+                for (uint32_t higher = setNumber + 1; higher < WIENDER_DESCRIPTOR_SET_MAX_COUNT; ++higher) {
+                    if ((higher >= state.setCount) || (boundSets[higher].compatibilityHash != state.compatibilityHashes[higher]))
+                        boundSets[higher] = bound_descriptor_set{};
+                }
+            }
         }
-        void bind_index_buffer_state(const binded_buffer_state& newBindedBuffer) noexcept {
-            appliedCommands_.emplace_back(render_command{ render_command_type::BIND_INDEX_BUFFER, { }});
-            appliedCommands_.back().data.bindedBufferState = newBindedBuffer;
-            indexBindedBuffer_ = newBindedBuffer;
+        WIENDER_NODISCARD uint32_t get_bind_point_index() const noexcept { // bind points have separate state
+            return (currentShader_.bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE) ? 1 : 0;
         }
-        VkImageView create_image_view(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) const {
-            VkImageViewCreateInfo viewInfo{};
-            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-         // viewInfo.pNext = nullptr;
-         // viewInfo.flags = static_cast<VkFlags>(0);
-            viewInfo.image = image;
-            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            viewInfo.format = format;
-            viewInfo.components = VkComponentMapping {
-                VK_COMPONENT_SWIZZLE_IDENTITY,
-                VK_COMPONENT_SWIZZLE_IDENTITY,
-                VK_COMPONENT_SWIZZLE_IDENTITY,
-                VK_COMPONENT_SWIZZLE_IDENTITY
-            };
+        /**
+         * @brief Checks that the current shader was created for the subpass being recorded.
+         */
+        void validate_subpass() const {
+            wiender_assert(
+                (currentShader_.chainSubpassCount == boundState_.subpassCount) && (currentShader_.subpass == boundState_.subpass),
+                "wiender::vulkan_wienderer::validate_subpass shader has to be created for the current post-process chain subpass");
+        }
+        void record_pipeline() noexcept {
+            VkPipeline& boundPipeline = boundState_.pipelines[get_bind_point_index()];
+            if (boundPipeline == currentShader_.pipeline) {
+                ++bindStatistics_.pipelines.skipped;
+                return;
+            }
+            for (const auto& buffer : commandBuffers_)
+                vkCmdBindPipeline(buffer, currentShader_.bindPoint, currentShader_.pipeline);
+            boundPipeline = currentShader_.pipeline;
+            ++bindStatistics_.pipelines.issued;
+        }
+        void record_index_buffer() noexcept {
+            const binded_buffer_state& bound = boundState_.indexBuffer;
+            if ((bound.buffer == indexBindedBuffer_.buffer) && (bound.offset == indexBindedBuffer_.offset) && (bound.indexType == indexBindedBuffer_.indexType)) {
+                ++bindStatistics_.indexBuffers.skipped;
+                return;
+            }
+            for (const auto& buffer : commandBuffers_)
+                vkCmdBindIndexBuffer(buffer, indexBindedBuffer_.buffer, indexBindedBuffer_.offset, indexBindedBuffer_.indexType);
+            boundState_.indexBuffer = indexBindedBuffer_;
+            ++bindStatistics_.indexBuffers.issued;
+        }
+        /**
+         * @brief Sets viewport and scissor covering the render area, graphics pipelines take both as dynamic state.
+         */
+        void record_viewport(VkExtent2D extent) noexcept {
+            if ((boundState_.viewport.width == extent.width) && (boundState_.viewport.height == extent.height))
+                return; // dynamic state outlives render passes of the command buffer
+            const VkViewport viewport { 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+            const VkRect2D scissor { {0, 0}, extent };
+            for (const auto& buffer : commandBuffers_) {
+                vkCmdSetViewport(buffer, 0, 1, &viewport);
+                vkCmdSetScissor(buffer, 0, 1, &scissor);
+            }
+            boundState_.viewport = extent;
+        }
+        void record_dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) noexcept {
+            record_descriptor_sets();
+            record_pipeline();
+
+            // readers of the written buffers, draws of the previous frame in flight included, finish before the dispatch
+            const VkPipelineStageFlags readingStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            VkMemoryBarrier preBarrier{};
+            preBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+         // preBarrier.pNext = nullptr;
+            preBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            preBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+         // barrier.pNext = nullptr;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            for (const auto& buffer : commandBuffers_) {
+                vkCmdPipelineBarrier(buffer, readingStages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &preBarrier, 0, nullptr, 0, nullptr);
+                vkCmdDispatch(buffer, groupCountX, groupCountY, groupCountZ);
+                vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, readingStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            }
+
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_DISPATCH, { }});
+            appliedCommands_.commands.back().data.drawData = {groupCountX, groupCountY, groupCountZ};
+        }
+        void record_fill_buffer(const fill_buffer_data& data) noexcept {
+            // previous reads of the range, earlier frames included, have to finish before it is overwritten
+            const VkPipelineStageFlags readingStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+            // compute writes of the range (e.g. atomic counters) have to be available before the fill overwrites them
+            VkMemoryBarrier preBarrier{};
+            preBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+         // preBarrier.pNext = nullptr;
+            preBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            preBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+         // barrier.pNext = nullptr;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            for (const auto& buffer : commandBuffers_) {
+                vkCmdPipelineBarrier(buffer, readingStages, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &preBarrier, 0, nullptr, 0, nullptr);
+                vkCmdFillBuffer(buffer, data.buffer, data.offset, data.size, data.value);
+                vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, readingStages, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+            }
+
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_FILL_BUFFER, { }});
+            appliedCommands_.commands.back().data.fillBufferData = data;
+        }
+        WIENDER_NODISCARD indirect_draw_data create_indirect_draw_data(const buffer* buff, std::size_t offset, const buffer* countBuff, std::size_t countOffset, uint32_t drawCount, uint32_t stride, bool indexed) const {
+            wiender_assert(buff != nullptr, "wiender::vulkan_wienderer::create_indirect_draw_data buffer cannot be nullptr");
+            validate_subpass();
+            const vulkan_buffer* vbuff = static_cast<const vulkan_buffer*>(buff);
+            wiender_assert((vbuff->get_usage() & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0, "wiender::vulkan_wienderer::create_indirect_draw_data buffer has to be created with the indirect type");
+
+            const uint32_t commandSize = indexed ? sizeof(draw_indexed_indirect_command) : sizeof(draw_indirect_command);
+            if (stride == 0)
+                stride = commandSize;
+            wiender_assert((stride >= commandSize) && (stride % 4 == 0) && (offset % 4 == 0), "wiender::vulkan_wienderer::create_indirect_draw_data stride has to fit a command, stride and offset have to be multiples of 4");
+            wiender_assert((drawCount == 0) || (offset + static_cast<std::size_t>(drawCount - 1) * stride + commandSize <= vbuff->get_size()), "wiender::vulkan_wienderer::create_indirect_draw_data draws are out of the buffer");
+            wiender_assert(drawCount <= pdevice_.properties.properties.limits.maxDrawIndirectCount, "wiender::vulkan_wienderer::create_indirect_draw_data draw count exceeds maxDrawIndirectCount");
+
+            indirect_draw_data result{};
+            result.buffer = vbuff->get_buffer();
+            result.offset = offset;
+            result.drawCount = drawCount;
+            result.stride = stride;
+            result.indexed = indexed;
+            if (countBuff != nullptr) {
+                wiender_assert(is_feature_supported(feature::INDIRECT_DRAW_COUNT), "wiender::vulkan_wienderer::create_indirect_draw_data indirect draw count is not supported by the device");
+                const vulkan_buffer* vcountBuff = static_cast<const vulkan_buffer*>(countBuff);
+                wiender_assert((vcountBuff->get_usage() & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) != 0, "wiender::vulkan_wienderer::create_indirect_draw_data count buffer has to be created with the indirect type");
+                wiender_assert((countOffset % 4 == 0) && (countOffset + sizeof(uint32_t) <= vcountBuff->get_size()), "wiender::vulkan_wienderer::create_indirect_draw_data count offset has to be a multiple of 4 inside the buffer");
+                result.countBuffer = vcountBuff->get_buffer();
+                result.countOffset = countOffset;
+            }
+            return result;
+        }
+        void record_draw_indirect(const indirect_draw_data& data) noexcept {
+            if ((swapchainSupportInfo_.extent.width == 0) || (swapchainSupportInfo_.extent.height == 0))
+                return;
+
+            record_descriptor_sets();
+            record_pipeline();
+            record_vertex_buffers();
+            if (data.indexed)
+                record_index_buffer();
+
+            const bool multiDraw = pdevice_.features.features.multiDrawIndirect == VK_TRUE;
+            for (const auto& buffer : commandBuffers_) {
+                if (data.countBuffer != 0) {
+                    if (data.indexed)
+                        ldevice_.cmdDrawIndexedIndirectCount(buffer, data.buffer, data.offset, data.countBuffer, data.countOffset, data.drawCount, data.stride);
+                    else
+                        ldevice_.cmdDrawIndirectCount(buffer, data.buffer, data.offset, data.countBuffer, data.countOffset, data.drawCount, data.stride);
+                } else if (multiDraw || (data.drawCount <= 1)) {
+                    if (data.indexed)
+                        vkCmdDrawIndexedIndirect(buffer, data.buffer, data.offset, data.drawCount, data.stride);
+                    else
+                        vkCmdDrawIndirect(buffer, data.buffer, data.offset, data.drawCount, data.stride);
+                } else { // without multiDrawIndirect every draw is a separate command
+                    for (uint32_t i = 0; i < data.drawCount; ++i) {
+                        if (data.indexed)
+                            vkCmdDrawIndexedIndirect(buffer, data.buffer, data.offset + i * data.stride, 1, data.stride);
+                        else
+                            vkCmdDrawIndirect(buffer, data.buffer, data.offset + i * data.stride, 1, data.stride);
+                    }
+                }
+            }
+
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_DRAW_INDIRECT, { }});
+            appliedCommands_.commands.back().data.indirectDrawData = data;
+        }
+        /**
+         * @param bytes `pushConstantsData.size` bytes of the payload, cannot point into `appliedCommands_`.
+         */
+        void record_push_constants(const push_constants_data& pushConstantsData, const unsigned char* bytes) {
+            for (const auto& buffer : commandBuffers_)
+                vkCmdPushConstants(buffer, pushConstantsData.layout, pushConstantsData.stageFlags, pushConstantsData.offset, pushConstantsData.size, bytes);
+
+            std::vector<unsigned char>& arena = appliedCommands_.pushConstantBytes;
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::RECORD_PUSH_CONSTANTS, { }});
+            appliedCommands_.commands.back().data.pushConstantsData = pushConstantsData;
+            appliedCommands_.commands.back().data.pushConstantsData.bytesOffset = static_cast<uint32_t>(arena.size());
+            arena.insert(arena.end(), bytes, bytes + pushConstantsData.size);
+        }
+        void flush_uniform_storages(uint32_t slot) const noexcept {
+            for (const frame_uniform_storage* storage : uniformStorages_)
+                std::memcpy(storage->mappedMemory + slot * storage->slotSize, storage->shadowMemory, static_cast<size_t>(storage->dataSize));
+        }
+        void flush_descriptor_writes(uint32_t imageIndex) noexcept {
+            const uint32_t imageBit = 1u << imageIndex;
+            for (frame_descriptor_writes* writes : descriptorWrites_) {
+                if ((writes->dirtyImages & imageBit) == 0)
+                    continue;
+                vkUpdateDescriptorSetWithTemplate(ldevice_, writes->sets[imageIndex], writes->updateTemplate, writes->data + imageIndex * writes->dataStride);
+                writes->dirtyImages &= ~imageBit;
+            }
+        }
+        void bind_vertex_buffer_state(const binded_buffer_state& newBindedBuffer) noexcept {
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::BIND_VERTEX_BUFFER, { }});
+            appliedCommands_.commands.back().data.bindedBufferState = newBindedBuffer;
+            vertexBindedBuffers_[newBindedBuffer.binding] = newBindedBuffer;
+        }
+        /**
+         * @brief Binds vertex buffers that differ from the bound ones, contiguous bindings in a single call.
+         */
+        void record_vertex_buffers() noexcept {
+            VkBuffer buffers[WIENDER_VERTEX_BINDING_MAX_COUNT];
+            VkDeviceSize offsets[WIENDER_VERTEX_BINDING_MAX_COUNT];
+            uint32_t first = 0;
+            uint32_t count = 0;
+            for (uint32_t binding = 0; binding <= WIENDER_VERTEX_BINDING_MAX_COUNT; ++binding) {
+                if (binding < WIENDER_VERTEX_BINDING_MAX_COUNT) {
+                    const binded_buffer_state& current = vertexBindedBuffers_[binding];
+                    binded_buffer_state& bound = boundState_.vertexBuffers[binding];
+                    if ((current.buffer != 0) && ((current.buffer != bound.buffer) || (current.offset != bound.offset))) {
+                        buffers[count] = current.buffer;
+                        offsets[count] = current.offset;
+                        bound = current;
+                        ++count;
+                        ++bindStatistics_.vertexBuffers.issued;
+                        continue;
+                    }
+                    if (current.buffer != 0)
+                        ++bindStatistics_.vertexBuffers.skipped;
+                }
+                if (count != 0) {
+                    for (const auto& buffer : commandBuffers_)
+                        vkCmdBindVertexBuffers(buffer, first, count, buffers, offsets);
+                }
+                first = binding + 1;
+                count = 0;
+            }
+        }
+        void bind_index_buffer_state(const binded_buffer_state& newBindedBuffer) noexcept {
+            appliedCommands_.commands.emplace_back(render_command{ render_command_type::BIND_INDEX_BUFFER, { }});
+            appliedCommands_.commands.back().data.bindedBufferState = newBindedBuffer;
+            indexBindedBuffer_ = newBindedBuffer;
+        }
+        VkImageView create_image_view(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) const {
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+         // viewInfo.pNext = nullptr;
+         // viewInfo.flags = static_cast<VkFlags>(0);
+            viewInfo.image = image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = format;
+            viewInfo.components = VkComponentMapping {
+                VK_COMPONENT_SWIZZLE_IDENTITY,
+                VK_COMPONENT_SWIZZLE_IDENTITY,
+                VK_COMPONENT_SWIZZLE_IDENTITY,
+                VK_COMPONENT_SWIZZLE_IDENTITY
+            };
             viewInfo.subresourceRange = VkImageSubresourceRange{
                 /*aspectMask      */   aspectFlags,
                 /*baseMipLevel    */   0,
@@ -790,7 +2161,10 @@ namespace wiender {
             vulkan_check(vkCreateImageView(ldevice_, &viewInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_image_view failed to create image view");
             return result;
         }
-        vulkan_image create_vulkan_image(uint32_t width, uint32_t height, uint32_t mipLevels, VkImageAspectFlags aspectFlags, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties) const {
+        /**
+         * @param preferred Memory properties used if the device has them, e.g. lazily allocated memory for transient attachments.
+         */
+        vulkan_image create_vulkan_image(uint32_t width, uint32_t height, uint32_t mipLevels, VkImageAspectFlags aspectFlags, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferred = 0) const {
             VkImageCreateInfo imageInfo{};
             imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
          // pNext = nullptr;
@@ -817,7 +2191,7 @@ namespace wiender {
             allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
          // pNext = nullptr;
             allocInfo.allocationSize = memRequirements.size;
-            allocInfo.memoryTypeIndex = find_memory_type(memRequirements.memoryTypeBits, properties);
+            allocInfo.memoryTypeIndex = (preferred != 0) ? find_memory_type(memRequirements.memoryTypeBits, properties, preferred) : find_memory_type(memRequirements.memoryTypeBits, properties);
 
             VkDeviceMemory memory;
             vulkan_check(vkAllocateMemory(ldevice_, &allocInfo, WIENDER_ALLOCATOR_NAME, &memory), "wiender::vulkan_wienderer::create_vulkan_image_memory failed to allocate image memory");
@@ -831,28 +2205,56 @@ namespace wiender {
 
         private:
         void accurate_destroy() {
-            if (recording_) {
-                end_record();
-            }
+            // buffers left recording are freed with the pool, ending them could throw in the middle of a render pass
+            recording_ = false;
+            if ((context_ != nullptr) && (context_->recorder == this))
+                context_->recorder = nullptr; // shared buffer binds would go to freed memory and nobody could record again
             
             if (ldevice_ != 0)
                 vkDeviceWaitIdle(ldevice_);
 
-            if (defaultSampler_ != 0)
-                vkDestroySampler(ldevice_, defaultSampler_, WIENDER_ALLOCATOR_NAME);
-
-            destroy_vulkan_image(defaultTextureImage_);
+            defaultStorageBuffer_.reset();
+
+            for (const auto& pool : descriptorPools_)
+                vkDestroyDescriptorPool(ldevice_, pool, WIENDER_ALLOCATOR_NAME);
+            descriptorPools_.clear();
+            for (const auto& chunk : uniformArena_)
+                destroy_uniform_arena_chunk(chunk);
+            uniformArena_.clear();
+            for (const auto& ring : readbackRings_)
+                destroy_readback_ring(ring);
+            readbackRings_.clear();
+            readbackRing_ = 0;
+
+            if (emptySetLayout_ != 0)
+                vkDestroyDescriptorSetLayout(ldevice_, emptySetLayout_, WIENDER_ALLOCATOR_NAME);
+            emptySetLayout_ = 0;
+
+            for (auto& syncObject : syncObjects_) {
+                if (syncObject.renderFinishedSemaphore != 0)
+                    vkDestroySemaphore(ldevice_, syncObject.renderFinishedSemaphore, WIENDER_ALLOCATOR_NAME);
+                if (syncObject.semaphore != 0)
+                    vkDestroySemaphore(ldevice_, syncObject.semaphore, WIENDER_ALLOCATOR_NAME);
+                if (syncObject.fence != 0)
+                    vkDestroyFence(ldevice_, syncObject.fence, WIENDER_ALLOCATOR_NAME);
+                syncObject = {};
+            }
 
-            if (syncObject_.semaphore != 0)
-                vkDestroySemaphore(ldevice_, syncObject_.semaphore, WIENDER_ALLOCATOR_NAME);
-            if (syncObject_.fence != 0)
-                vkDestroyFence(ldevice_, syncObject_.fence, WIENDER_ALLOCATOR_NAME);
+            if (timestampPool_ != 0)
+                vkDestroyQueryPool(ldevice_, timestampPool_, WIENDER_ALLOCATOR_NAME);
+            timestampPool_ = 0;
+            pendingTimestamps_ = 0;
 
             if (commandPool_ != 0)
                 vkDestroyCommandPool(ldevice_, commandPool_, WIENDER_ALLOCATOR_NAME);
 
             destroy_swapchain_images(swapchainImages_);
             destroy_vulkan_image(colorRenderTarget_);
+            destroy_vulkan_image(depthRenderTarget_);
+            depthRenderTarget_ = {};
+            if (depthRenderPass_ != 0)
+                vkDestroyRenderPass(ldevice_, depthRenderPass_, WIENDER_ALLOCATOR_NAME);
+            depthRenderPass_ = 0;
 
             if (swapchain_ != 0)
                 vkDestroySwapchainKHR(ldevice_, swapchain_, WIENDER_ALLOCATOR_NAME);
@@ -862,20 +2264,18 @@ namespace wiender {
                 vkDestroyRenderPass(ldevice_, defaultRenderPass_, WIENDER_ALLOCATOR_NAME);
             defaultRenderPass_ = 0;
 
-            if (ldevice_ != 0)
-                vkDestroyDevice(ldevice_, WIENDER_ALLOCATOR_NAME);
+            pipelineCache_ = 0;
             ldevice_ = {};
 
             if (surface_ != 0)
                 vkDestroySurfaceKHR(instance_, surface_, WIENDER_ALLOCATOR_NAME);
             surface_ = 0;
 
-            if (instance_ != 0)
-                vkDestroyInstance(instance_, WIENDER_ALLOCATOR_NAME);
             instance_ = 0;
+            context_.reset(); // the last wienderer of the context destroys the device
         }
         void concat_vulkan_buffers(const render_commands& commands) {
-            for (const auto& command : commands) {
+            for (const auto& command : commands.commands) {
                 switch (command.commandType) {
                     case render_command_type::SET_SHADER                : set_shader_state(command.data.activeShaderState); break;
                     case render_command_type::BIND_VERTEX_BUFFER        : bind_vertex_buffer_state(command.data.bindedBufferState); break;
@@ -883,9 +2283,15 @@ namespace wiender {
                     case render_command_type::BEGIN_RECORD              : begin_record(); break;
                  // case render_command_type::RECORD_UPDATE_SCISSOR     : record_update_scissor(); break;
                  // case render_command_type::RECORD_UPDATE_VIEWPORT    : record_update_viewport(); break;
-                    case render_command_type::RECORD_BEGIN_RENDER       : begin_render(); break;
+                    case render_command_type::RECORD_BEGIN_RENDER       : begin_render(command.data.renderTarget); break;
+                    case render_command_type::RECORD_BEGIN_RENDER_CHAIN : begin_render_chain(command.data.postprocessChain); break;
+                    case render_command_type::RECORD_NEXT_SUBPASS       : next_subpass(); break;
                     case render_command_type::RECORD_DRAW_VERTECES      : draw_verteces(command.data.drawData.count, command.data.drawData.first, command.data.drawData.instanceCount); break;
-                    case render_command_type::RECORD_DRAW_INDEXED       : draw_indexed(command.data.drawData.count, command.data.drawData.first, command.data.drawData.instanceCount); break;
+                    case render_command_type::RECORD_DRAW_INDEXED       : draw_indexed(command.data.drawData.count, command.data.drawData.first, command.data.drawData.instanceCount, command.data.drawData.vertexOffset); break;
+                    case render_command_type::RECORD_DRAW_INDIRECT      : record_draw_indirect(command.data.indirectDrawData); break;
+                    case render_command_type::RECORD_DISPATCH           : record_dispatch(command.data.drawData.count, command.data.drawData.first, command.data.drawData.instanceCount); break;
+                    case render_command_type::RECORD_FILL_BUFFER        : record_fill_buffer(command.data.fillBufferData); break;
+                    case render_command_type::RECORD_PUSH_CONSTANTS     : record_push_constants(command.data.pushConstantsData, commands.pushConstantBytes.data() + command.data.pushConstantsData.bytesOffset); break;
                     case render_command_type::RECORD_END_RENDER         : end_render(); break;
                     case render_command_type::END_RECORD                : end_record(); break;
                     
@@ -896,6 +2302,275 @@ namespace wiender {
         }
 
         private:
+        void write_bindless_texture(uint32_t index, VkImageView view, VkSampler sampler) const noexcept {
+            VkDescriptorImageInfo imageInfo = { sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+         // write.pNext = nullptr;
+            write.dstSet = context_->bindlessTextures.set;
+            write.dstBinding = 0;
+            write.dstArrayElement = index;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = &imageInfo;
+            vkUpdateDescriptorSets(ldevice_, 1, &write, 0, nullptr);
+        }
+        WIENDER_NODISCARD VkDescriptorPool create_shared_descriptor_pool(uint32_t setCount, const std::vector<VkDescriptorPoolSize>& setPoolSizes) {
+            const uint32_t maxSets = std::max(descriptorPoolSetCount_, setCount);
+            descriptorPoolSetCount_ *= 2;
+
+            std::vector<VkDescriptorPoolSize> poolSizes {
+                { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, maxSets * 2 },
+                { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets * 4 },
+                { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, maxSets },
+                { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, maxSets },
+            };
+            for (const auto& setPoolSize : setPoolSizes) { // big arrays get room for the request at least
+                const uint32_t required = setPoolSize.descriptorCount * setCount;
+                auto found = std::find_if(poolSizes.begin(), poolSizes.end(), [&](const VkDescriptorPoolSize& poolSize) { return poolSize.type == setPoolSize.type; });
+                if (found == poolSizes.end())
+                    poolSizes.emplace_back(VkDescriptorPoolSize{ setPoolSize.type, required });
+                else
+                    found->descriptorCount = std::max(found->descriptorCount, required);
+            }
+
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+         // poolInfo.pNext = nullptr;
+            poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT | VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+            poolInfo.maxSets = maxSets;
+            poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+            poolInfo.pPoolSizes = poolSizes.data();
+
+            VkDescriptorPool result;
+            vulkan_check(vkCreateDescriptorPool(ldevice_, &poolInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_shared_descriptor_pool failed to create descriptor pool");
+            return result;
+        }
+        WIENDER_NODISCARD uniform_arena_chunk create_uniform_arena_chunk(VkDeviceSize size) const {
+            uniform_arena_chunk result{};
+
+            VkBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+         // bufferCreateInfo.pNext = nullptr;
+         // bufferCreateInfo.flags = static_cast<VkFlags>(0);
+            bufferCreateInfo.size = size;
+            bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            bufferCreateInfo.queueFamilyIndexCount = 1;
+            bufferCreateInfo.pQueueFamilyIndices = &pdevice_.queueIndeces.graphicsFamily;
+
+            vulkan_check(vkCreateBuffer(ldevice_, &bufferCreateInfo, WIENDER_ALLOCATOR_NAME, &result.buffer), "wiender::vulkan_wienderer::create_uniform_arena_chunk failed to create uniform buffer");
+
+            VkMemoryRequirements memoryRequirements;
+            vkGetBufferMemoryRequirements(ldevice_, result.buffer, &memoryRequirements);
+
+            VkMemoryAllocateInfo allocationInfo{};
+            allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+         // allocationInfo.pNext = nullptr;
+            allocationInfo.allocationSize = memoryRequirements.size;
+            allocationInfo.memoryTypeIndex = find_memory_type(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+            try {
+                vulkan_check(vkAllocateMemory(ldevice_, &allocationInfo, WIENDER_ALLOCATOR_NAME, &result.memory), "wiender::vulkan_wienderer::create_uniform_arena_chunk failed to allocate uniform memory");
+                vulkan_check(vkBindBufferMemory(ldevice_, result.buffer, result.memory, 0), "wiender::vulkan_wienderer::create_uniform_arena_chunk failed to bind uniform memory");
+
+                void* mappedMemory = nullptr;
+                vulkan_check(vkMapMemory(ldevice_, result.memory, 0, size, static_cast<VkFlags>(0), &mappedMemory), "wiender::vulkan_wienderer::create_uniform_arena_chunk failed to map uniform memory");
+                std::memset(mappedMemory, 0, static_cast<size_t>(size));
+                result.mappedMemory = static_cast<char*>(mappedMemory);
+            } catch (...) {
+                if (result.memory != 0)
+                    vkFreeMemory(ldevice_, result.memory, WIENDER_ALLOCATOR_NAME);
+                vkDestroyBuffer(ldevice_, result.buffer, WIENDER_ALLOCATOR_NAME);
+                throw;
+            }
+            result.freeRanges.emplace_back(memory_range{ 0, size });
+            return result;
+        }
+        void destroy_uniform_arena_chunk(const uniform_arena_chunk& chunk) const {
+            if (chunk.mappedMemory != nullptr)
+                vkUnmapMemory(ldevice_, chunk.memory);
+            if (chunk.buffer != 0)
+                vkDestroyBuffer(ldevice_, chunk.buffer, WIENDER_ALLOCATOR_NAME);
+            if (chunk.memory != 0)
+                vkFreeMemory(ldevice_, chunk.memory, WIENDER_ALLOCATOR_NAME);
+        }
+        WIENDER_NODISCARD readback_ring create_readback_ring(VkDeviceSize size) const {
+            readback_ring result{};
+            result.size = size;
+
+            VkBufferCreateInfo bufferCreateInfo{};
+            bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+         // bufferCreateInfo.pNext = nullptr;
+         // bufferCreateInfo.flags = static_cast<VkFlags>(0);
+            bufferCreateInfo.size = size;
+            bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            bufferCreateInfo.queueFamilyIndexCount = 1;
+            bufferCreateInfo.pQueueFamilyIndices = &pdevice_.queueIndeces.graphicsFamily;
+
+            vulkan_check(vkCreateBuffer(ldevice_, &bufferCreateInfo, WIENDER_ALLOCATOR_NAME, &result.buffer), "wiender::vulkan_wienderer::create_readback_ring failed to create readback buffer");
+
+            VkMemoryRequirements memoryRequirements;
+            vkGetBufferMemoryRequirements(ldevice_, result.buffer, &memoryRequirements);
+
+            VkMemoryAllocateInfo allocationInfo{};
+            allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+         // allocationInfo.pNext = nullptr;
+            allocationInfo.allocationSize = memoryRequirements.size;
+            // uncached memory is write-combined, reading it from the CPU is many times slower
+            allocationInfo.memoryTypeIndex = find_memory_type(memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+
+            try {
+                vulkan_check(vkAllocateMemory(ldevice_, &allocationInfo, WIENDER_ALLOCATOR_NAME, &result.memory), "wiender::vulkan_wienderer::create_readback_ring failed to allocate readback memory");
+                vulkan_check(vkBindBufferMemory(ldevice_, result.buffer, result.memory, 0), "wiender::vulkan_wienderer::create_readback_ring failed to bind readback memory");
+
+                void* mappedMemory = nullptr;
+                vulkan_check(vkMapMemory(ldevice_, result.memory, 0, size, static_cast<VkFlags>(0), &mappedMemory), "wiender::vulkan_wienderer::create_readback_ring failed to map readback memory");
+                result.mappedMemory = static_cast<char*>(mappedMemory);
+            } catch (...) {
+                if (result.memory != 0)
+                    vkFreeMemory(ldevice_, result.memory, WIENDER_ALLOCATOR_NAME);
+                vkDestroyBuffer(ldevice_, result.buffer, WIENDER_ALLOCATOR_NAME);
+                throw;
+            }
+            return result;
+        }
+        void destroy_readback_ring(const readback_ring& ring) const {
+            if (ring.mappedMemory != nullptr)
+                vkUnmapMemory(ldevice_, ring.memory);
+            if (ring.buffer != 0)
+                vkDestroyBuffer(ldevice_, ring.buffer, WIENDER_ALLOCATOR_NAME);
+            if (ring.memory != 0)
+                vkFreeMemory(ldevice_, ring.memory, WIENDER_ALLOCATOR_NAME);
+        }
+        static bool try_allocate_readback_range(readback_ring& ring, VkDeviceSize size, VkDeviceSize& offset) noexcept {
+            if (ring.ranges.empty())
+                ring.head = 0;
+            const VkDeviceSize tail = ring.ranges.empty() ? 0 : ring.ranges.front().offset;
+
+            if (ring.ranges.empty() || (ring.head > tail)) { // free space is [head, size) and [0, tail)
+                if (ring.head + size <= ring.size)
+                    offset = ring.head;
+                else if (size <= tail)
+                    offset = 0;
+                else
+                    return false;
+            } else { // wrapped, free space is [head, tail)
+                if (ring.head + size > tail)
+                    return false;
+                offset = ring.head;
+            }
+            ring.head = offset + size;
+            ring.ranges.push_back(readback_range{ offset, size, false });
+            return true;
+        }
+        WIENDER_NODISCARD VkCommandBuffer begin_readback_commands() const {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+         // allocInfo.pNext = nullptr;
+            allocInfo.commandPool = commandPool_;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer result;
+            vulkan_check(vkAllocateCommandBuffers(ldevice_, &allocInfo, &result), "wiender::vulkan_wienderer::begin_readback_commands failed to allocate command buffer");
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+         // beginInfo.pNext = nullptr;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            const VkResult beginResult = vkBeginCommandBuffer(result, &beginInfo);
+            if (beginResult != VK_SUCCESS)
+                vkFreeCommandBuffers(ldevice_, commandPool_, 1, &result);
+            vulkan_check(beginResult, "wiender::vulkan_wienderer::begin_readback_commands failed to begin command buffer");
+            return result;
+        }
+        /**
+         * @brief Ends and submits readback commands behind every executed frame, the ticket owns them from now on.
+         */
+        WIENDER_NODISCARD std::unique_ptr<readback_ticket> submit_readback(VkCommandBuffer cmdbuff, const readback_slice& slice, std::size_t size, std::size_t rowPitch) {
+            VkMemoryBarrier hostBarrier{};
+            hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+         // hostBarrier.pNext = nullptr;
+            hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(cmdbuff, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+            vulkan_check(vkEndCommandBuffer(cmdbuff), "wiender::vulkan_wienderer::submit_readback failed to end command buffer");
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+         // fenceInfo.pNext = nullptr;
+         // fenceInfo.flags = static_cast<VkFlags>(0);
+            VkFence fence;
+            vulkan_check(vkCreateFence(ldevice_, &fenceInfo, WIENDER_ALLOCATOR_NAME, &fence), "wiender::vulkan_wienderer::submit_readback failed to create fence");
+
+            VkSubmitInfo submitInfo{};
+            submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+         // submitInfo.pNext = nullptr;
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = &cmdbuff;
+            const VkResult submitResult = vkQueueSubmit(ldevice_.graphicsQueue, 1, &submitInfo, fence);
+            if (submitResult != VK_SUCCESS)
+                vkDestroyFence(ldevice_, fence, WIENDER_ALLOCATOR_NAME);
+            vulkan_check(submitResult, "wiender::vulkan_wienderer::submit_readback failed to submit readback");
+
+            return create_vulkan_readback_ticket(this, cmdbuff, fence, slice, size, rowPitch);
+        }
+        WIENDER_NODISCARD VkDescriptorSetLayout create_empty_set_layout() const {
+            VkDescriptorSetLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+         // layoutInfo.pNext = nullptr;
+         // layoutInfo.flags = static_cast<VkFlags>(0);
+         // layoutInfo.bindingCount = 0;
+         // layoutInfo.pBindings = nullptr;
+
+            VkDescriptorSetLayout result;
+            vulkan_check(vkCreateDescriptorSetLayout(ldevice_, &layoutInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_empty_set_layout failed to create descriptor set layout");
+            return result;
+        }
+        void initialize_bindless_textures(bindless_texture_table& table) const {
+            VkDescriptorSetLayoutBinding binding{};
+            binding.binding = 0;
+            binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            binding.descriptorCount = WIENDER_BINDLESS_TEXTURE_MAX_COUNT;
+            binding.stageFlags = VK_SHADER_STAGE_ALL;
+         // binding.pImmutableSamplers = nullptr;
+
+            const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+            bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+         // bindingFlagsInfo.pNext = nullptr;
+            bindingFlagsInfo.bindingCount = 1;
+            bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+            VkDescriptorSetLayoutCreateInfo layoutInfo{};
+            layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            layoutInfo.pNext = &bindingFlagsInfo;
+            layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+            layoutInfo.bindingCount = 1;
+            layoutInfo.pBindings = &binding;
+            vulkan_check(vkCreateDescriptorSetLayout(ldevice_, &layoutInfo, WIENDER_ALLOCATOR_NAME, &table.layout), "wiender::vulkan_wienderer::initialize_bindless_textures failed to create descriptor set layout");
+
+            const VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, WIENDER_BINDLESS_TEXTURE_MAX_COUNT };
+            VkDescriptorPoolCreateInfo poolInfo{};
+            poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+         // poolInfo.pNext = nullptr;
+            poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+            poolInfo.maxSets = 1;
+            poolInfo.poolSizeCount = 1;
+            poolInfo.pPoolSizes = &poolSize;
+            vulkan_check(vkCreateDescriptorPool(ldevice_, &poolInfo, WIENDER_ALLOCATOR_NAME, &table.pool), "wiender::vulkan_wienderer::initialize_bindless_textures failed to create descriptor pool");
+
+            VkDescriptorSetAllocateInfo allocationInfo{};
+            allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+         // allocationInfo.pNext = nullptr;
+            allocationInfo.descriptorPool = table.pool;
+            allocationInfo.descriptorSetCount = 1;
+            allocationInfo.pSetLayouts = &table.layout;
+            vulkan_check(vkAllocateDescriptorSets(ldevice_, &allocationInfo, &table.set), "wiender::vulkan_wienderer::initialize_bindless_textures failed to allocate descriptor set");
+        }
         WIENDER_NODISCARD VkSampler create_default_texture_sampler() const {
             VkSamplerCreateInfo samplerInfo{};
             samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -951,6 +2626,7 @@ namespace wiender {
          // semapforeInfo.pNext = nullptr,
             semapforeInfo.flags = static_cast<VkFlags>(0),
             vulkan_check(vkCreateSemaphore(ldevice_, &semapforeInfo, WIENDER_ALLOCATOR_NAME, &syncObjectsToInitialize.semaphore), "wiender::vulkan_wienderer::intitialize_sync_object failed to create semaphore for sync object");
+            vulkan_check(vkCreateSemaphore(ldevice_, &semapforeInfo, WIENDER_ALLOCATOR_NAME, &syncObjectsToInitialize.renderFinishedSemaphore), "wiender::vulkan_wienderer::intitialize_sync_object failed to create render finished semaphore for sync object");
         }
         void allocate_command_buffers(command_buffers& commandBuffers_) const {
             commandBuffers_.resize(swapchainImages_.size());
@@ -965,6 +2641,34 @@ namespace wiender {
 
             vulkan_check(vkAllocateCommandBuffers(ldevice_, &commandBufferAllocateInfo, commandBuffers_.data()), "wiender::vulkan_wienderer::allocate_command_buffers failed to allocate command buffers");
         }
+        WIENDER_NODISCARD VkQueryPool create_timestamp_pool() const {
+            VkQueryPoolCreateInfo queryPoolInfo{};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+         // queryPoolInfo.pNext = nullptr;
+         // queryPoolInfo.flags = static_cast<VkFlags>(0);
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = 2 * WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT;
+         // queryPoolInfo.pipelineStatistics = static_cast<VkQueryPipelineStatisticFlags>(0);
+
+            VkQueryPool newQueryPool;
+            vulkan_check(vkCreateQueryPool(ldevice_, &queryPoolInfo, WIENDER_ALLOCATOR_NAME, &newQueryPool), "wiender::vulkan_wienderer::create_timestamp_pool failed to create query pool");
+
+            return newQueryPool;
+        }
+        /**
+         * @brief Reads timestamps of the last frame rendered to the image, the frame has to be finished.
+         */
+        void read_gpu_frame_time(uint32_t imageIndex) noexcept {
+            pendingTimestamps_ &= ~(1u << imageIndex);
+
+            uint64_t timestamps[2]{};
+            if (vkGetQueryPoolResults(ldevice_, timestampPool_, 2 * imageIndex, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+                return; // not available, the frame time is kept
+            if (timestamps[1] < timestamps[0])
+                return;
+            const double tickNanoseconds = static_cast<double>(pdevice_.properties.properties.limits.timestampPeriod);
+            gpuFrameTime_ = static_cast<double>(timestamps[1] - timestamps[0]) * tickNanoseconds / 1000000.0;
+        }
         WIENDER_NODISCARD VkCommandPool create_command_pool() const {
             VkCommandPoolCreateInfo commandPoolCreateInfo{};
             commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -981,12 +2685,55 @@ namespace wiender {
             for (const auto& image : swapchainImagesToDestroy) {
                 if (image.framebuffer != 0)
                     vkDestroyFramebuffer(ldevice_, image.framebuffer, WIENDER_ALLOCATOR_NAME);
+                if (image.depthFramebuffer != 0)
+                    vkDestroyFramebuffer(ldevice_, image.depthFramebuffer, WIENDER_ALLOCATOR_NAME);
                 if (image.view != 0)
                     vkDestroyImageView(ldevice_, image.view, WIENDER_ALLOCATOR_NAME);
+                if (image.memory != 0) {
+                    vkDestroyImage(ldevice_, image.image, WIENDER_ALLOCATOR_NAME);
+                    vkFreeMemory(ldevice_, image.memory, WIENDER_ALLOCATOR_NAME);
+                }
             }
             swapchainImagesToDestroy.clear();
         }
         void initialize_swapchain_images(swapchain_images& swapchainImagesToInitialize) const {
+            if (headless_)
+                initialize_headless_images(swapchainImagesToInitialize);
+            else
+                initialize_swapchain_image_views(swapchainImagesToInitialize);
+
+            for (auto& swimage : swapchainImagesToInitialize) {
+                const VkImageView msaaAttachments[] = {colorRenderTarget_.view, swimage.view};
+                const VkImageView noMsaaAttachments[] = {swimage.view};
+
+                swimage.framebuffer = create_framebuffer(
+                    defaultRenderPass_,
+                    static_cast<uint32_t>(is_multisampling_enabled() ? WIENDER_ARRSIZE(msaaAttachments) : WIENDER_ARRSIZE(noMsaaAttachments)),
+                    (is_multisampling_enabled() ? msaaAttachments : noMsaaAttachments),
+                    swapchainSupportInfo_.extent
+                );
+            }
+        }
+        void initialize_headless_images(swapchain_images& imagesToInitialize) const {
+            imagesToInitialize.resize(swapchainSupportInfo_.imageCount);
+            for (auto& swimage : imagesToInitialize) {
+                swimage = {};
+                const vulkan_image image = create_vulkan_image(
+                    swapchainSupportInfo_.extent.width, swapchainSupportInfo_.extent.height,
+                    1,
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    swapchainSupportInfo_.imageFormat.format,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+                swimage.image = image.image;
+                swimage.memory = image.memory;
+                swimage.view = image.view;
+            }
+        }
+        void initialize_swapchain_image_views(swapchain_images& swapchainImagesToInitialize) const {
             uint32_t swapchainImageCount;
             VkImage images[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
 
@@ -998,37 +2745,10 @@ namespace wiender {
             vulkan_check(vkGetSwapchainImagesKHR(ldevice_, swapchain_, &swapchainImageCount, images), "wiender::vulkan_wienderer::initialize_swapchain_images failed to get swapchain images 2");
 
             for (uint32_t i = 0; i < swapchainImageCount; ++i) {
+                swapchainImagesToInitialize[i] = {};
                 swapchainImagesToInitialize[i].image = images[i];
+                swapchainImagesToInitialize[i].view = create_image_view(images[i], swapchainSupportInfo_.imageFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
             }
-
-
-            for (auto& swimage : swapchainImagesToInitialize) {
-                swimage.view = create_image_view(swimage.image, swapchainSupportInfo_.imageFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
-
-                const VkImageView msaaAttachments[] = {colorRenderTarget_.view, swimage.view};
-                const VkImageView noMsaaAttachments[] = {swimage.view};
-
-                swimage.framebuffer = create_framebuffer(
-                    static_cast<uint32_t>(is_multisampling_enabled() ? WIENDER_ARRSIZE(msaaAttachments) : WIENDER_ARRSIZE(noMsaaAttachments)),
-                    (is_multisampling_enabled() ? msaaAttachments : noMsaaAttachments)
-                );
-            }
-        }
-        WIENDER_NODISCARD VkFramebuffer create_framebuffer(uint32_t attachmentCount, const VkImageView* attachments) const {
-            VkFramebufferCreateInfo framebufferCreateInfo{};
-            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-         // framebufferCreateInfo.pNext = nullptr;
-         // framebufferCreateInfo.flags = static_cast<VkFlags>(0);
-            framebufferCreateInfo.renderPass = defaultRenderPass_;
-            framebufferCreateInfo.attachmentCount = attachmentCount;
-            framebufferCreateInfo.pAttachments = attachments;
-            framebufferCreateInfo.width = swapchainSupportInfo_.extent.width;
-            framebufferCreateInfo.height = swapchainSupportInfo_.extent.height;
-            framebufferCreateInfo.layers = 1;
-
-            VkFramebuffer result;
-            vulkan_check(vkCreateFramebuffer(ldevice_, &framebufferCreateInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_framebuffer failed to create framebuffer");
-            return result;
         }
         WIENDER_NODISCARD VkSwapchainKHR create_swapchain() const {
             VkSwapchainCreateInfoKHR swapchainCreateInfo{};
@@ -1058,44 +2778,146 @@ namespace wiender {
         }
 
         public:
-        WIENDER_NODISCARD VkRenderPass create_default_render_pass(VkAttachmentLoadOp loadOp) const {
+        /**
+         * @param withDepth Adds the shared depth attachment, `require_depth_attachment` has to be called before.
+         */
+        WIENDER_NODISCARD VkRenderPass create_default_render_pass(VkAttachmentLoadOp loadOp, bool withDepth = false, VkAttachmentLoadOp depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD) const {
             if (is_multisampling_enabled()) {
-                return create_msaa_render_pass(loadOp);
+                return create_msaa_render_pass(loadOp, withDepth, depthLoadOp);
             } else {
-                return create_no_msaa_render_pass(loadOp);
+                return create_no_msaa_render_pass(loadOp, withDepth, depthLoadOp);
             }
         }
+        /**
+         * @brief Creates the shared depth attachment and framebuffers with it, once.
+         *
+         * Shaders without depth keep rendering into framebuffers without it, so the depth image costs nothing until used.
+         */
+        void require_depth_attachment() {
+            if (depthRenderTarget_.image != 0)
+                return;
+
+            try {
+                require_depth_format();
+                depthRenderTarget_ = create_depth_render_target();
+                depthRenderPass_ = create_default_render_pass(VK_ATTACHMENT_LOAD_OP_DONT_CARE, true, VK_ATTACHMENT_LOAD_OP_DONT_CARE);
+                for (auto& swimage : swapchainImages_) {
+                    const VkImageView msaaAttachments[] = {colorRenderTarget_.view, swimage.view, depthRenderTarget_.view};
+                    const VkImageView noMsaaAttachments[] = {swimage.view, depthRenderTarget_.view};
+
+                    swimage.depthFramebuffer = create_framebuffer(
+                        depthRenderPass_,
+                        static_cast<uint32_t>(is_multisampling_enabled() ? WIENDER_ARRSIZE(msaaAttachments) : WIENDER_ARRSIZE(noMsaaAttachments)),
+                        (is_multisampling_enabled() ? msaaAttachments : noMsaaAttachments),
+                        swapchainSupportInfo_.extent
+                    );
+                }
+            } catch (...) {
+                for (auto& swimage : swapchainImages_) {
+                    if (swimage.depthFramebuffer != 0)
+                        vkDestroyFramebuffer(ldevice_, swimage.depthFramebuffer, WIENDER_ALLOCATOR_NAME);
+                    swimage.depthFramebuffer = 0;
+                }
+                if (depthRenderPass_ != 0)
+                    vkDestroyRenderPass(ldevice_, depthRenderPass_, WIENDER_ALLOCATOR_NAME);
+                depthRenderPass_ = 0;
+                destroy_vulkan_image(depthRenderTarget_);
+                depthRenderTarget_ = {};
+                throw;
+            }
+        }
+        /**
+         * @brief Picks the depth format once, render targets create their own depth images of it.
+         */
+        void require_depth_format() {
+            if (depthFormat_ == VK_FORMAT_UNDEFINED)
+                depthFormat_ = find_depth_format();
+        }
+        WIENDER_NODISCARD VkFormat get_depth_format() const noexcept {
+            return depthFormat_;
+        }
+        WIENDER_NODISCARD VkFormat get_render_target_format(render_target::format targetFormat) const {
+            switch (targetFormat) {
+                case render_target::format::SWAPCHAIN:      return swapchainSupportInfo_.imageFormat.format;
+                case render_target::format::RGBA8_UNORM:    return VK_FORMAT_R8G8B8A8_UNORM;
+                case render_target::format::RGBA16_SFLOAT:  return VK_FORMAT_R16G16B16A16_SFLOAT;
+                default: throw std::runtime_error("wiender::vulkan_wienderer::get_render_target_format unknown render target format");
+            }
+            // unreachable
+        }
+        /**
+         * @brief Rounds a sample count down to a power of two supported for color and depth attachments.
+         */
+        WIENDER_NODISCARD VkSampleCountFlagBits get_render_target_samples(uint32_t samples) const {
+            uint32_t count = 1;
+            while ((count * 2 <= samples) && (count < VK_SAMPLE_COUNT_64_BIT))
+                count *= 2;
+            return get_max_usable_sample_count(static_cast<VkSampleCountFlagBits>(count));
+        }
+        WIENDER_NODISCARD VkFramebuffer create_framebuffer(VkRenderPass renderPass, uint32_t attachmentCount, const VkImageView* attachments, VkExtent2D extent) const {
+            VkFramebufferCreateInfo framebufferCreateInfo{};
+            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+         // framebufferCreateInfo.pNext = nullptr;
+         // framebufferCreateInfo.flags = static_cast<VkFlags>(0);
+            framebufferCreateInfo.renderPass = renderPass;
+            framebufferCreateInfo.attachmentCount = attachmentCount;
+            framebufferCreateInfo.pAttachments = attachments;
+            framebufferCreateInfo.width = extent.width;
+            framebufferCreateInfo.height = extent.height;
+            framebufferCreateInfo.layers = 1;
+
+            VkFramebuffer result;
+            vulkan_check(vkCreateFramebuffer(ldevice_, &framebufferCreateInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_framebuffer failed to create framebuffer");
+            return result;
+        }
+        /**
+         * @brief Creates a render pass drawing into a render target.
+         *
+         * The sampled image is shader-readable before and after the pass, a multisampled color image stays
+         * a color attachment between passes. Reads of the target by earlier passes finish before the pass writes it,
+         * its writes are visible to fragment shaders of later passes.
+         * @param loadOp `VK_ATTACHMENT_LOAD_OP_LOAD` keeps the target content.
+         * @param withDepth Adds a depth attachment of `get_depth_format`, `require_depth_format` has to be called before.
+         */
+        WIENDER_NODISCARD VkRenderPass create_target_render_pass(VkFormat format, VkSampleCountFlagBits samples, VkAttachmentLoadOp loadOp, bool withDepth, VkAttachmentLoadOp depthLoadOp) const {
+            const bool multisampled = (samples != VK_SAMPLE_COUNT_1_BIT);
+            const VkImageLayout colorLayout = multisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // between passes
 
-        private:
-        WIENDER_NODISCARD VkRenderPass create_no_msaa_render_pass(VkAttachmentLoadOp loadOp) const {
             VkAttachmentDescription colorAttachment{};
          // colorAttachment.flags = static_cast<VkFlags>(0);
-            colorAttachment.format = swapchainSupportInfo_.imageFormat.format;
-            colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.format = format;
+            colorAttachment.samples = samples;
+            colorAttachment.loadOp = loadOp;
             colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
             colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-         // VkAttachmentDescription depthAttachment{}; TODO
-         // depthAttachment.format = findDepthFormat();
-         // depthAttachment.samples = get_msaa_samples();
-         // depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-         // depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-         // depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-         // depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-         // depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-         // depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            colorAttachment.initialLayout = (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) ? colorLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+            colorAttachment.finalLayout = colorLayout;
+
+            VkAttachmentDescription colorAttachmentResolve{};
+         // colorAttachmentResolve.flags = static_cast<VkFlags>(0);
+            colorAttachmentResolve.format = format;
+            colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachmentResolve.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachmentResolve.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+            const VkAttachmentDescription depthAttachment = create_depth_attachment_description(depthLoadOp, samples);
 
             VkAttachmentReference colorAttachmentRef{};
             colorAttachmentRef.attachment = 0;
             colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-         // VkAttachmentReference depthAttachmentRef{};
-         // depthAttachmentRef.attachment = 1;
-         // depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            VkAttachmentReference colorAttachmentResolveRef{};
+            colorAttachmentResolveRef.attachment = 1;
+            colorAttachmentResolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = multisampled ? 2 : 1;
+            depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
             VkSubpassDescription subpass{};
          // subpass.flags = static_cast<VkFlags>(0);
@@ -1104,60 +2926,243 @@ namespace wiender {
          // subpass.pInputAttachments = 0;
             subpass.colorAttachmentCount = 1;
             subpass.pColorAttachments = &colorAttachmentRef;
-            subpass.pResolveAttachments = nullptr;
-         // subpass.pDepthStencilAttachment = nullptr;
+            subpass.pResolveAttachments = multisampled ? &colorAttachmentResolveRef : nullptr;
+            subpass.pDepthStencilAttachment = withDepth ? &depthAttachmentRef : nullptr;
          // subpass.preserveAttachmentCount = 0;
          // subpass.pPreserveAttachments = nullptr;
 
-            VkSubpassDependency dependency{};
-            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-         // dependency.dstSubpass = 0;
-            dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-            dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-         // dependency.srcAccessMask = 0;
-            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-         // dependency.dependencyFlags = static_cast<VkDependencyFlags>(0);
-
-            const VkAttachmentDescription attachments[] = { colorAttachment };
+            VkSubpassDependency dependencies[2]{};
+            dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+         // dependencies[0].dstSubpass = 0;
+            dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+            dependencies[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+         // dependencies[0].dependencyFlags = static_cast<VkDependencyFlags>(0);
+            if (withDepth)
+                add_depth_dependency(dependencies[0]);
+
+         // dependencies[1].srcSubpass = 0;
+            dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+         // dependencies[1].dependencyFlags = static_cast<VkDependencyFlags>(0);
+
+            VkAttachmentDescription attachments[3] = { colorAttachment, colorAttachmentResolve, depthAttachment };
+            uint32_t attachmentCount = multisampled ? 2u : 1u;
+            if (withDepth)
+                attachments[attachmentCount++] = depthAttachment;
 
             VkRenderPassCreateInfo renderPassCreateInfo{};
             renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
          // renderPassCreateInfo.pNext = nullptr;
          // renderPassCreateInfo.flags = static_cast<VkFlags>(0);
-            renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(WIENDER_ARRSIZE(attachments));
+            renderPassCreateInfo.attachmentCount = attachmentCount;
             renderPassCreateInfo.pAttachments = attachments;
             renderPassCreateInfo.subpassCount = 1;
             renderPassCreateInfo.pSubpasses = &subpass;
-            renderPassCreateInfo.dependencyCount = 1;
-            renderPassCreateInfo.pDependencies = &dependency;
+            renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(WIENDER_ARRSIZE(dependencies));
+            renderPassCreateInfo.pDependencies = dependencies;
 
             VkRenderPass newRenderPass;
-            vulkan_check(vkCreateRenderPass(ldevice_, &renderPassCreateInfo, WIENDER_ALLOCATOR_NAME, &newRenderPass), "wiender::vulkan_wienderer::create_msaa_render_pass failed to create render pass");
+            vulkan_check(vkCreateRenderPass(ldevice_, &renderPassCreateInfo, WIENDER_ALLOCATOR_NAME, &newRenderPass), "wiender::vulkan_wienderer::create_target_render_pass failed to create render pass");
             return newRenderPass;
         }
-        WIENDER_NODISCARD VkRenderPass create_msaa_render_pass(VkAttachmentLoadOp loadOp) const {
-            VkAttachmentDescription colorAttachment{};
-         // colorAttachment.flags = static_cast<VkFlags>(0);
-            colorAttachment.format = swapchainSupportInfo_.imageFormat.format;
-            colorAttachment.samples = get_msaa_samples();
-            colorAttachment.loadOp = loadOp;
-            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-            colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        /**
+         * @brief Creates the render pass of a post-process chain, see `postprocess_chain`.
+         *
+         * Attachments are the window image, the first intermediate, the second one with two or more post subpasses
+         * and the depth image if used. Subpass n > 0 reads intermediate (n - 1) % 2 as an input attachment and writes
+         * intermediate n % 2, the last one writes the window. Intermediates and depth are never loaded or stored,
+         * so tiled GPUs keep them in tile memory, and the by-region dependencies let every tile run the whole chain.
+         * @param subpassCount Scene subpass included.
+         * @param withDepth Adds a depth attachment of `get_depth_format` to the scene subpass, `require_depth_format` has to be called before.
+         */
+        WIENDER_NODISCARD VkRenderPass create_postprocess_render_pass(VkFormat intermediateFormat, uint32_t subpassCount, bool withDepth) const {
+            wiender_assert(subpassCount >= 2, "wiender::vulkan_wienderer::create_postprocess_render_pass chain needs at least one post subpass");
+            const uint32_t intermediateCount = (subpassCount > 2) ? 2u : 1u;
+            const uint32_t depthIndex = 1 + intermediateCount;
+
+            VkAttachmentDescription attachments[4]{};
+            attachments[0].format = swapchainSupportInfo_.imageFormat.format;
+            attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+            attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // the last subpass covers the window
+            attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            attachments[0].finalLayout = get_window_final_layout();
+            for (uint32_t i = 1; i <= intermediateCount; ++i) {
+             // attachments[i].flags = static_cast<VkFlags>(0);
+                attachments[i].format = intermediateFormat;
+                attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+                attachments[i].loadOp = (i == 1) ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE; // the scene is drawn into the first one
+                attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[i].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+                attachments[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            }
+            if (withDepth) {
+                attachments[depthIndex] = create_depth_attachment_description(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_SAMPLE_COUNT_1_BIT);
+                attachments[depthIndex].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+                attachments[depthIndex].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            }
 
-            // VkAttachmentDescription depthAttachment{}; TODO
-            // depthAttachment.format = findDepthFormat();
-            // depthAttachment.samples = get_msaa_samples();
-            // depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-            // depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            // depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-            // depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-            // depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            // depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = depthIndex;
+            depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            std::vector<VkAttachmentReference> colorAttachmentRefs(subpassCount);
+            std::vector<VkAttachmentReference> inputAttachmentRefs(subpassCount);
+            std::vector<VkSubpassDescription> subpasses(subpassCount);
+            for (uint32_t i = 0; i < subpassCount; ++i) {
+                colorAttachmentRefs[i].attachment = (i + 1 == subpassCount) ? 0u : 1u + i % 2;
+                colorAttachmentRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+                inputAttachmentRefs[i].attachment = 1u + (i + 1) % 2; // (i - 1) % 2 without wrapping
+                inputAttachmentRefs[i].layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+             // subpasses[i].flags = static_cast<VkFlags>(0);
+                subpasses[i].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+                subpasses[i].inputAttachmentCount = (i != 0) ? 1u : 0u;
+                subpasses[i].pInputAttachments = (i != 0) ? &inputAttachmentRefs[i] : nullptr;
+                subpasses[i].colorAttachmentCount = 1;
+                subpasses[i].pColorAttachments = &colorAttachmentRefs[i];
+             // subpasses[i].pResolveAttachments = nullptr;
+                subpasses[i].pDepthStencilAttachment = ((i == 0) && withDepth) ? &depthAttachmentRef : nullptr;
+             // subpasses[i].preserveAttachmentCount = 0;
+             // subpasses[i].pPreserveAttachments = nullptr;
+            }
 
-            VkAttachmentDescription colorAttachmentResolve{};
+            // intermediates and depth are shared by frames in flight, the previous frame finishes reading them first
+            std::vector<VkSubpassDependency> dependencies(subpassCount + 1);
+            dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+         // dependencies[0].dstSubpass = 0;
+            dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+         // dependencies[0].srcAccessMask = 0;
+            dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+         // dependencies[0].dependencyFlags = static_cast<VkDependencyFlags>(0);
+            if (withDepth)
+                add_depth_dependency(dependencies[0]);
+
+            // the window image is first used by the last subpass, its layout transition waits for the acquire there
+            dependencies[1].srcSubpass = VK_SUBPASS_EXTERNAL;
+            dependencies[1].dstSubpass = subpassCount - 1;
+            dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+            dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+         // dependencies[1].srcAccessMask = 0;
+            dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+         // dependencies[1].dependencyFlags = static_cast<VkDependencyFlags>(0);
+
+            // color of the previous subpass is read at the same pixel, the intermediate read before is overwritten
+            for (uint32_t i = 1; i < subpassCount; ++i) {
+                VkSubpassDependency& dependency = dependencies[i + 1];
+                dependency.srcSubpass = i - 1;
+                dependency.dstSubpass = i;
+                dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+                dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+                dependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+                dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+            }
+
+            VkRenderPassCreateInfo renderPassCreateInfo{};
+            renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+         // renderPassCreateInfo.pNext = nullptr;
+         // renderPassCreateInfo.flags = static_cast<VkFlags>(0);
+            renderPassCreateInfo.attachmentCount = depthIndex + (withDepth ? 1u : 0u);
+            renderPassCreateInfo.pAttachments = attachments;
+            renderPassCreateInfo.subpassCount = subpassCount;
+            renderPassCreateInfo.pSubpasses = subpasses.data();
+            renderPassCreateInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+            renderPassCreateInfo.pDependencies = dependencies.data();
+
+            VkRenderPass newRenderPass;
+            vulkan_check(vkCreateRenderPass(ldevice_, &renderPassCreateInfo, WIENDER_ALLOCATOR_NAME, &newRenderPass), "wiender::vulkan_wienderer::create_postprocess_render_pass failed to create render pass");
+            return newRenderPass;
+        }
+
+        private:
+        WIENDER_NODISCARD VkRenderPass create_no_msaa_render_pass(VkAttachmentLoadOp loadOp, bool withDepth, VkAttachmentLoadOp depthLoadOp) const {
+            VkAttachmentDescription colorAttachment{};
+         // colorAttachment.flags = static_cast<VkFlags>(0);
+            colorAttachment.format = swapchainSupportInfo_.imageFormat.format;
+            colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            colorAttachment.finalLayout = get_window_final_layout();
+
+            const VkAttachmentDescription depthAttachment = create_depth_attachment_description(depthLoadOp, get_msaa_samples());
+
+            VkAttachmentReference colorAttachmentRef{};
+            colorAttachmentRef.attachment = 0;
+            colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 1;
+            depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+            VkSubpassDescription subpass{};
+         // subpass.flags = static_cast<VkFlags>(0);
+            subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+         // subpass.inputAttachmentCount = 0;
+         // subpass.pInputAttachments = 0;
+            subpass.colorAttachmentCount = 1;
+            subpass.pColorAttachments = &colorAttachmentRef;
+            subpass.pResolveAttachments = nullptr;
+            subpass.pDepthStencilAttachment = withDepth ? &depthAttachmentRef : nullptr;
+         // subpass.preserveAttachmentCount = 0;
+         // subpass.pPreserveAttachments = nullptr;
+
+            VkSubpassDependency dependency{};
+            dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+         // dependency.dstSubpass = 0;
+            dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+            dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+         // dependency.srcAccessMask = 0;
+            dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+         // dependency.dependencyFlags = static_cast<VkDependencyFlags>(0);
+            if (withDepth)
+                add_depth_dependency(dependency);
+
+            const VkAttachmentDescription attachments[] = { colorAttachment, depthAttachment };
+
+            VkRenderPassCreateInfo renderPassCreateInfo{};
+            renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+         // renderPassCreateInfo.pNext = nullptr;
+         // renderPassCreateInfo.flags = static_cast<VkFlags>(0);
+            renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(WIENDER_ARRSIZE(attachments)) - (withDepth ? 0u : 1u);
+            renderPassCreateInfo.pAttachments = attachments;
+            renderPassCreateInfo.subpassCount = 1;
+            renderPassCreateInfo.pSubpasses = &subpass;
+            renderPassCreateInfo.dependencyCount = 1;
+            renderPassCreateInfo.pDependencies = &dependency;
+
+            VkRenderPass newRenderPass;
+            vulkan_check(vkCreateRenderPass(ldevice_, &renderPassCreateInfo, WIENDER_ALLOCATOR_NAME, &newRenderPass), "wiender::vulkan_wienderer::create_msaa_render_pass failed to create render pass");
+            return newRenderPass;
+        }
+        WIENDER_NODISCARD VkRenderPass create_msaa_render_pass(VkAttachmentLoadOp loadOp, bool withDepth, VkAttachmentLoadOp depthLoadOp) const {
+            VkAttachmentDescription colorAttachment{};
+         // colorAttachment.flags = static_cast<VkFlags>(0);
+            colorAttachment.format = swapchainSupportInfo_.imageFormat.format;
+            colorAttachment.samples = get_msaa_samples();
+            colorAttachment.loadOp = loadOp;
+            colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            const VkAttachmentDescription depthAttachment = create_depth_attachment_description(depthLoadOp, get_msaa_samples());
+
+            VkAttachmentDescription colorAttachmentResolve{};
          // colorAttachment.flags = static_cast<VkFlags>(0);
             colorAttachmentResolve.format = swapchainSupportInfo_.imageFormat.format;
             colorAttachmentResolve.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -1166,15 +3171,15 @@ namespace wiender {
             colorAttachmentResolve.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             colorAttachmentResolve.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
             colorAttachmentResolve.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            colorAttachmentResolve.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            colorAttachmentResolve.finalLayout = get_window_final_layout();
 
             VkAttachmentReference colorAttachmentRef{};
             colorAttachmentRef.attachment = 0;
             colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-            // VkAttachmentReference depthAttachmentRef{};
-            // depthAttachmentRef.attachment = 1;
-            // depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            VkAttachmentReference depthAttachmentRef{};
+            depthAttachmentRef.attachment = 2;
+            depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
             VkAttachmentReference colorAttachmentResolveRef{};
             colorAttachmentResolveRef.attachment = 1;
@@ -1188,7 +3193,7 @@ namespace wiender {
             subpass.colorAttachmentCount = 1;
             subpass.pColorAttachments = &colorAttachmentRef;
             subpass.pResolveAttachments = &colorAttachmentResolveRef;
-         // subpass.pDepthStencilAttachment = nullptr;
+            subpass.pDepthStencilAttachment = withDepth ? &depthAttachmentRef : nullptr;
          // subpass.preserveAttachmentCount = 0;
          // subpass.pPreserveAttachments = nullptr;
 
@@ -1200,14 +3205,16 @@ namespace wiender {
          // dependency.srcAccessMask = 0;
             dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
          // dependency.dependencyFlags = static_cast<VkDependencyFlags>(0);
+            if (withDepth)
+                add_depth_dependency(dependency);
 
-            const VkAttachmentDescription attachments[] = { colorAttachment, colorAttachmentResolve };
+            const VkAttachmentDescription attachments[] = { colorAttachment, colorAttachmentResolve, depthAttachment };
 
             VkRenderPassCreateInfo renderPassCreateInfo{};
             renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
          // renderPassCreateInfo.pNext = nullptr;
          // renderPassCreateInfo.flags = static_cast<VkFlags>(0);
-            renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(WIENDER_ARRSIZE(attachments));
+            renderPassCreateInfo.attachmentCount = static_cast<uint32_t>(WIENDER_ARRSIZE(attachments)) - (withDepth ? 0u : 1u);
             renderPassCreateInfo.pAttachments = attachments;
             renderPassCreateInfo.subpassCount = 1;
             renderPassCreateInfo.pSubpasses = &subpass;
@@ -1219,7 +3226,63 @@ namespace wiender {
             return newRenderPass;
         }
 
+        WIENDER_NODISCARD VkAttachmentDescription create_depth_attachment_description(VkAttachmentLoadOp depthLoadOp, VkSampleCountFlagBits samples) const {
+            VkAttachmentDescription depthAttachment{};
+         // depthAttachment.flags = static_cast<VkFlags>(0);
+            depthAttachment.format = depthFormat_;
+            depthAttachment.samples = samples;
+            depthAttachment.loadOp = depthLoadOp;
+            depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; // next render passes of the frame may load it
+            depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; // the image never leaves it
+            depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            return depthAttachment;
+        }
+        static void add_depth_dependency(VkSubpassDependency& dependency) noexcept {
+            // depth written by the previous render pass is tested by this one
+            dependency.srcStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.dstStageMask |= VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+            dependency.srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            dependency.dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+        }
+
         private:
+        WIENDER_NODISCARD VkImageLayout get_window_final_layout() const noexcept {
+            return headless_ ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; // headless images are only copied out
+        }
+        WIENDER_NODISCARD VkFramebuffer get_framebuffer(uint32_t imageIndex, const active_shader_state& shaderState) const noexcept {
+            return shaderState.depthAttachment ? swapchainImages_[imageIndex].depthFramebuffer : swapchainImages_[imageIndex].framebuffer;
+        }
+        WIENDER_NODISCARD VkFormat find_depth_format() const {
+            // depth-only formats, VK_FORMAT_D16_UNORM is supported everywhere
+            const VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM };
+            for (const VkFormat candidate : candidates) {
+                VkFormatProperties formatProperties{};
+                vkGetPhysicalDeviceFormatProperties(pdevice_, candidate, &formatProperties);
+                if ((formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) != 0)
+                    return candidate;
+            }
+            throw std::runtime_error("wiender::vulkan_wienderer::find_depth_format no supported depth format");
+        }
+        WIENDER_NODISCARD vulkan_image create_depth_render_target() const {
+            vulkan_image result = create_vulkan_image(
+                swapchainSupportInfo_.extent.width, swapchainSupportInfo_.extent.height,
+                1,
+                VK_IMAGE_ASPECT_DEPTH_BIT,
+                get_msaa_samples(),
+                depthFormat_,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            );
+
+            VkCommandBuffer cmdbuff = begin_single_time_commands();
+            transition_image_layout(cmdbuff, result.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            end_single_time_commands(cmdbuff);
+
+            return result;
+        }
         WIENDER_NODISCARD vulkan_image create_color_render_target() const {
             return create_vulkan_image(
                 swapchainSupportInfo_.extent.width, swapchainSupportInfo_.extent.height,
@@ -1232,6 +3295,19 @@ namespace wiender {
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
         }
+        WIENDER_NODISCARD swapchain_support_info create_headless_swapchain_info(VkExtent2D extent) const {
+            const auto& limits = pdevice_.properties.properties.limits;
+            wiender_assert((extent.width > 0) && (extent.height > 0), "wiender::vulkan_wienderer::create_headless_swapchain_info extent cannot be zero");
+            wiender_assert((extent.width <= limits.maxFramebufferWidth) && (extent.height <= limits.maxFramebufferHeight), "wiender::vulkan_wienderer::create_headless_swapchain_info extent exceeds framebuffer limits");
+
+            swapchain_support_info newSwapchainSupportInfo{};
+            newSwapchainSupportInfo.imageFormat = { VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR }; // supported as color attachment everywhere
+            newSwapchainSupportInfo.surfaceFormat = newSwapchainSupportInfo.imageFormat;
+            newSwapchainSupportInfo.presentMode = VK_PRESENT_MODE_IMMEDIATE_KHR; // nothing is presented
+            newSwapchainSupportInfo.extent = extent;
+            newSwapchainSupportInfo.imageCount = WIENDER_HEADLESS_IMAGE_COUNT;
+            return newSwapchainSupportInfo;
+        }
         WIENDER_NODISCARD swapchain_support_info create_swapchain_info() const {
             swapchain_support_info newSwapchainSupportInfo;
             vulkan_check(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(pdevice_, surface_, &newSwapchainSupportInfo.capabilities), "wiender::vulkan_wienderer::create_swapchain_info failed to get physical device surface capabilities");
@@ -1329,6 +3405,12 @@ namespace wiender {
             return queueIndeces;
         }
         WIENDER_NODISCARD logical_device_info create_logical_device() const {
+            std::vector<const char*> deviceExtensions(stConstants.deviceExtensions + (context_->headless ? 1 : 0), stConstants.deviceExtensions + WIENDER_ARRSIZE(stConstants.deviceExtensions));
+            if (pdevice_.graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE)
+                deviceExtensions.insert(deviceExtensions.end(), stConstants.pipelineLibraryExtensions, stConstants.pipelineLibraryExtensions + WIENDER_ARRSIZE(stConstants.pipelineLibraryExtensions));
+            if (pdevice_.drawIndirectCount)
+                deviceExtensions.insert(deviceExtensions.end(), stConstants.drawIndirectCountExtensions, stConstants.drawIndirectCountExtensions + WIENDER_ARRSIZE(stConstants.drawIndirectCountExtensions));
+
             VkDeviceQueueCreateInfo queueCreateInfos[2];
 
             const float queuePriorities[] =  { 1.0f };
@@ -1350,18 +3432,34 @@ namespace wiender {
             deviceInfo.pQueueCreateInfos = queueCreateInfos;
             deviceInfo.enabledLayerCount = 0;
             deviceInfo.ppEnabledLayerNames = nullptr;
-            deviceInfo.enabledExtensionCount = static_cast<uint32_t>(WIENDER_ARRSIZE(stConstants.deviceExtensions));
-            deviceInfo.ppEnabledExtensionNames =  stConstants.deviceExtensions;
+            deviceInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
+            deviceInfo.ppEnabledExtensionNames = deviceExtensions.data();
             deviceInfo.pEnabledFeatures = nullptr;
 
             logical_device_info result{};
             vulkan_check(vkCreateDevice(pdevice_, &deviceInfo, WIENDER_ALLOCATOR_NAME, &result.device), "wiender::vulkan_wienderer::create_logical_device failed to create logical device");
             vkGetDeviceQueue(result.device, pdevice_.queueIndeces.graphicsFamily, 0, &result.graphicsQueue);
             vkGetDeviceQueue(result.device, pdevice_.queueIndeces.presentFamily, 0, &result.presentQueue);
+            if (pdevice_.drawIndirectCount) { // extension commands aren't exported by the loader
+                result.cmdDrawIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndirectCountKHR>(vkGetDeviceProcAddr(result.device, "vkCmdDrawIndirectCountKHR"));
+                result.cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(result.device, "vkCmdDrawIndexedIndirectCountKHR"));
+            }
 
             return result;
 
         }
+        WIENDER_NODISCARD VkPipelineCache create_pipeline_cache() const {
+            VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+            pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+         // pipelineCacheCreateInfo.pNext = nullptr;
+         // pipelineCacheCreateInfo.flags = static_cast<VkFlags>(0);
+         // pipelineCacheCreateInfo.initialDataSize = 0;
+         // pipelineCacheCreateInfo.pInitialData = nullptr;
+
+            VkPipelineCache result;
+            vulkan_check(vkCreatePipelineCache(ldevice_, &pipelineCacheCreateInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_pipeline_cache failed to create pipeline cache");
+            return result;
+        }
         WIENDER_NODISCARD VkSampleCountFlagBits get_max_usable_sample_count(VkSampleCountFlagBits target) const {
             const auto& properties = pdevice_.properties.properties;
 
@@ -1394,15 +3492,17 @@ namespace wiender {
             appInfo.pApplicationName = "_";
             appInfo.engineVersion = VK_MAKE_VERSION(0, 1, 0);
             appInfo.pEngineName = "wiender";
-            appInfo.apiVersion = VK_API_VERSION_1_0;
+            appInfo.apiVersion = VK_API_VERSION_1_1; // vkGetPhysicalDeviceFeatures2
 
             VkInstanceCreateInfo instanceInfo{};
             instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
             instanceInfo.pApplicationInfo = &appInfo;
             instanceInfo.enabledLayerCount = static_cast<uint32_t>(WIENDER_ARRSIZE(stConstants.validationLayers) - (validationEnable_ ? 0u : 1u));
             instanceInfo.ppEnabledLayerNames = stConstants.validationLayers;
-            instanceInfo.enabledExtensionCount = static_cast<uint32_t>(WIENDER_ARRSIZE(stConstants.instanceExtensions) - (validationEnable_ ? 0u : 1u));
-            instanceInfo.ppEnabledExtensionNames = stConstants.instanceExtensions;
+            // debug utils go last in both lists
+            const std::size_t extensionCount = context_->headless ? WIENDER_ARRSIZE(stConstants.headlessInstanceExtensions) : WIENDER_ARRSIZE(stConstants.instanceExtensions);
+            instanceInfo.enabledExtensionCount = static_cast<uint32_t>(extensionCount - (validationEnable_ ? 0u : 1u));
+            instanceInfo.ppEnabledExtensionNames = context_->headless ? stConstants.headlessInstanceExtensions : stConstants.instanceExtensions;
 
             VkInstance result;
             vulkan_check(vkCreateInstance(&instanceInfo, WIENDER_ALLOCATOR_NAME, &result), "wiender::vulkan_wienderer::create_vulkan_instance failed to create vulkan instance");
@@ -1425,7 +3525,10 @@ namespace wiender {
                     indices.graphicsFamily = i;
 
                 VkBool32 presentSupport = false;
-                vulkan_check(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport), "wiender::vulkan_wienderer::find_queue_families failed to get surface support");
+                if (surface == VK_NULL_HANDLE) // headless, the graphics queue stands in for the present one
+                    presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+                else
+                    vulkan_check(vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport), "wiender::vulkan_wienderer::find_queue_families failed to get surface support");
                 if (presentSupport)
                     indices.presentFamily = i;
 
@@ -1480,26 +3583,86 @@ namespace wiender {
             }
             wiender_assert(bestDeviceScore > 0, "wiender::vulkan_wienderer::choose_best_physical_device physical device not found");
 
-            bestDevice.indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES; // TODO: feature check
-            bestDevice.indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
-            bestDevice.features.pNext = &bestDevice.indexingFeatures;
-
             return bestDevice;
         }
+        WIENDER_NODISCARD static bool is_device_extension_supported(VkPhysicalDevice device, const char* extensionName) {
+            uint32_t extensionCount = 0;
+            vulkan_check(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr), "wiender::vulkan_wienderer::is_device_extension_supported failed to enumerate device extensions 1");
+            std::vector<VkExtensionProperties> extensions(extensionCount);
+            vulkan_check(vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data()), "wiender::vulkan_wienderer::is_device_extension_supported failed to enumerate device extensions 2");
+
+            for (const auto& extension : extensions) {
+                if (strcmp(extension.extensionName, extensionName) == 0)
+                    return true;
+            }
+            return false;
+        }
+        static void initialize_device_features(physical_device_info& info) { // info.features chain points into info, so it is built in place
+            VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexingFeatures{};
+            supportedIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            VkPhysicalDeviceFeatures2 indexingQuery{};
+            indexingQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            indexingQuery.pNext = &supportedIndexingFeatures;
+            vkGetPhysicalDeviceFeatures2(info.device, &indexingQuery);
+
+            info.indexingProperties = {};
+            info.indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+            VkPhysicalDeviceProperties2 propertiesQuery{};
+            propertiesQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            propertiesQuery.pNext = &info.indexingProperties;
+            vkGetPhysicalDeviceProperties2(info.device, &propertiesQuery);
+            info.indexingProperties.pNext = nullptr;
+
+            info.indexingFeatures = {};
+            info.indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+            info.indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            info.indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = supportedIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind; // optional, see vulkan_descriptor_set::bind_buffer
+            const bool bindlessTextures =
+                (supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind == VK_TRUE) &&
+                (supportedIndexingFeatures.descriptorBindingPartiallyBound == VK_TRUE) &&
+                (supportedIndexingFeatures.runtimeDescriptorArray == VK_TRUE) &&
+                (supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing == VK_TRUE) &&
+                (info.properties.properties.limits.maxBoundDescriptorSets > WIENDER_BINDLESS_TEXTURE_SET) &&
+                (info.indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages >= WIENDER_BINDLESS_TEXTURE_MAX_COUNT) &&
+                (info.indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages >= WIENDER_BINDLESS_TEXTURE_MAX_COUNT);
+            if (bindlessTextures) {
+                info.indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+                info.indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+                info.indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+            }
+            info.features.pNext = &info.indexingFeatures;
+
+            info.graphicsPipelineLibraryFeatures = {};
+            info.graphicsPipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+            if (is_device_extension_supported(info.device, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) && is_device_extension_supported(info.device, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+                VkPhysicalDeviceFeatures2 query{};
+                query.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                query.pNext = &info.graphicsPipelineLibraryFeatures;
+                vkGetPhysicalDeviceFeatures2(info.device, &query);
+            }
+            if (info.graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE)
+                info.indexingFeatures.pNext = &info.graphicsPipelineLibraryFeatures;
+
+            info.drawIndirectCount = is_device_extension_supported(info.device, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
 
     };
+    std::unique_ptr<wienderer> create_vulkan_wienderer(std::shared_ptr<vulkan_context> context, const window_handle* whandle, VkExtent2D headlessExtent) {
+        return std::unique_ptr<vulkan_wienderer>(new vulkan_wienderer(std::move(context), whandle, headlessExtent));
+    }
 
-    struct cpu_side_buffer final : public buffer {
+    struct cpu_side_buffer final : public vulkan_buffer {
         private:
         vulkan_wienderer* owner_;
         VkDeviceMemory CPUMemory_;
         VkBuffer CPUBuffer_;
         std::size_t size_;
         VkBufferUsageFlags usage_;
+        VkIndexType indexType_; // for index buffers only
         bool mappedFlag_;
 
         public:
-        cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage) : owner_(owner), CPUMemory_{}, CPUBuffer_{}, size_(sizeb), usage_(usage), mappedFlag_(false) {
+        cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType) : owner_(owner), CPUMemory_{}, CPUBuffer_{}, size_(sizeb), usage_(usage), indexType_(indexType), mappedFlag_(false) {
             wiender_assert(owner_ != nullptr, "wiender::cpu_side_buffer::cpu_side_buffer owner cannot be nullptr");
 
             try {
@@ -1521,12 +3684,21 @@ namespace wiender {
         WIENDER_NODISCARD bool is_mapped() const noexcept override {
             return mappedFlag_;
         }
+        WIENDER_NODISCARD VkBuffer get_buffer() const noexcept override {
+            return CPUBuffer_;
+        }
+        WIENDER_NODISCARD std::size_t get_size() const noexcept override {
+            return size_;
+        }
+        WIENDER_NODISCARD VkBufferUsageFlags get_usage() const noexcept override {
+            return usage_;
+        }
         void bind() override {
             if (usage_ & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
-                owner_->bind_vertex_buffer_state(create_buffer_state());
+                owner_->get_recorder()->bind_vertex_buffer_state(create_buffer_state());
             }
             if (usage_ & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
-                owner_->bind_index_buffer_state(create_buffer_state());
+                owner_->get_recorder()->bind_index_buffer_state(create_buffer_state());
             }
         }
         void* map() override  {
@@ -1547,7 +3719,7 @@ namespace wiender {
 
         private:
         WIENDER_NODISCARD binded_buffer_state create_buffer_state() const {
-            return binded_buffer_state{ CPUBuffer_ };
+            return binded_buffer_state{ CPUBuffer_, 0, 0, indexType_ };
         }
 
         private:
@@ -1587,13 +3759,13 @@ namespace wiender {
             return result;
         }
     };
-    WIENDER_NODISCARD std::unique_ptr<buffer> create_cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage) {
-        return std::unique_ptr<cpu_side_buffer>(new cpu_side_buffer(owner, sizeb, usage));
+    WIENDER_NODISCARD std::unique_ptr<buffer> create_cpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType) {
+        return std::unique_ptr<cpu_side_buffer>(new cpu_side_buffer(owner, sizeb, usage, indexType));
     }
 
 
 
-    struct gpu_side_buffer final : public buffer {
+    struct gpu_side_buffer final : public vulkan_buffer {
         private:
         vulkan_wienderer* owner_;
         VkDeviceMemory GPUMemory_;
@@ -1602,10 +3774,11 @@ namespace wiender {
         VkBuffer stagingBuffer_;
         std::size_t size_;
         VkBufferUsageFlags usage_;
+        VkIndexType indexType_; // for index buffers only
         bool mappedFlag_;
 
         public:
-        gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage) : owner_(owner), GPUMemory_{}, GPUBuffer_{}, stagingMemory_{}, stagingBuffer_{}, size_(sizeb), usage_(usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT), mappedFlag_(false) {
+        gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType) : owner_(owner), GPUMemory_{}, GPUBuffer_{}, stagingMemory_{}, stagingBuffer_{}, size_(sizeb), usage_(usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT), indexType_(indexType), mappedFlag_(false) {
             wiender_assert(owner_ != nullptr, "wiender::gpu_side_buffer::gpu_side_buffer owner cannot be nullptr");
 
             try {
@@ -1627,12 +3800,21 @@ namespace wiender {
         WIENDER_NODISCARD bool is_mapped() const noexcept override {
             return mappedFlag_;
         }
+        WIENDER_NODISCARD VkBuffer get_buffer() const noexcept override {
+            return GPUBuffer_;
+        }
+        WIENDER_NODISCARD std::size_t get_size() const noexcept override {
+            return size_;
+        }
+        WIENDER_NODISCARD VkBufferUsageFlags get_usage() const noexcept override {
+            return usage_;
+        }
         void bind() override {
             if (usage_ & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
-                owner_->bind_vertex_buffer_state(create_buffer_state());
+                owner_->get_recorder()->bind_vertex_buffer_state(create_buffer_state());
             }
             if (usage_ & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
-                owner_->bind_index_buffer_state(create_buffer_state());
+                owner_->get_recorder()->bind_index_buffer_state(create_buffer_state());
             }
         }
         void* map() override  {
@@ -1661,7 +3843,7 @@ namespace wiender {
 
         private:
         WIENDER_NODISCARD binded_buffer_state create_buffer_state() const {
-            return binded_buffer_state{ GPUBuffer_ };
+            return binded_buffer_state{ GPUBuffer_, 0, 0, indexType_ };
         }
 
         private:
@@ -1731,11 +3913,11 @@ namespace wiender {
             return result;
         }
     };
-    std::unique_ptr<buffer> create_gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage) {
-        return std::unique_ptr<gpu_side_buffer>(new gpu_side_buffer(owner, sizeb, usage));
+    std::unique_ptr<buffer> create_gpu_side_buffer(vulkan_wienderer* owner, std::size_t sizeb, VkBufferUsageFlags usage, VkIndexType indexType) {
+        return std::unique_ptr<gpu_side_buffer>(new gpu_side_buffer(owner, sizeb, usage, indexType));
     }
 
-    struct image_texture : public texture {
+    struct image_texture : public texture, public vulkan_sampled_image {
         public:
         vulkan_wienderer* owner_;
         vulkan_image image_;
@@ -1743,6 +3925,7 @@ namespace wiender {
         VkDeviceMemory stagingMemory_;
         VkBuffer stagingBuffer_;
         VkExtent3D extent_;
+        uint32_t bindlessIndex_;
 
         public:
         image_texture(vulkan_wienderer* owner, const create_info& createInfo) 
@@ -1751,7 +3934,8 @@ namespace wiender {
                 sampler_{},
                 stagingMemory_{},
                 stagingBuffer_{},
-                extent_{ createInfo.textureExtent.width, createInfo.textureExtent.height, createInfo.textureExtent.depth } {
+                extent_{ createInfo.textureExtent.width, createInfo.textureExtent.height, createInfo.textureExtent.depth },
+                bindlessIndex_(invalidBindlessIndex) {
             wiender_assert(owner_ != nullptr, "wiender::image_texture::image_texture owner cannot be nullptr");
 
             try {
@@ -1763,6 +3947,8 @@ namespace wiender {
                 owner_->transition_image_layout(cmdbuff, image_.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
                 owner_->end_single_time_commands(cmdbuff);
 
+                if (owner_->is_feature_supported(wienderer::feature::BINDLESS_TEXTURES))
+                    bindlessIndex_ = owner_->allocate_bindless_index(image_.view, sampler_);
 
             } catch (...) {
                 accurate_destroy();
@@ -1774,6 +3960,9 @@ namespace wiender {
         WIENDER_NODISCARD extent get_extent() const noexcept override {
             return extent(extent_.width, extent_.height, extent_.depth);
         }
+        WIENDER_NODISCARD uint32_t get_bindless_index() const noexcept override {
+            return bindlessIndex_;
+        }
         WIENDER_NODISCARD bool is_mapped() const noexcept override {
             return stagingMemory_ != 0;
         }
@@ -1825,6 +4014,9 @@ namespace wiender {
                 vkFreeMemory(owner_->get_ldevice(), stagingMemory_, WIENDER_CHILD_ALLOCATOR_NAME);
             }
 
+            if (bindlessIndex_ != invalidBindlessIndex)
+                owner_->release_bindless_index(bindlessIndex_);
+
             if (sampler_ != 0) {
                 vkDestroySampler(owner_->get_ldevice(), sampler_, WIENDER_CHILD_ALLOCATOR_NAME);
             }
@@ -1832,12 +4024,24 @@ namespace wiender {
         }
 
         public:
-        WIENDER_NODISCARD VkSampler get_sampler() const noexcept {
+        WIENDER_NODISCARD VkSampler get_sampler() const noexcept override {
             return sampler_;
         }
-        WIENDER_NODISCARD VkImageView get_view() const noexcept {
+        WIENDER_NODISCARD VkImageView get_view() const noexcept override {
             return image_.view;
         }
+        WIENDER_NODISCARD VkImage get_image() const noexcept override {
+            return image_.image;
+        }
+        WIENDER_NODISCARD VkFormat get_format() const noexcept override {
+            return owner_->get_swapcahin_image_format().format;
+        }
+        WIENDER_NODISCARD VkImageLayout get_layout() const noexcept override {
+            return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        WIENDER_NODISCARD bool has_content() const noexcept override {
+            return true; // uploaded or transitioned at creation
+        }
 
         private:
         WIENDER_NODISCARD VkDeviceMemory create_staging_memory() const {
@@ -1901,7 +4105,7 @@ namespace wiender {
                 VK_SAMPLE_COUNT_1_BIT,
                 owner_->get_swapcahin_image_format().format,
                 VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
             );
         }
@@ -1911,192 +4115,1123 @@ namespace wiender {
         return std::unique_ptr<image_texture>(new image_texture(owner, createInfo));
     }
 
-    struct vulkan_shader final : public shader {
-        private:
-        struct uniform_buffers_info {
-            VkDeviceMemory memory; // single memory block for each buffer but with different offsets
-            struct {
-                VkBuffer buffer;
-                VkDeviceSize size;
-            } buffers[WIENDER_UNIFORM_BUFFER_MAX_COUNT]{};
-            void* mappedMemory = nullptr;
-        };
-
+    /**
+     * @brief Color image drawn by render passes and sampled by shaders, see `render_target`.
+     *
+     * Multisampled targets draw into a transient image resolved into the sampled one. The depth image is created
+     * by the first render pass of a shader with depth and kept for the target lifetime.
+     */
+    struct vulkan_render_target final : public render_target, public vulkan_sampled_image {
         public:
         vulkan_wienderer* owner_;
-        uniform_buffers_info uniformBuffers_;
-        VkDescriptorPool descriptorPool_;
-        VkDescriptorSetLayout descriptorSetLayout_;
-        VkDescriptorSet descriptorSet_;
-        VkRenderPass renderPass_;
-        VkPipelineLayout pipelineLayout_;
-        VkPipeline pipeline_;
+        description description_;
+        VkExtent2D extent_;
+        VkExtent2D renderExtent_;       // render area of render passes, top-left part of the image
+        VkFormat format_;
+        VkSampleCountFlagBits samples_;
+        vulkan_image image_;            // single-sampled, sampled by shaders
+        vulkan_image msaaImage_;        // multisampled targets only
+        vulkan_image depthImage_;       // 0 until a shader with depth draws into the target
+        VkRenderPass renderPass_;       // framebuffers are created with them, compatible with shaders of the target
+        VkRenderPass depthRenderPass_;
+        VkFramebuffer framebuffer_;
+        VkFramebuffer depthFramebuffer_;
+        uint32_t bindlessIndex_;
+        bool rendered_;                 // a render pass into the target has been recorded
 
         public:
-        vulkan_shader(vulkan_wienderer* owner, const create_info& createInfo) :
-            owner_(owner),
-            uniformBuffers_{},
-            descriptorPool_{},
-            descriptorSetLayout_{},
-            descriptorSet_{},
-            renderPass_{},
-            pipelineLayout_{},
-            pipeline_{} {
-
-            if (owner_ == nullptr) {
-                throw std::runtime_error("wiender::vulkan_shader::vulkan_shader owner cannot be nullptr");
-            }
+        vulkan_render_target(vulkan_wienderer* owner, const extent& targetExtent, format targetFormat, VkFormat format, VkSampleCountFlagBits samples)
+            :   owner_(owner),
+                description_(targetFormat, static_cast<uint32_t>(samples)),
+                extent_{ targetExtent.width, targetExtent.height },
+                renderExtent_{ targetExtent.width, targetExtent.height },
+                format_(format),
+                samples_(samples),
+                image_{},
+                msaaImage_{},
+                depthImage_{},
+                renderPass_{},
+                depthRenderPass_{},
+                framebuffer_{},
+                depthFramebuffer_{},
+                bindlessIndex_(invalidBindlessIndex),
+                rendered_(false) {
+            wiender_assert(owner_ != nullptr, "wiender::vulkan_render_target::vulkan_render_target owner cannot be nullptr");
+            wiender_assert((extent_.width != 0) && (extent_.height != 0) && (targetExtent.depth == 0), "wiender::vulkan_render_target::vulkan_render_target render target has to be a non-empty 2d image");
 
             try {
-                std::vector<descriptor_set_layout_data> descriptorsInfos;
-                for (const auto& stage : createInfo.stages) {
-                    get_descriptor_sets(descriptorsInfos, stage.data.size() * sizeof(uint32_t), stage.data.data());
+                image_ = owner_->create_vulkan_image(
+                    extent_.width, extent_.height,
+                    1,
+                    VK_IMAGE_ASPECT_COLOR_BIT,
+                    VK_SAMPLE_COUNT_1_BIT,
+                    format_,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+                if (samples_ != VK_SAMPLE_COUNT_1_BIT) {
+                    msaaImage_ = owner_->create_vulkan_image(
+                        extent_.width, extent_.height,
+                        1,
+                        VK_IMAGE_ASPECT_COLOR_BIT,
+                        samples_,
+                        format_,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                    );
                 }
-                wiender_assert(descriptorsInfos.size() == 1, "wiender::vulkan_shader::vulkan_shader multiple sets not supported");
-
-                descriptor_set_layout_data& descriptorsInfo = descriptorsInfos.front();
-
-                uniformBuffers_ = create_uniform_buffers(descriptorsInfo);
 
-                descriptorPool_ = create_descriptor_pool(descriptorsInfo);
-
-                descriptorSetLayout_ = create_descriptor_set_layout(descriptorsInfo);
-
-                descriptorSet_ = create_descriptor_set(descriptorsInfo);
-                
-                renderPass_ = create_render_pass(createInfo);
+                // layouts kept between render passes, so the first one can load the target like any later one
+                VkCommandBuffer cmdbuff = owner_->begin_single_time_commands();
+                owner_->transition_image_layout(cmdbuff, image_.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+                if (msaaImage_.image != 0)
+                    owner_->transition_image_layout(cmdbuff, msaaImage_.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+                owner_->end_single_time_commands(cmdbuff);
 
-                pipelineLayout_ = create_pipeline_layout();
+                renderPass_ = owner_->create_target_render_pass(format_, samples_, VK_ATTACHMENT_LOAD_OP_LOAD, false, VK_ATTACHMENT_LOAD_OP_LOAD);
+                framebuffer_ = create_framebuffer(renderPass_, false);
 
-                pipeline_ = create_pipeline(createInfo);
+                if (owner_->is_feature_supported(wienderer::feature::BINDLESS_TEXTURES))
+                    bindlessIndex_ = owner_->allocate_bindless_index(image_.view, owner_->get_default_sampler());
 
             } catch (...) {
                 accurate_destroy();
                 throw;
             }
-
         }
 
         public:
-        ~vulkan_shader() override {
+        ~vulkan_render_target() override {
             accurate_destroy();
         }
 
         public:
-        void set() override {
-            owner_->set_shader_state(get_shader_state());
+        WIENDER_NODISCARD extent get_extent() const noexcept override {
+            return extent(extent_.width, extent_.height);
         }
-        WIENDER_NODISCARD uniform_buffer_info get_uniform_buffer_info(std::size_t binding) override {
-            wiender_assert(binding < WIENDER_UNIFORM_BUFFER_MAX_COUNT, "wiender::vulkan_shader::get_uniform_buffer_info binding has to be less than " WIENDER_TOSTRING(WIENDER_UNIFORM_BUFFER_MAX_COUNT));
-            VkDeviceSize offset = 0;
-            uint32_t i = 0;
-            for (; i < binding; ++i) 
-                offset += uniformBuffers_.buffers[i].size;
-            wiender_assert(uniformBuffers_.buffers[i].size != 0, "wiender::vulkan_shader::get_uniform_buffer_info buffer on this binding does not exist");
-            return uniform_buffer_info{ uniformBuffers_.buffers[i].size, reinterpret_cast<void*>((char*)uniformBuffers_.mappedMemory + offset) }; 
+        WIENDER_NODISCARD uint32_t get_bindless_index() const noexcept override {
+            return bindlessIndex_;
         }
-        void bind_texture(std::size_t binding, std::size_t arrayIndex, const texture* tetr) override {
-            wiender_assert(tetr != nullptr, "wiender::vulkan_shader::bind_texture failed to bind invalid texture");
-
-            image_texture* itetr = (image_texture*)tetr;
-
-            VkDescriptorImageInfo imageInfo = { itetr->get_sampler(), itetr->get_view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
-            VkWriteDescriptorSet descriptorWrites[1];
-            descriptorWrites[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-            descriptorWrites[0].dstSet = descriptorSet_;
-            descriptorWrites[0].dstBinding = binding;
-            descriptorWrites[0].dstArrayElement = arrayIndex;
-            descriptorWrites[0].descriptorCount = 1;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            descriptorWrites[0].pImageInfo = &imageInfo;
-            vkUpdateDescriptorSets(owner_->get_ldevice(), WIENDER_ARRSIZE(descriptorWrites), descriptorWrites, 0, 0);
+        WIENDER_NODISCARD bool is_mapped() const noexcept override {
+            return false;
         }
-
-        private:
-        WIENDER_NODISCARD active_shader_state get_shader_state() const noexcept {
-            return active_shader_state {
-                pipeline_,
-                pipelineLayout_,
-                renderPass_,
-                descriptorSet_,
-            };
+        WIENDER_NODISCARD void* map() override {
+            throw std::runtime_error("wiender::vulkan_render_target::map render targets are written by render passes only");
+        }
+        void unmap() override {
+            throw std::runtime_error("wiender::vulkan_render_target::unmap render targets are written by render passes only");
+        }
+        void update_data() override {
+            throw std::runtime_error("wiender::vulkan_render_target::update_data render targets are written by render passes only");
+        }
+        WIENDER_NODISCARD description get_description() const noexcept override {
+            return description_;
+        }
+        void set_render_extent(const extent& renderExtent) override {
+            wiender_assert((renderExtent.width <= extent_.width) && (renderExtent.height <= extent_.height) && (renderExtent.depth == 0), "wiender::vulkan_render_target::set_render_extent render extent cannot exceed the target extent");
+            renderExtent_ = ((renderExtent.width == 0) || (renderExtent.height == 0)) ? extent_ : VkExtent2D{ renderExtent.width, renderExtent.height };
+        }
+        WIENDER_NODISCARD extent get_render_extent() const noexcept override {
+            return extent(renderExtent_.width, renderExtent_.height);
+        }
+        WIENDER_NODISCARD VkSampler get_sampler() const noexcept override {
+            return owner_->get_default_sampler();
+        }
+        WIENDER_NODISCARD VkImageView get_view() const noexcept override {
+            return image_.view;
+        }
+        WIENDER_NODISCARD VkImage get_image() const noexcept override {
+            return image_.image;
+        }
+        WIENDER_NODISCARD VkFormat get_format() const noexcept override {
+            return format_;
+        }
+        WIENDER_NODISCARD VkImageLayout get_layout() const noexcept override {
+            return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; // final layout of every target render pass
+        }
+        WIENDER_NODISCARD bool has_content() const noexcept override {
+            return rendered_;
+        }
+        WIENDER_NODISCARD render_target_state get_state(bool withDepth) {
+            if (withDepth)
+                require_depth_attachment();
+            rendered_ = true;
+            return render_target_state{ withDepth ? depthFramebuffer_ : framebuffer_, renderExtent_, format_, samples_ };
         }
 
         private:
+        void require_depth_attachment() {
+            if (depthFramebuffer_ != 0)
+                return;
+
+            owner_->require_depth_format();
+            if (depthImage_.image == 0) {
+                depthImage_ = owner_->create_vulkan_image(
+                    extent_.width, extent_.height,
+                    1,
+                    VK_IMAGE_ASPECT_DEPTH_BIT,
+                    samples_,
+                    owner_->get_depth_format(),
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                );
+
+                VkCommandBuffer cmdbuff = owner_->begin_single_time_commands();
+                owner_->transition_image_layout(cmdbuff, depthImage_.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                owner_->end_single_time_commands(cmdbuff);
+            }
+            if (depthRenderPass_ == 0)
+                depthRenderPass_ = owner_->create_target_render_pass(format_, samples_, VK_ATTACHMENT_LOAD_OP_LOAD, true, VK_ATTACHMENT_LOAD_OP_LOAD);
+            depthFramebuffer_ = create_framebuffer(depthRenderPass_, true);
+        }
+        WIENDER_NODISCARD VkFramebuffer create_framebuffer(VkRenderPass renderPass, bool withDepth) const {
+            // same attachment order as `vulkan_wienderer::create_target_render_pass`
+            const VkImageView msaaAttachments[] = { msaaImage_.view, image_.view, depthImage_.view };
+            const VkImageView noMsaaAttachments[] = { image_.view, depthImage_.view };
+            const bool multisampled = (samples_ != VK_SAMPLE_COUNT_1_BIT);
+
+            return owner_->create_framebuffer(
+                renderPass,
+                (multisampled ? 2u : 1u) + (withDepth ? 1u : 0u),
+                (multisampled ? msaaAttachments : noMsaaAttachments),
+                extent_
+            );
+        }
         void accurate_destroy() {
             vkDeviceWaitIdle(owner_->get_ldevice());
 
-            if (pipeline_ != 0)
-                vkDestroyPipeline(owner_->get_ldevice(), pipeline_, WIENDER_CHILD_ALLOCATOR_NAME);
-            if (pipelineLayout_ != 0)
-                vkDestroyPipelineLayout(owner_->get_ldevice(), pipelineLayout_, WIENDER_CHILD_ALLOCATOR_NAME);
+            if (bindlessIndex_ != invalidBindlessIndex)
+                owner_->release_bindless_index(bindlessIndex_);
+            if (depthFramebuffer_ != 0)
+                vkDestroyFramebuffer(owner_->get_ldevice(), depthFramebuffer_, WIENDER_CHILD_ALLOCATOR_NAME);
+            if (framebuffer_ != 0)
+                vkDestroyFramebuffer(owner_->get_ldevice(), framebuffer_, WIENDER_CHILD_ALLOCATOR_NAME);
+            if (depthRenderPass_ != 0)
+                vkDestroyRenderPass(owner_->get_ldevice(), depthRenderPass_, WIENDER_CHILD_ALLOCATOR_NAME);
             if (renderPass_ != 0)
                 vkDestroyRenderPass(owner_->get_ldevice(), renderPass_, WIENDER_CHILD_ALLOCATOR_NAME);
-            
-            for (auto i : uniformBuffers_.buffers) {
-                if (i.buffer != 0)
-                    vkDestroyBuffer(owner_->get_ldevice(), i.buffer, WIENDER_CHILD_ALLOCATOR_NAME);
-            }
-            if (uniformBuffers_.mappedMemory != 0)
-                vkUnmapMemory(owner_->get_ldevice(), uniformBuffers_.memory);
-            if (uniformBuffers_.memory != 0)
-                vkFreeMemory(owner_->get_ldevice(), uniformBuffers_.memory, WIENDER_CHILD_ALLOCATOR_NAME);
-                
-            if (descriptorSetLayout_ != 0)
-                vkDestroyDescriptorSetLayout(owner_->get_ldevice(), descriptorSetLayout_, WIENDER_CHILD_ALLOCATOR_NAME);
-            if (descriptorPool_ != 0)
-                vkDestroyDescriptorPool(owner_->get_ldevice(), descriptorPool_, WIENDER_CHILD_ALLOCATOR_NAME);
+            owner_->destroy_vulkan_image(depthImage_);
+            owner_->destroy_vulkan_image(msaaImage_);
+            owner_->destroy_vulkan_image(image_);
         }
+    };
+    WIENDER_NODISCARD std::unique_ptr<render_target> create_vulkan_render_target(vulkan_wienderer* owner, const texture::extent& targetExtent, render_target::format targetFormat, VkFormat format, VkSampleCountFlagBits samples) {
+        return std::unique_ptr<vulkan_render_target>(new vulkan_render_target(owner, targetExtent, targetFormat, format, samples));
+    }
+    WIENDER_NODISCARD render_target_state get_vulkan_render_target_state(render_target* target, bool withDepth) {
+        return static_cast<vulkan_render_target*>(target)->get_state(withDepth);
+    }
 
-        private:
-        WIENDER_NODISCARD VkPipeline create_pipeline(const create_info& createInfo) const {
-            const VkAllocationCallbacks* allocationCallbacks = nullptr;
-            wiender_assert(!createInfo.stages.empty(), "wiender::vulkan_shader::create_pipeline no shader stages for shader program");
+    /**
+     * @brief Render pass, transient attachments and window framebuffers of a post-process chain, see `postprocess_chain`.
+     *
+     * Intermediate and depth images are shared by every swapchain image like the multisampled color image of the window,
+     * they are lazily allocated where the device supports it, so tiled GPUs don't back them with memory at all.
+     */
+    struct vulkan_postprocess_chain final : public postprocess_chain {
+        public:
+        vulkan_wienderer* owner_;
+        description description_;
+        vulkan_image intermediateImages_[2];    // the second one with two or more post subpasses only
+        vulkan_image depthImage_;               // chains with depth only
+        VkFramebuffer framebuffers_[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
+        postprocess_chain_state state_;
 
-            std::vector<VkPipelineShaderStageCreateInfo> shaderStages(createInfo.stages.size());
+        public:
+        vulkan_postprocess_chain(vulkan_wienderer* owner, const description& chainDescription, VkFormat intermediateFormat)
+            :   owner_(owner),
+                description_(chainDescription),
+                intermediateImages_{},
+                depthImage_{},
+                framebuffers_{},
+                state_{} {
+            wiender_assert(owner_ != nullptr, "wiender::vulkan_postprocess_chain::vulkan_postprocess_chain owner cannot be nullptr");
+
+            state_.framebuffers = framebuffers_;
+            state_.intermediateFormat = intermediateFormat;
+            state_.subpassCount = description_.postSubpassCount + 1;
+            state_.depthAttachment = description_.depth;
+            const uint32_t intermediateCount = (state_.subpassCount > 2) ? 2u : 1u;
+            state_.attachmentCount = 1 + intermediateCount + (state_.depthAttachment ? 1u : 0u);
 
-            for (uint32_t i = 0; i < createInfo.stages.size(); ++i) {
-                VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-                shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-             // shaderModuleCreateInfo.pNext = nullptr;
-             // shaderModuleCreateInfo.flags = static_cast<VkFlags>(0);
-                shaderModuleCreateInfo.codeSize = createInfo.stages[i].data.size() * sizeof(uint32_t);
-                shaderModuleCreateInfo.pCode = createInfo.stages[i].data.data();
+            try {
+                const VkExtent2D extent = owner_->get_swapchain_extent();
+                for (uint32_t i = 0; i < intermediateCount; ++i) {
+                    intermediateImages_[i] = owner_->create_vulkan_image(
+                        extent.width, extent.height,
+                        1,
+                        VK_IMAGE_ASPECT_COLOR_BIT,
+                        VK_SAMPLE_COUNT_1_BIT,
+                        intermediateFormat,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+                    );
+                    state_.intermediateViews[i] = intermediateImages_[i].view;
+                }
+                if (intermediateCount == 1)
+                    state_.intermediateViews[1] = state_.intermediateViews[0];
+
+                if (state_.depthAttachment) {
+                    owner_->require_depth_format();
+                    depthImage_ = owner_->create_vulkan_image(
+                        extent.width, extent.height,
+                        1,
+                        VK_IMAGE_ASPECT_DEPTH_BIT,
+                        VK_SAMPLE_COUNT_1_BIT,
+                        owner_->get_depth_format(),
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+                    );
+                }
 
-                vulkan_check(vkCreateShaderModule(owner_->get_ldevice(), &shaderModuleCreateInfo, allocationCallbacks, &shaderStages[i].module), "wiender::vulkan_shader::create_pipeline failed to create shader module");
-                shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-             // shaderStages[i].pNext = nullptr;
-             // shaderStages[i].flags = static_cast<VkFlags>(0);
-                shaderStages[i].stage = shader_stage_kind_to_vk_shader_stage(createInfo.stages[i].stageKind);
-                shaderStages[i].pName = "main";
-                shaderStages[i].pSpecializationInfo = {};
-            }
-            uint32_t inputSize = 0;
-            for (const auto& vinputAttribute: createInfo.vertexInputAttributes)
-                inputSize += static_cast<uint32_t>(sizeof_shader_vertex_input_attribute_format(vinputAttribute.inputFormat));
+                state_.renderPass = owner_->create_postprocess_render_pass(intermediateFormat, state_.subpassCount, state_.depthAttachment);
 
-            VkVertexInputBindingDescription inputBinding{};
-         // inputBinding.binding = 0;
-            inputBinding.stride = inputSize;
-            inputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+                // same attachment order as `vulkan_wienderer::create_postprocess_render_pass`
+                for (uint32_t i = 0; i < owner_->get_swapchain_image_count(); ++i) {
+                    VkImageView attachments[4] = { owner_->get_swapchain_image_view(i), intermediateImages_[0].view, intermediateImages_[1].view, depthImage_.view };
+                    if (intermediateCount == 1)
+                        attachments[2] = depthImage_.view;
+                    framebuffers_[i] = owner_->create_framebuffer(state_.renderPass, state_.attachmentCount, attachments, extent);
+                }
 
-            std::vector<VkVertexInputAttributeDescription> vkVertexInputAttributes(createInfo.vertexInputAttributes.size());
-            for (size_t i = 0; i < vkVertexInputAttributes.size(); ++i) {
-                const auto& iattr = createInfo.vertexInputAttributes[i];
+            } catch (...) {
+                accurate_destroy();
+                throw;
+            }
+        }
+        vulkan_postprocess_chain(const vulkan_postprocess_chain&) = delete;
+        vulkan_postprocess_chain& operator=(const vulkan_postprocess_chain&) = delete;
 
-                auto& vkdesc = vkVertexInputAttributes[i];
-                vkdesc.location = iattr.location;
-                vkdesc.binding = iattr.binding;
+        public:
+        ~vulkan_postprocess_chain() override {
+            accurate_destroy();
+        }
+
+        public:
+        WIENDER_NODISCARD description get_description() const noexcept override {
+            return description_;
+        }
+        WIENDER_NODISCARD const postprocess_chain_state& get_state() const noexcept {
+            return state_;
+        }
+
+        private:
+        void accurate_destroy() {
+            vkDeviceWaitIdle(owner_->get_ldevice());
+
+            for (const VkFramebuffer framebuffer : framebuffers_) {
+                if (framebuffer != 0)
+                    vkDestroyFramebuffer(owner_->get_ldevice(), framebuffer, WIENDER_CHILD_ALLOCATOR_NAME);
+            }
+            if (state_.renderPass != 0)
+                vkDestroyRenderPass(owner_->get_ldevice(), state_.renderPass, WIENDER_CHILD_ALLOCATOR_NAME);
+            owner_->destroy_vulkan_image(depthImage_);
+            owner_->destroy_vulkan_image(intermediateImages_[1]);
+            owner_->destroy_vulkan_image(intermediateImages_[0]);
+        }
+    };
+    WIENDER_NODISCARD std::unique_ptr<postprocess_chain> create_vulkan_postprocess_chain(vulkan_wienderer* owner, const postprocess_chain::description& chainDescription, VkFormat intermediateFormat) {
+        return std::unique_ptr<vulkan_postprocess_chain>(new vulkan_postprocess_chain(owner, chainDescription, intermediateFormat));
+    }
+    WIENDER_NODISCARD const postprocess_chain_state& get_vulkan_postprocess_chain_state(const postprocess_chain* chain) {
+        return static_cast<const vulkan_postprocess_chain*>(chain)->get_state();
+    }
+
+    /**
+     * @brief Copy submitted by `vulkan_wienderer::request_readback`, owns its command buffer, fence and readback slice.
+     */
+    struct vulkan_readback_ticket final : public readback_ticket {
+        public:
+        vulkan_wienderer* owner_;
+        VkCommandBuffer commandBuffer_;
+        VkFence fence_;
+        readback_slice slice_;
+        std::size_t size_;
+        std::size_t rowPitch_;
+
+        public:
+        vulkan_readback_ticket(vulkan_wienderer* owner, VkCommandBuffer commandBuffer, VkFence fence, const readback_slice& slice, std::size_t size, std::size_t rowPitch) noexcept
+            :   owner_(owner),
+                commandBuffer_(commandBuffer),
+                fence_(fence),
+                slice_(slice),
+                size_(size),
+                rowPitch_(rowPitch) {}
+        vulkan_readback_ticket(const vulkan_readback_ticket&) = delete;
+        vulkan_readback_ticket& operator=(const vulkan_readback_ticket&) = delete;
+
+        public:
+        ~vulkan_readback_ticket() override {
+            // the slice can be reused only after the copy into it is finished
+            vkWaitForFences(owner_->get_ldevice(), 1, &fence_, VK_TRUE, UINT64_MAX);
+            vkDestroyFence(owner_->get_ldevice(), fence_, WIENDER_CHILD_ALLOCATOR_NAME);
+            vkFreeCommandBuffers(owner_->get_ldevice(), owner_->get_command_pool(), 1, &commandBuffer_);
+            owner_->free_readback_slice(slice_);
+        }
+
+        public:
+        WIENDER_NODISCARD bool is_ready() const override {
+            return vkGetFenceStatus(owner_->get_ldevice(), fence_) == VK_SUCCESS;
+        }
+        void wait() const override {
+            vulkan_check(vkWaitForFences(owner_->get_ldevice(), 1, &fence_, VK_TRUE, UINT64_MAX), "wiender::vulkan_readback_ticket::wait failed to wait for readback");
+        }
+        WIENDER_NODISCARD const void* get_data() const override {
+            wiender_assert(is_ready(), "wiender::vulkan_readback_ticket::get_data copy is not finished, poll or wait the ticket first");
+            return slice_.mappedMemory;
+        }
+        WIENDER_NODISCARD std::size_t get_size() const noexcept override {
+            return size_;
+        }
+        WIENDER_NODISCARD std::size_t get_row_pitch() const noexcept override {
+            return rowPitch_;
+        }
+    };
+    std::unique_ptr<readback_ticket> create_vulkan_readback_ticket(vulkan_wienderer* owner, VkCommandBuffer commandBuffer, VkFence fence, const readback_slice& slice, std::size_t size, std::size_t rowPitch) {
+        return std::unique_ptr<vulkan_readback_ticket>(new vulkan_readback_ticket(owner, commandBuffer, fence, slice, size, rowPitch));
+    }
+
+    /**
+     * @brief Descriptor sets of one reflected set number (one per swapchain image) with their uniform blocks.
+     *
+     * Shaders own material and draw sets, frame and pass sets are shared by shaders
+     * with identically defined layouts through `vulkan_wienderer::get_shared_descriptor_sets`.
+     */
+    struct vulkan_descriptor_set {
+        private:
+        struct uniform_buffers_info {
+            uniform_slice slice; // every binding of every swapchain image slot
+            struct {
+                VkDeviceSize offset; // inside of a slot
+                VkDeviceSize size;
+            } bindings[WIENDER_UNIFORM_BUFFER_MAX_COUNT]{};
+            std::vector<char> shadowMemory;
+            frame_uniform_storage storage{};
+        };
+        struct template_binding {
+            uint32_t binding;
+            VkDescriptorType descriptorType;
+            uint32_t descriptorCount;
+            size_t offset;              // inside of one template data copy
+        };
+
+        public:
+        vulkan_wienderer* owner_;
+        uint64_t layoutHash_;
+        uniform_buffers_info uniformBuffers_;
+        VkDescriptorPool descriptorPool_; // shared, not owned
+        VkDescriptorSetLayout descriptorSetLayout_;
+        VkDescriptorSet descriptorSets_[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
+        std::vector<template_binding> templateBindings_;
+        std::vector<char> templateData_;
+        frame_descriptor_writes writes_;
+
+        public:
+        vulkan_descriptor_set(vulkan_wienderer* owner, const descriptor_set_layout_data& descriptorsInfo) :
+            owner_(owner),
+            layoutHash_(hash_layout(descriptorsInfo)),
+            uniformBuffers_{},
+            descriptorPool_{},
+            descriptorSetLayout_{},
+            descriptorSets_{},
+            templateBindings_{},
+            templateData_{},
+            writes_{} {
+
+            try {
+                uniformBuffers_ = create_uniform_buffers(descriptorsInfo);
+                if (uniformBuffers_.storage.dataSize != 0) {
+                    uniformBuffers_.storage.shadowMemory = uniformBuffers_.shadowMemory.data();
+                    owner_->register_uniform_storage(&uniformBuffers_.storage);
+                }
+
+                descriptorSetLayout_ = create_descriptor_set_layout(descriptorsInfo);
+
+                create_descriptor_sets(descriptorsInfo);
+
+            } catch (...) {
+                accurate_destroy();
+                throw;
+            }
+        }
+        vulkan_descriptor_set(const vulkan_descriptor_set&) = delete;
+        vulkan_descriptor_set& operator=(const vulkan_descriptor_set&) = delete;
+
+        public:
+        ~vulkan_descriptor_set() {
+            accurate_destroy(); // users wait for the device before releasing the last reference
+        }
+
+        public:
+        WIENDER_NODISCARD shader::uniform_buffer_info get_uniform_buffer_info(std::size_t binding) {
+            wiender_assert(binding < WIENDER_UNIFORM_BUFFER_MAX_COUNT, "wiender::vulkan_descriptor_set::get_uniform_buffer_info binding has to be less than " WIENDER_TOSTRING(WIENDER_UNIFORM_BUFFER_MAX_COUNT));
+            const auto& bindingInfo = uniformBuffers_.bindings[binding];
+            wiender_assert(bindingInfo.size != 0, "wiender::vulkan_descriptor_set::get_uniform_buffer_info buffer on this binding does not exist");
+            // shadow copy, gpu gets it on the next execute without waiting for frames in flight
+            return shader::uniform_buffer_info{ bindingInfo.size, reinterpret_cast<void*>(uniformBuffers_.shadowMemory.data() + bindingInfo.offset) };
+        }
+        /**
+         * @brief Stores textures into template data, sets are updated by `vulkan_wienderer::execute`.
+         *
+         * Rebinding the same textures doesn't mark the set dirty.
+         */
+        void bind_textures(std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) {
+            wiender_assert((textures != nullptr) || (count == 0), "wiender::vulkan_descriptor_set::bind_textures failed to bind invalid textures");
+            const template_binding& templateBinding = get_template_binding(binding);
+            wiender_assert(templateBinding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, "wiender::vulkan_descriptor_set::bind_textures binding is not a combined image sampler");
+            wiender_assert(first + count <= templateBinding.descriptorCount, "wiender::vulkan_descriptor_set::bind_textures array elements are out of binding");
+
+            std::vector<VkDescriptorImageInfo> imageInfos(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                wiender_assert(textures[i] != nullptr, "wiender::vulkan_descriptor_set::bind_textures failed to bind invalid texture");
+                const vulkan_sampled_image& image = get_sampled_image(textures[i]);
+                imageInfos[i] = { image.get_sampler(), image.get_view(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            }
+
+            const size_t offset = templateBinding.offset + first * sizeof(VkDescriptorImageInfo);
+            const size_t size = count * sizeof(VkDescriptorImageInfo);
+            if ((size == 0) || (std::memcmp(templateData_.data() + offset, imageInfos.data(), size) == 0))
+                return; // copies of every image are equal outside of uniform buffer bindings
+
+            const uint32_t imageCount = owner_->get_swapchain_image_count();
+            for (uint32_t iS = 0; iS < imageCount; ++iS)
+                std::memcpy(templateData_.data() + iS * writes_.dataStride + offset, imageInfos.data(), size);
+            writes_.dirtyImages = (1u << imageCount) - 1;
+        }
+        void bind_texture(std::size_t binding, std::size_t arrayIndex, const texture* tetr) {
+            bind_textures(binding, arrayIndex, &tetr, 1);
+        }
+        /**
+         * @brief Stores a storage buffer range into template data, applied like `bind_textures`.
+         *
+         * Devices without update-after-bind for storage buffers get the write right away, which is only allowed
+         * while the owner has no recorded commands (before the first `begin_record` or after `clear_commands_frame`).
+         */
+        void bind_buffer(std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) {
+            wiender_assert(buff != nullptr, "wiender::vulkan_descriptor_set::bind_buffer failed to bind invalid buffer");
+            const vulkan_buffer* vbuff = static_cast<const vulkan_buffer*>(buff);
+            const template_binding& templateBinding = get_template_binding(binding);
+            wiender_assert(templateBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, "wiender::vulkan_descriptor_set::bind_buffer binding is not a storage buffer");
+            wiender_assert((vbuff->get_usage() & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) != 0, "wiender::vulkan_descriptor_set::bind_buffer buffer has to be created with a storage type");
+            wiender_assert(offset % owner_->get_pdevice().properties.properties.limits.minStorageBufferOffsetAlignment == 0, "wiender::vulkan_descriptor_set::bind_buffer offset has to be aligned to minStorageBufferOffsetAlignment");
+            wiender_assert((offset < vbuff->get_size()) && (range <= vbuff->get_size() - offset), "wiender::vulkan_descriptor_set::bind_buffer range is out of buffer");
+
+            const VkDescriptorBufferInfo bufferInfo = { vbuff->get_buffer(), offset, (range != 0) ? static_cast<VkDeviceSize>(range) : VK_WHOLE_SIZE };
+            if (std::memcmp(templateData_.data() + templateBinding.offset, &bufferInfo, sizeof(bufferInfo)) == 0)
+                return;
+            wiender_assert(is_update_after_bind(templateBinding.descriptorType) || !owner_->has_recorded_commands(), "wiender::vulkan_descriptor_set::bind_buffer device can't rebind storage buffers of recorded sets, call clear_commands_frame first");
+
+            const uint32_t imageCount = owner_->get_swapchain_image_count();
+            for (uint32_t iS = 0; iS < imageCount; ++iS)
+                std::memcpy(templateData_.data() + iS * writes_.dataStride + templateBinding.offset, &bufferInfo, sizeof(bufferInfo));
+
+            if (is_update_after_bind(templateBinding.descriptorType)) {
+                writes_.dirtyImages = (1u << imageCount) - 1;
+                return;
+            }
+            VkWriteDescriptorSet descriptorWrites[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
+            for (uint32_t iS = 0; iS < imageCount; ++iS) {
+                descriptorWrites[iS] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+                descriptorWrites[iS].dstSet = descriptorSets_[iS];
+                descriptorWrites[iS].dstBinding = templateBinding.binding;
+                descriptorWrites[iS].dstArrayElement = 0;
+                descriptorWrites[iS].descriptorCount = 1;
+                descriptorWrites[iS].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                descriptorWrites[iS].pBufferInfo = &bufferInfo;
+            }
+            vkUpdateDescriptorSets(owner_->get_ldevice(), imageCount, descriptorWrites, 0, nullptr);
+        }
+        /**
+         * @brief Writes an input attachment of a post-process chain right away, only before the set is used by any command.
+         */
+        void bind_input_attachment(uint32_t binding, VkImageView view) {
+            const VkDescriptorImageInfo imageInfo = { 0, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+            const uint32_t imageCount = owner_->get_swapchain_image_count();
+            VkWriteDescriptorSet descriptorWrites[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
+            for (uint32_t iS = 0; iS < imageCount; ++iS) {
+                descriptorWrites[iS] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+                descriptorWrites[iS].dstSet = descriptorSets_[iS];
+                descriptorWrites[iS].dstBinding = binding;
+                descriptorWrites[iS].dstArrayElement = 0;
+                descriptorWrites[iS].descriptorCount = 1;
+                descriptorWrites[iS].descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+                descriptorWrites[iS].pImageInfo = &imageInfo;
+            }
+            vkUpdateDescriptorSets(owner_->get_ldevice(), imageCount, descriptorWrites, 0, nullptr);
+        }
+        WIENDER_NODISCARD VkDescriptorSetLayout get_layout() const noexcept {
+            return descriptorSetLayout_;
+        }
+        WIENDER_NODISCARD uint64_t get_layout_hash() const noexcept {
+            return layoutHash_;
+        }
+        WIENDER_NODISCARD VkDescriptorSet get_set(uint32_t imageIndex) const noexcept {
+            return descriptorSets_[imageIndex];
+        }
+
+        public:
+        /**
+         * @brief Hash of everything the layout and uniform blocks are created from, equal hashes are shared.
+         */
+        WIENDER_NODISCARD static uint64_t hash_layout(const descriptor_set_layout_data& descriptorsInfo) {
+            uint64_t result = hash_value(descriptorsInfo.setNumber);
+            for (size_t i = 0; i < descriptorsInfo.bindings.size(); ++i) {
+                const auto& binding = descriptorsInfo.bindings[i];
+                result = hash_value(binding.binding, result);
+                result = hash_value(binding.descriptorType, result);
+                result = hash_value(binding.descriptorCount, result);
+                result = hash_value(binding.stageFlags, result);
+                result = hash_value(descriptorsInfo.bufferSizes[i], result);
+            }
+            return result;
+        }
+
+        private:
+        WIENDER_NODISCARD const template_binding& get_template_binding(std::size_t binding) const {
+            for (const auto& templateBinding : templateBindings_) {
+                if (templateBinding.binding == binding)
+                    return templateBinding;
+            }
+            throw std::runtime_error("wiender::vulkan_descriptor_set::get_template_binding set has no such binding");
+        }
+        /**
+         * @brief Bindings rewritten after the set is bound in recorded command buffers.
+         */
+        WIENDER_NODISCARD bool is_update_after_bind(VkDescriptorType descriptorType) const noexcept {
+            switch (descriptorType) {
+                case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: return true;
+                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: return owner_->get_pdevice().indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind == VK_TRUE;
+                default: return false;
+            }
+        }
+
+        private:
+        void accurate_destroy() {
+            owner_->unregister_descriptor_writes(&writes_);
+            if (writes_.updateTemplate != 0)
+                vkDestroyDescriptorUpdateTemplate(owner_->get_ldevice(), writes_.updateTemplate, WIENDER_CHILD_ALLOCATOR_NAME);
+
+            owner_->unregister_uniform_storage(&uniformBuffers_.storage);
+            owner_->free_uniform_slice(uniformBuffers_.slice);
+
+            if (descriptorPool_ != 0)
+                owner_->free_descriptor_sets(descriptorPool_, owner_->get_swapchain_image_count(), descriptorSets_);
+            if (descriptorSetLayout_ != 0)
+                vkDestroyDescriptorSetLayout(owner_->get_ldevice(), descriptorSetLayout_, WIENDER_CHILD_ALLOCATOR_NAME);
+        }
+
+        private:
+        /**
+         * @brief Allocates one set per swapchain image and writes every binding with a single templated update.
+         *
+         * Template data holds descriptor infos of every binding in reflection order, one copy per image since
+         * uniform buffer bindings point to the slot of their image. Only update-after-bind bindings are rewritten later,
+         * so sets referenced by recorded command buffers stay valid.
+         */
+        void create_descriptor_sets(const descriptor_set_layout_data& descriptorInfo) {
+            const uint32_t setCount = owner_->get_swapchain_image_count();
+            VkDescriptorSetLayout layouts[WIENDER_SWAPCHAIN_IMAGE_MAX_COUNT];
+            for (uint32_t i = 0; i < setCount; ++i)
+                layouts[i] = descriptorSetLayout_;
+
+            std::vector<VkDescriptorPoolSize> setPoolSizes;
+            for (const auto& bindingInfo : descriptorInfo.bindings)
+                setPoolSizes.emplace_back(VkDescriptorPoolSize{ bindingInfo.descriptorType, bindingInfo.descriptorCount });
+
+            descriptorPool_ = owner_->allocate_descriptor_sets(layouts, setCount, setPoolSizes, descriptorSets_);
+
+            std::vector<VkDescriptorUpdateTemplateEntry> entries;
+            size_t dataStride = 0;
+            for (const auto& setBinding : descriptorInfo.bindings) {
+                size_t stride;
+                if ((setBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) || (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)) {
+                    stride = sizeof(VkDescriptorBufferInfo);
+                } else if ((setBinding.descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) || (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE)) {
+                    stride = sizeof(VkDescriptorImageInfo);
+                } else {
+                    continue;
+                }
+                templateBindings_.emplace_back(template_binding{ setBinding.binding, setBinding.descriptorType, setBinding.descriptorCount, dataStride });
+
+                VkDescriptorUpdateTemplateEntry entry{};
+                entry.dstBinding = setBinding.binding;
+             // entry.dstArrayElement = 0;
+                entry.descriptorCount = setBinding.descriptorCount;
+                entry.descriptorType = setBinding.descriptorType;
+                entry.offset = dataStride;
+                entry.stride = stride;
+                entries.emplace_back(entry);
+
+                dataStride += stride * setBinding.descriptorCount;
+            }
+            if (entries.empty())
+                return;
+
+            templateData_.assign(dataStride * setCount, 0);
+            for (uint32_t iS = 0; iS < setCount; ++iS) {
+                char* data = templateData_.data() + iS * dataStride;
+                for (const auto& templateBinding : templateBindings_) {
+                    for (uint32_t i = 0; i < templateBinding.descriptorCount; ++i) {
+                        if (templateBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) {
+                            const auto& uniformBinding = uniformBuffers_.bindings[templateBinding.binding];
+                            VkDescriptorBufferInfo& bufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(data + templateBinding.offset)[i];
+                            bufferInfo.buffer = uniformBuffers_.slice.buffer;
+                            bufferInfo.offset = uniformBuffers_.slice.offset + iS * uniformBuffers_.storage.slotSize + uniformBinding.offset;
+                            bufferInfo.range = uniformBinding.size;
+                        } else if (templateBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+                            VkDescriptorBufferInfo& bufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(data + templateBinding.offset)[i];
+                            bufferInfo.buffer = owner_->get_default_storage_buffer();
+                         // bufferInfo.offset = 0;
+                            bufferInfo.range = VK_WHOLE_SIZE;
+                        } else {
+                            VkDescriptorImageInfo& imageInfo = reinterpret_cast<VkDescriptorImageInfo*>(data + templateBinding.offset)[i];
+                            imageInfo.sampler = owner_->get_default_sampler();
+                            imageInfo.imageView = owner_->get_default_texture_image().view;
+                            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+                        }
+                    }
+                }
+            }
+
+            const VkDescriptorUpdateTemplate initialTemplate = create_update_template(entries);
+            for (uint32_t iS = 0; iS < setCount; ++iS)
+                vkUpdateDescriptorSetWithTemplate(owner_->get_ldevice(), descriptorSets_[iS], initialTemplate, templateData_.data() + iS * dataStride);
+            vkDestroyDescriptorUpdateTemplate(owner_->get_ldevice(), initialTemplate, WIENDER_CHILD_ALLOCATOR_NAME);
+
+            entries.erase(std::remove_if(entries.begin(), entries.end(), [this](const VkDescriptorUpdateTemplateEntry& entry) {
+                return !is_update_after_bind(entry.descriptorType);
+            }), entries.end());
+            if (entries.empty())
+                return;
+
+            writes_.updateTemplate = create_update_template(entries);
+            writes_.sets = descriptorSets_;
+            writes_.data = templateData_.data();
+            writes_.dataStride = dataStride;
+            owner_->register_descriptor_writes(&writes_);
+        }
+        WIENDER_NODISCARD VkDescriptorUpdateTemplate create_update_template(const std::vector<VkDescriptorUpdateTemplateEntry>& entries) const {
+            VkDescriptorUpdateTemplateCreateInfo templateCreateInfo{};
+            templateCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+         // templateCreateInfo.pNext = nullptr;
+         // templateCreateInfo.flags = static_cast<VkFlags>(0);
+            templateCreateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+            templateCreateInfo.pDescriptorUpdateEntries = entries.data();
+            templateCreateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+            templateCreateInfo.descriptorSetLayout = descriptorSetLayout_;
+
+            VkDescriptorUpdateTemplate result;
+            vulkan_check(vkCreateDescriptorUpdateTemplate(owner_->get_ldevice(), &templateCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result), "wiender::vulkan_descriptor_set::create_update_template failed to create descriptor update template");
+            return result;
+        }
+        WIENDER_NODISCARD VkDescriptorSetLayout create_descriptor_set_layout(const descriptor_set_layout_data& descriptorInfo) {
+            const auto& bindings = descriptorInfo.bindings;
+            std::vector<VkDescriptorBindingFlags> flags;
+
+            flags.resize(bindings.size());
+            for (size_t i = 0; i < flags.size(); ++i) {
+                if (is_update_after_bind(bindings[i].descriptorType)) {
+                    flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+                } else {
+                    flags[i] = static_cast<VkFlags>(0);
+                }
+            }
+
+            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingsFlags{};
+            bindingsFlags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+            bindingsFlags.pBindingFlags = flags.data();
+            bindingsFlags.bindingCount = flags.size();
+
+            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = descriptorInfo.createInfo;
+            descriptorSetLayoutCreateInfo.pNext = &bindingsFlags;
+            descriptorSetLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+
+            VkDescriptorSetLayout result;
+            vulkan_check(vkCreateDescriptorSetLayout(owner_->get_ldevice(), &descriptorSetLayoutCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result), "wiender::vulkan_descriptor_set::create_descriptor_set_layout failed to create descriptors set layout");
+            return result;
+        }
+        WIENDER_NODISCARD uniform_buffers_info create_uniform_buffers(const descriptor_set_layout_data& descriptorsInfo) const {
+            uniform_buffers_info result{};
+            const VkDeviceSize alignment = owner_->get_pdevice().properties.properties.limits.minUniformBufferOffsetAlignment;
+            VkDeviceSize slotSize = 0;
+            for (size_t i = 0; i < descriptorsInfo.bindings.size(); ++i) {
+                const auto& bindingInfo = descriptorsInfo.bindings[i];
+                const auto& bufferSize = descriptorsInfo.bufferSizes[i];
+                if (bindingInfo.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+                    continue;
+                wiender_assert(bindingInfo.binding < WIENDER_UNIFORM_BUFFER_MAX_COUNT, "wiender::vulkan_descriptor_set::create_uniform_buffers uniform buffer binding has to be less than" WIENDER_TOSTRING(WIENDER_UNIFORM_BUFFER_MAX_COUNT));
+                wiender_assert(bufferSize != 0, "wiender::vulkan_descriptor_set::create_uniform_buffers uniform buffer size must be more than zero");
+                result.bindings[bindingInfo.binding].offset = align_up(slotSize, alignment);
+                result.bindings[bindingInfo.binding].size = bufferSize;
+                slotSize = result.bindings[bindingInfo.binding].offset + bufferSize;
+            }
+            if (slotSize == 0) {
+                return result;
+            }
+            slotSize = align_up(slotSize, alignment);
+
+            result.slice = owner_->allocate_uniform_slice(slotSize * owner_->get_swapchain_image_count());
+            result.shadowMemory.assign(static_cast<size_t>(slotSize), 0);
+            result.storage.mappedMemory = result.slice.mappedMemory;
+            result.storage.slotSize = slotSize;
+            result.storage.dataSize = slotSize;
+            return result;
+        }
+    };
+    struct vulkan_shader final : public shader {
+        public:
+        vulkan_wienderer* owner_;
+        std::shared_ptr<vulkan_descriptor_set> descriptorSets_[WIENDER_BINDLESS_TEXTURE_SET]; // by set number, null if the set is not used
+        descriptor_set_layout_data materialSetInfo_; // materials create their own sets from it
+        descriptor_sets_state descriptorSetsState_;
+        VkRenderPass renderPass_;
+        VkPipelineLayout pipelineLayout_;
+        VkPushConstantRange pushConstantRange_;
+        bool bindlessTextures_;
+        uint64_t pipelineLayoutHash_; // identically defined layouts share pipeline libraries
+        VkPipelineBindPoint bindPoint_;
+        bool depthAttachment_;
+        VkFormat targetFormat_;         // VK_FORMAT_UNDEFINED for the window, intermediate format in post-process chains
+        VkFormat colorFormat_;
+        VkSampleCountFlagBits samples_;
+        uint32_t subpass_;
+        uint32_t chainSubpassCount_;    // 0 outside of post-process chains
+        uint64_t chainKey_;             // structure of the chain render pass, 0 outside of chains
+        VkPipeline pipeline_;
+
+        public:
+        vulkan_shader(vulkan_wienderer* owner, const create_info& createInfo) :
+            owner_(owner),
+            descriptorSets_{},
+            materialSetInfo_{},
+            descriptorSetsState_{},
+            renderPass_{},
+            pipelineLayout_{},
+            pushConstantRange_{},
+            bindlessTextures_(false),
+            pipelineLayoutHash_{},
+            bindPoint_(is_compute(createInfo) ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS),
+            depthAttachment_(!is_compute(createInfo) && createInfo.depthMode != depth_mode::DISABLED),
+            targetFormat_(VK_FORMAT_UNDEFINED),
+            colorFormat_(VK_FORMAT_UNDEFINED),
+            samples_(VK_SAMPLE_COUNT_1_BIT),
+            subpass_(0),
+            chainSubpassCount_(0),
+            chainKey_(0),
+            pipeline_{} {
+
+            if (owner_ == nullptr) {
+                throw std::runtime_error("wiender::vulkan_shader::vulkan_shader owner cannot be nullptr");
+            }
+
+            try {
+                if (createInfo.chain != nullptr) {
+                    const postprocess_chain_state& chainState = get_vulkan_postprocess_chain_state(createInfo.chain);
+                    wiender_assert(bindPoint_ == VK_PIPELINE_BIND_POINT_GRAPHICS, "wiender::vulkan_shader::vulkan_shader compute shaders cannot draw in a post-process chain");
+                    wiender_assert(createInfo.target.samples == 0, "wiender::vulkan_shader::vulkan_shader shader cannot draw both in a post-process chain and into a render target");
+                    wiender_assert(createInfo.subpass < chainState.subpassCount, "wiender::vulkan_shader::vulkan_shader subpass is out of the post-process chain");
+                    wiender_assert(depthAttachment_ == ((createInfo.subpass == 0) && chainState.depthAttachment), "wiender::vulkan_shader::vulkan_shader scene shaders of a chain with depth have to test depth, other chain shaders cannot");
+                    subpass_ = createInfo.subpass;
+                    chainSubpassCount_ = chainState.subpassCount;
+                    chainKey_ = hash_value(subpass_, hash_value(chainSubpassCount_, hash_value(chainState.depthAttachment, hash_value(chainState.intermediateFormat))));
+                    targetFormat_ = chainState.intermediateFormat;
+                    colorFormat_ = (subpass_ + 1 == chainSubpassCount_) ? owner_->get_swapcahin_image_format().format : targetFormat_;
+                } else if (createInfo.target.samples != 0) {
+                    targetFormat_ = owner_->get_render_target_format(createInfo.target.targetFormat);
+                    colorFormat_ = targetFormat_;
+                    samples_ = owner_->get_render_target_samples(createInfo.target.samples);
+                } else {
+                    colorFormat_ = owner_->get_swapcahin_image_format().format;
+                    samples_ = owner_->get_msaa_samples();
+                }
+
+                std::vector<descriptor_set_layout_data> descriptorsInfos;
+                for (const auto& stage : createInfo.stages) {
+                    const shader_stage_reflection& reflection = owner_->get_reflection_cache().get(stage.code_size(), stage.code(), stage.codeHash);
+                    merge_descriptor_sets(descriptorsInfos, reflection.descriptorSets);
+                    merge_push_constant_range(pushConstantRange_, reflection.pushConstantRange);
+                    validate_specialization_constants(stage, reflection);
+                }
+                bindlessTextures_ = extract_bindless_texture_set(descriptorsInfos);
+
+                for (const auto& descriptorsInfo : descriptorsInfos) {
+                    wiender_assert(descriptorsInfo.setNumber < WIENDER_BINDLESS_TEXTURE_SET, "wiender::vulkan_shader::vulkan_shader set number has to be less than " WIENDER_TOSTRING(WIENDER_BINDLESS_TEXTURE_SET));
+                    descriptorSets_[descriptorsInfo.setNumber] = acquire_descriptor_set(descriptorsInfo);
+                    if (descriptorsInfo.setNumber == materialSet)
+                        materialSetInfo_ = descriptorsInfo;
+                    bind_input_attachments(descriptorsInfo, createInfo);
+                }
+
+                if (depthAttachment_ && (targetFormat_ != VK_FORMAT_UNDEFINED))
+                    owner_->require_depth_format(); // render targets and chains create their own depth images
+                else if (depthAttachment_)
+                    owner_->require_depth_attachment();
+                if (bindPoint_ == VK_PIPELINE_BIND_POINT_GRAPHICS)
+                    renderPass_ = create_render_pass(createInfo);
+
+                pipelineLayout_ = create_pipeline_layout();
+
+                descriptorSetsState_ = create_descriptor_sets_state();
+
+                pipelineLayoutHash_ = (descriptorSetsState_.setCount != 0)
+                    ? descriptorSetsState_.compatibilityHashes[descriptorSetsState_.setCount - 1]
+                    : hash_push_constant_range(pushConstantRange_);
+
+                pipeline_ = (bindPoint_ == VK_PIPELINE_BIND_POINT_COMPUTE) ? create_compute_pipeline(createInfo.stages.front()) : create_pipeline(createInfo);
+
+            } catch (...) {
+                accurate_destroy();
+                throw;
+            }
+
+        }
+
+        public:
+        ~vulkan_shader() override {
+            accurate_destroy();
+        }
+
+        public:
+        void set() override {
+            owner_->set_shader_state(get_shader_state());
+        }
+        using shader::get_uniform_buffer_info;
+        using shader::bind_texture;
+        using shader::bind_textures;
+        using shader::bind_buffer;
+        WIENDER_NODISCARD uniform_buffer_info get_uniform_buffer_info(std::size_t set, std::size_t binding) override {
+            return get_descriptor_set(set).get_uniform_buffer_info(binding);
+        }
+        void bind_texture(std::size_t set, std::size_t binding, std::size_t arrayIndex, const texture* tetr) override {
+            get_descriptor_set(set).bind_texture(binding, arrayIndex, tetr);
+        }
+        void bind_textures(std::size_t set, std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) override {
+            get_descriptor_set(set).bind_textures(binding, first, textures, count);
+        }
+        void bind_buffer(std::size_t set, std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) override {
+            get_descriptor_set(set).bind_buffer(binding, buff, offset, range);
+        }
+        WIENDER_NODISCARD active_shader_state get_shader_state() const noexcept {
+            return active_shader_state{
+                pipeline_,
+                pipelineLayout_,
+                renderPass_,
+                &descriptorSetsState_,
+                bindPoint_,
+                depthAttachment_,
+                targetFormat_,
+                samples_,
+                subpass_,
+                chainSubpassCount_,
+            };
+        }
+        WIENDER_NODISCARD const descriptor_sets_state& get_descriptor_sets_state() const noexcept {
+            return descriptorSetsState_;
+        }
+        WIENDER_NODISCARD const descriptor_set_layout_data& get_material_set_info() const {
+            wiender_assert(descriptorSets_[materialSet] != nullptr, "wiender::vulkan_shader::get_material_set_info shader does not declare the material set");
+            return materialSetInfo_;
+        }
+        WIENDER_NODISCARD push_constants_state get_push_constants_state() const noexcept {
+            return push_constants_state {
+                pipelineLayout_,
+                pushConstantRange_,
+            };
+        }
+
+        private:
+        WIENDER_NODISCARD vulkan_descriptor_set& get_descriptor_set(std::size_t set) const {
+            wiender_assert((set < WIENDER_BINDLESS_TEXTURE_SET) && (descriptorSets_[set] != nullptr), "wiender::vulkan_shader::get_descriptor_set shader has no set with this number");
+            return *descriptorSets_[set];
+        }
+        /**
+         * @brief Creates the set, frame and pass sets are looked up among sets of alive shaders first.
+         */
+        WIENDER_NODISCARD std::shared_ptr<vulkan_descriptor_set> acquire_descriptor_set(const descriptor_set_layout_data& descriptorsInfo) const {
+            if ((descriptorsInfo.setNumber != frameSet) && (descriptorsInfo.setNumber != passSet))
+                return std::make_shared<vulkan_descriptor_set>(owner_, descriptorsInfo);
+
+            std::weak_ptr<vulkan_descriptor_set>& shared = owner_->get_shared_descriptor_sets()[vulkan_descriptor_set::hash_layout(descriptorsInfo)];
+            std::shared_ptr<vulkan_descriptor_set> result = shared.lock();
+            if (result == nullptr) {
+                result = std::make_shared<vulkan_descriptor_set>(owner_, descriptorsInfo);
+                shared = result;
+            }
+            return result;
+        }
+        /**
+         * @brief Removes the device-wide texture table from reflected sets, it is not owned by the shader.
+         * @return true if the shader uses the table.
+         */
+        bool extract_bindless_texture_set(std::vector<descriptor_set_layout_data>& descriptorsInfos) const {
+            for (auto it = descriptorsInfos.begin(); it != descriptorsInfos.end(); ++it) {
+                if (it->setNumber != WIENDER_BINDLESS_TEXTURE_SET)
+                    continue;
+
+                wiender_assert(owner_->is_feature_supported(wienderer::feature::BINDLESS_TEXTURES), "wiender::vulkan_shader::extract_bindless_texture_set bindless textures are not supported by the device");
+                wiender_assert(
+                    (it->bindings.size() == 1) &&
+                    (it->bindings[0].binding == 0) &&
+                    (it->bindings[0].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER),
+                    "wiender::vulkan_shader::extract_bindless_texture_set set " WIENDER_TOSTRING(WIENDER_BINDLESS_TEXTURE_SET) " is reserved for the texture table (binding 0, sampler array)");
+                descriptorsInfos.erase(it);
+                return true;
+            }
+            return false;
+        }
+        /**
+         * @brief Points input attachments of the set to the color written by the previous subpass of the chain.
+         */
+        void bind_input_attachments(const descriptor_set_layout_data& descriptorsInfo, const create_info& createInfo) const {
+            for (const auto& binding : descriptorsInfo.bindings) {
+                if (binding.descriptorType != VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT)
+                    continue;
+                wiender_assert((createInfo.chain != nullptr) && (subpass_ != 0), "wiender::vulkan_shader::bind_input_attachments only post subpasses of a chain can read input attachments");
+                wiender_assert((descriptorsInfo.setNumber == drawSet) && (binding.descriptorCount == 1), "wiender::vulkan_shader::bind_input_attachments input attachment has to be a single binding of the draw set");
+                descriptorSets_[drawSet]->bind_input_attachment(binding.binding, get_vulkan_postprocess_chain_state(createInfo.chain).intermediateViews[(subpass_ - 1) % 2]);
+            }
+        }
+        static void validate_specialization_constants(const stage& shaderStage, const shader_stage_reflection& reflection) {
+            const std::vector<uint32_t>& reflectedIds = reflection.specializationConstantIds;
+
+            for (size_t i = 0; i < shaderStage.specializationConstants.size(); ++i) {
+                const uint32_t id = shaderStage.specializationConstants[i].id;
+                wiender_assert(std::find(reflectedIds.begin(), reflectedIds.end(), id) != reflectedIds.end(), "wiender::vulkan_shader::validate_specialization_constants specialization constant id is not declared in shader stage");
+                for (size_t j = 0; j < i; ++j) {
+                    wiender_assert(shaderStage.specializationConstants[j].id != id, "wiender::vulkan_shader::validate_specialization_constants specialization constant id is set twice");
+                }
+            }
+        }
+        WIENDER_NODISCARD static bool is_compute(const create_info& createInfo) {
+            const bool compute = std::any_of(createInfo.stages.begin(), createInfo.stages.end(), [](const stage& shaderStage) { return shaderStage.stageKind == stage::kind::COMPUTE; });
+            wiender_assert(!compute || (createInfo.stages.size() == 1), "wiender::vulkan_shader::is_compute compute stage cannot be combined with other stages");
+            return compute;
+        }
+        WIENDER_NODISCARD uint32_t get_set_layout_count() const noexcept {
+            if (bindlessTextures_)
+                return WIENDER_BINDLESS_TEXTURE_SET + 1;
+            uint32_t result = WIENDER_BINDLESS_TEXTURE_SET;
+            while ((result != 0) && (descriptorSets_[result - 1] == nullptr))
+                --result;
+            return result;
+        }
+
+        private:
+        void accurate_destroy() {
+            vkDeviceWaitIdle(owner_->get_ldevice());
+
+            if (pipeline_ != 0)
+                vkDestroyPipeline(owner_->get_ldevice(), pipeline_, WIENDER_CHILD_ALLOCATOR_NAME);
+            if (pipelineLayout_ != 0)
+                vkDestroyPipelineLayout(owner_->get_ldevice(), pipelineLayout_, WIENDER_CHILD_ALLOCATOR_NAME);
+            if (renderPass_ != 0)
+                vkDestroyRenderPass(owner_->get_ldevice(), renderPass_, WIENDER_CHILD_ALLOCATOR_NAME);
+
+            for (auto& descriptorSet : descriptorSets_)
+                descriptorSet.reset();
+        }
+
+        private:
+        WIENDER_NODISCARD VkPipeline create_pipeline(const create_info& createInfo) const {
+            const VkAllocationCallbacks* allocationCallbacks = nullptr;
+            wiender_assert(!createInfo.stages.empty(), "wiender::vulkan_shader::create_pipeline no shader stages for shader program");
+
+            std::vector<VkPipelineShaderStageCreateInfo> shaderStages(createInfo.stages.size());
+            std::vector<VkSpecializationInfo> specializationInfos(createInfo.stages.size());
+            std::vector<std::vector<VkSpecializationMapEntry>> specializationEntries(createInfo.stages.size());
+
+            for (uint32_t i = 0; i < createInfo.stages.size(); ++i) {
+                const auto& specializationConstants = createInfo.stages[i].specializationConstants;
+                auto& entries = specializationEntries[i];
+                entries.resize(specializationConstants.size());
+                for (size_t j = 0; j < entries.size(); ++j) {
+                    entries[j].constantID = specializationConstants[j].id;
+                    entries[j].offset = static_cast<uint32_t>(j * sizeof(stage::specialization_constant) + offsetof(stage::specialization_constant, value));
+                    entries[j].size = sizeof(specializationConstants[j].value);
+                }
+                specializationInfos[i].mapEntryCount = static_cast<uint32_t>(entries.size());
+                specializationInfos[i].pMapEntries = entries.data();
+                specializationInfos[i].dataSize = specializationConstants.size() * sizeof(stage::specialization_constant);
+                specializationInfos[i].pData = specializationConstants.data();
+
+                VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+                shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+             // shaderModuleCreateInfo.pNext = nullptr;
+             // shaderModuleCreateInfo.flags = static_cast<VkFlags>(0);
+                shaderModuleCreateInfo.codeSize = createInfo.stages[i].code_size();
+                shaderModuleCreateInfo.pCode = createInfo.stages[i].code();
+
+                vulkan_check(vkCreateShaderModule(owner_->get_ldevice(), &shaderModuleCreateInfo, allocationCallbacks, &shaderStages[i].module), "wiender::vulkan_shader::create_pipeline failed to create shader module");
+                shaderStages[i].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+             // shaderStages[i].pNext = nullptr;
+             // shaderStages[i].flags = static_cast<VkFlags>(0);
+                shaderStages[i].stage = shader_stage_kind_to_vk_shader_stage(createInfo.stages[i].stageKind);
+                shaderStages[i].pName = "main";
+                shaderStages[i].pSpecializationInfo = specializationInfos[i].mapEntryCount != 0 ? &specializationInfos[i] : nullptr;
+            }
+            std::vector<VkVertexInputBindingDescription> inputBindings;
+            if (createInfo.vertexInputBindings.empty()) {
+                uint32_t inputSize = 0; // end of the last attribute, mixed-size formats leave alignment gaps a plain sum would miss
+                for (const auto& vinputAttribute: createInfo.vertexInputAttributes)
+                    inputSize = std::max(inputSize, vinputAttribute.offset + static_cast<uint32_t>(sizeof_shader_vertex_input_attribute_format(vinputAttribute.inputFormat)));
+
+                VkVertexInputBindingDescription inputBinding{};
+             // inputBinding.binding = 0;
+                inputBinding.stride = inputSize;
+                inputBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+                inputBindings.emplace_back(inputBinding);
+            } else {
+                for (const auto& vinputBinding : createInfo.vertexInputBindings) {
+                    wiender_assert(vinputBinding.binding < WIENDER_VERTEX_BINDING_MAX_COUNT, "wiender::vulkan_shader::create_pipeline vertex binding has to be less than " WIENDER_TOSTRING(WIENDER_VERTEX_BINDING_MAX_COUNT));
+
+                    uint32_t inputSize = vinputBinding.stride;
+                    if (inputSize == 0) {
+                        for (const auto& vinputAttribute : createInfo.vertexInputAttributes) {
+                            if (vinputAttribute.binding == vinputBinding.binding)
+                                inputSize = std::max(inputSize, vinputAttribute.offset + static_cast<uint32_t>(sizeof_shader_vertex_input_attribute_format(vinputAttribute.inputFormat)));
+                        }
+                    }
+
+                    VkVertexInputBindingDescription inputBinding{};
+                    inputBinding.binding = vinputBinding.binding;
+                    inputBinding.stride = inputSize;
+                    inputBinding.inputRate = shader_vertex_input_rate_to_vk_vertex_input_rate(vinputBinding.inputRate);
+                    inputBindings.emplace_back(inputBinding);
+                }
+                for (const auto& vinputAttribute : createInfo.vertexInputAttributes) {
+                    const bool declared = std::any_of(inputBindings.begin(), inputBindings.end(), [&](const VkVertexInputBindingDescription& inputBinding) { return inputBinding.binding == vinputAttribute.binding; });
+                    wiender_assert(declared, "wiender::vulkan_shader::create_pipeline vertex attribute uses undeclared binding");
+                }
+            }
+
+            std::vector<VkVertexInputAttributeDescription> vkVertexInputAttributes(createInfo.vertexInputAttributes.size());
+            for (size_t i = 0; i < vkVertexInputAttributes.size(); ++i) {
+                const auto& iattr = createInfo.vertexInputAttributes[i];
+
+                auto& vkdesc = vkVertexInputAttributes[i];
+                vkdesc.location = iattr.location;
+                vkdesc.binding = iattr.binding;
                 vkdesc.format = shader_vertex_input_attribute_format_to_vk_format(iattr.inputFormat);
                 vkdesc.offset = iattr.offset;
+
+                VkFormatProperties formatProperties{};
+                vkGetPhysicalDeviceFormatProperties(owner_->get_pdevice(), vkdesc.format, &formatProperties);
+                wiender_assert((formatProperties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) != 0, "wiender::vulkan_shader::create_pipeline vertex attribute format isn't supported by the device");
             }
 
             VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
             vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
          // vertexInputInfo.pNext = nullptr;
          // vertexInputInfo.flags = static_cast<VkFlags>(0);
-            vertexInputInfo.vertexBindingDescriptionCount = 1;
-            vertexInputInfo.pVertexBindingDescriptions = &inputBinding;
+            vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(inputBindings.size());
+            vertexInputInfo.pVertexBindingDescriptions = inputBindings.data();
             vertexInputInfo.vertexAttributeDescriptionCount = vkVertexInputAttributes.size();
             vertexInputInfo.pVertexAttributeDescriptions = vkVertexInputAttributes.data();
 
@@ -2107,23 +5242,15 @@ namespace wiender {
             inputAssembly.topology = shader_primitive_topology_to_vk_primitive_topology(createInfo.topology);
             inputAssembly.primitiveRestartEnable = VK_FALSE;
             
-            const VkRect2D scissors {
-                {0, 0},
-                owner_->get_swapchain_extent(),
-            };
-            const VkViewport view {
-                0.0f, 0.0f,
-                (float)owner_->get_swapchain_extent().width, (float)owner_->get_swapchain_extent().height,
-                0.0f, 1.0f,
-            };
+            // dynamic, `vulkan_wienderer::begin_render` sets them to cover the window or the render target
             VkPipelineViewportStateCreateInfo viewportState{};
             viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
          // viewportState.pNext = nullptr;
          // viewportState.flags = static_cast<VkFlags>(0);
             viewportState.viewportCount = 1;
-            viewportState.pViewports = &view;
+         // viewportState.pViewports = nullptr;
             viewportState.scissorCount = 1;
-            viewportState.pScissors = &scissors;
+         // viewportState.pScissors = nullptr;
 
             VkPipelineRasterizationStateCreateInfo rasterizer{};
             rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
@@ -2145,8 +5272,8 @@ namespace wiender {
             multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
          // multisampling.pNext = nullptr;
          // multisampling.flags = static_cast<VkFlags>(0); 
-            multisampling.rasterizationSamples = owner_->get_msaa_samples();
-            multisampling.sampleShadingEnable = owner_->is_multisampling_enabled();
+            multisampling.rasterizationSamples = samples_;
+            multisampling.sampleShadingEnable = static_cast<VkBool32>(samples_ != VK_SAMPLE_COUNT_1_BIT);
          // multisampling.minSampleShading = 0;
          // multisampling.pSampleMask = 0;
             multisampling.alphaToCoverageEnable = VK_FALSE;
@@ -2157,8 +5284,8 @@ namespace wiender {
          // depthStencil.pNext = nullptr;
          // depthStencil.flags = static_cast<VkFlags>(0);
             depthStencil.depthTestEnable = VK_TRUE;
-            depthStencil.depthWriteEnable = VK_TRUE;
-            depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+            depthStencil.depthWriteEnable = static_cast<VkBool32>(createInfo.depthMode == depth_mode::TEST_AND_WRITE);
+            depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL; // equal depth keeps submission order, like no depth
             depthStencil.depthBoundsTestEnable = VK_FALSE;
             depthStencil.stencilTestEnable = VK_FALSE;
          // depthStencil.front = {};
@@ -2187,12 +5314,13 @@ namespace wiender {
             colorBlending.pAttachments = &colorBlendAttachment;
          // colorBlending.blendConstants = {};
 
+            const VkDynamicState dynamicStates[] { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
             VkPipelineDynamicStateCreateInfo dynamicState{};
             dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
          // dynamicState.pNext = nullptr;
          // dynamicState.flags = static_cast<VkFlags>(0);
-         // dynamicState.dynamicStateCount = createInfo.dynamicStateCount;   TODO
-         // dynamicState.pDynamicStates = createInfo.dynamicStates;
+            dynamicState.dynamicStateCount = static_cast<uint32_t>(WIENDER_ARRSIZE(dynamicStates));
+            dynamicState.pDynamicStates = dynamicStates;
 
             VkGraphicsPipelineCreateInfo pipelineInfo{};
             pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -2206,193 +5334,306 @@ namespace wiender {
             pipelineInfo.pViewportState = &viewportState;
             pipelineInfo.pRasterizationState = &rasterizer;
             pipelineInfo.pMultisampleState = &multisampling;
-            pipelineInfo.pDepthStencilState = false ? &depthStencil : nullptr; // TODO
+            pipelineInfo.pDepthStencilState = depthAttachment_ ? &depthStencil : nullptr;
             pipelineInfo.pColorBlendState = &colorBlending;
             pipelineInfo.pDynamicState = &dynamicState;
             pipelineInfo.layout = pipelineLayout_;
             pipelineInfo.renderPass = renderPass_;
-            pipelineInfo.subpass = 0;
+            pipelineInfo.subpass = subpass_;
             pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
             pipelineInfo.basePipelineIndex = 0;
 
             VkPipeline newPipeline;
-            vulkan_check(vkCreateGraphicsPipelines(owner_->get_ldevice(), VK_NULL_HANDLE, 1, &pipelineInfo, allocationCallbacks, &newPipeline), "wienderer::vulkan_shader::create_pipeline failed to create create pipeline");
+            if (owner_->is_feature_supported(wienderer::feature::FAST_PIPELINE_LINKING)) {
+                newPipeline = link_pipeline(pipelineInfo, createInfo);
+            } else {
+                vulkan_check(vkCreateGraphicsPipelines(owner_->get_ldevice(), owner_->get_pipeline_cache(), 1, &pipelineInfo, allocationCallbacks, &newPipeline), "wienderer::vulkan_shader::create_pipeline failed to create create pipeline");
+            }
             for (const auto& stage : shaderStages)
                 vkDestroyShaderModule(owner_->get_ldevice(), stage.module, allocationCallbacks);
 
             return newPipeline;
         }
+        WIENDER_NODISCARD VkPipeline create_compute_pipeline(const stage& computeStage) const {
+            const auto& specializationConstants = computeStage.specializationConstants;
+            std::vector<VkSpecializationMapEntry> entries(specializationConstants.size());
+            for (size_t j = 0; j < entries.size(); ++j) {
+                entries[j].constantID = specializationConstants[j].id;
+                entries[j].offset = static_cast<uint32_t>(j * sizeof(stage::specialization_constant) + offsetof(stage::specialization_constant, value));
+                entries[j].size = sizeof(specializationConstants[j].value);
+            }
+            VkSpecializationInfo specializationInfo{};
+            specializationInfo.mapEntryCount = static_cast<uint32_t>(entries.size());
+            specializationInfo.pMapEntries = entries.data();
+            specializationInfo.dataSize = specializationConstants.size() * sizeof(stage::specialization_constant);
+            specializationInfo.pData = specializationConstants.data();
+
+            VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+            shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+         // shaderModuleCreateInfo.pNext = nullptr;
+         // shaderModuleCreateInfo.flags = static_cast<VkFlags>(0);
+            shaderModuleCreateInfo.codeSize = computeStage.code_size();
+            shaderModuleCreateInfo.pCode = computeStage.code();
+
+            VkComputePipelineCreateInfo pipelineInfo{};
+            pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+         // pipelineInfo.pNext = nullptr;
+         // pipelineInfo.flags = static_cast<VkFlags>(0);
+            pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+            pipelineInfo.stage.pName = "main";
+            pipelineInfo.stage.pSpecializationInfo = (specializationInfo.mapEntryCount != 0) ? &specializationInfo : nullptr;
+            pipelineInfo.layout = pipelineLayout_;
+            pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+            pipelineInfo.basePipelineIndex = -1;
+
+            vulkan_check(vkCreateShaderModule(owner_->get_ldevice(), &shaderModuleCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &pipelineInfo.stage.module), "wiender::vulkan_shader::create_compute_pipeline failed to create shader module");
+
+            VkPipeline newPipeline;
+            const VkResult result = vkCreateComputePipelines(owner_->get_ldevice(), owner_->get_pipeline_cache(), 1, &pipelineInfo, WIENDER_CHILD_ALLOCATOR_NAME, &newPipeline);
+            vkDestroyShaderModule(owner_->get_ldevice(), pipelineInfo.stage.module, WIENDER_CHILD_ALLOCATOR_NAME);
+            vulkan_check(result, "wiender::vulkan_shader::create_compute_pipeline failed to create compute pipeline");
+            return newPipeline;
+        }
+        /**
+         * @brief Builds the pipeline from four graphics pipeline libraries cached by the owner.
+         *
+         * Each part is keyed only by the state it consumes, so fixed-function variants of the same
+         * stages reuse the compiled shader parts and only pay for the final (fast) link.
+         */
+        WIENDER_NODISCARD VkPipeline link_pipeline(const VkGraphicsPipelineCreateInfo& pipelineInfo, const create_info& createInfo) const {
+            const VkPipelineVertexInputStateCreateInfo& vertexInput = *pipelineInfo.pVertexInputState;
+            const VkPipelineRasterizationStateCreateInfo& rasterizer = *pipelineInfo.pRasterizationState;
+            const VkPipelineMultisampleStateCreateInfo& multisampling = *pipelineInfo.pMultisampleState;
+
+            // render passes of wiender are compatible as long as formats and sample counts match, chain ones as long as their structure does
+            const uint64_t renderPassKey = hash_value(chainKey_, hash_value(depthAttachment_, hash_value(multisampling.rasterizationSamples, hash_value(colorFormat_))));
+
+            uint64_t vertexInputKey = hash_value(pipelineInfo.pInputAssemblyState->topology);
+            for (uint32_t i = 0; i < vertexInput.vertexBindingDescriptionCount; ++i)
+                vertexInputKey = hash_value(vertexInput.pVertexBindingDescriptions[i], vertexInputKey);
+            for (uint32_t i = 0; i < vertexInput.vertexAttributeDescriptionCount; ++i)
+                vertexInputKey = hash_value(vertexInput.pVertexAttributeDescriptions[i], vertexInputKey);
+
+            uint64_t preRasterizationKey = hash_value(pipelineLayoutHash_, renderPassKey);
+            preRasterizationKey = hash_value(rasterizer.polygonMode, preRasterizationKey);
+            preRasterizationKey = hash_value(rasterizer.cullMode, preRasterizationKey);
+            preRasterizationKey = hash_value(rasterizer.frontFace, preRasterizationKey);
+
+            uint64_t fragmentShaderKey = hash_value(pipelineLayoutHash_, renderPassKey);
+            fragmentShaderKey = hash_value(multisampling.sampleShadingEnable, fragmentShaderKey);
+            fragmentShaderKey = hash_value(pipelineInfo.pDepthStencilState != nullptr, fragmentShaderKey);
+            if (pipelineInfo.pDepthStencilState != nullptr)
+                fragmentShaderKey = hash_value(pipelineInfo.pDepthStencilState->depthWriteEnable, fragmentShaderKey);
+
+            const uint64_t fragmentOutputKey = hash_value(createInfo.alphaBlend, renderPassKey);
+
+            std::vector<VkPipelineShaderStageCreateInfo> preRasterizationStages;
+            std::vector<VkPipelineShaderStageCreateInfo> fragmentStages;
+            for (uint32_t i = 0; i < pipelineInfo.stageCount; ++i) {
+                const stage& shaderStage = createInfo.stages[i];
+                uint64_t stageKey = shaderStage.codeHash != 0 ? shaderStage.codeHash : spirv_code_hash(shaderStage.code_size(), shaderStage.code());
+                stageKey = hash_bytes(shaderStage.specializationConstants.data(), shaderStage.specializationConstants.size() * sizeof(stage::specialization_constant), stageKey);
+
+                if (pipelineInfo.pStages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+                    fragmentStages.emplace_back(pipelineInfo.pStages[i]);
+                    fragmentShaderKey = hash_value(stageKey, fragmentShaderKey);
+                } else {
+                    preRasterizationStages.emplace_back(pipelineInfo.pStages[i]);
+                    preRasterizationKey = hash_value(stageKey, preRasterizationKey);
+                }
+            }
+
+            VkGraphicsPipelineCreateInfo vertexInputPart{};
+            vertexInputPart.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            vertexInputPart.pVertexInputState = pipelineInfo.pVertexInputState;
+            vertexInputPart.pInputAssemblyState = pipelineInfo.pInputAssemblyState;
+
+            VkGraphicsPipelineCreateInfo preRasterizationPart{};
+            preRasterizationPart.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            preRasterizationPart.stageCount = static_cast<uint32_t>(preRasterizationStages.size());
+            preRasterizationPart.pStages = preRasterizationStages.data();
+            preRasterizationPart.pTessellationState = pipelineInfo.pTessellationState;
+            preRasterizationPart.pViewportState = pipelineInfo.pViewportState;
+            preRasterizationPart.pRasterizationState = pipelineInfo.pRasterizationState;
+            preRasterizationPart.pDynamicState = pipelineInfo.pDynamicState;
+            preRasterizationPart.layout = pipelineInfo.layout;
+            preRasterizationPart.renderPass = pipelineInfo.renderPass;
+            preRasterizationPart.subpass = pipelineInfo.subpass;
+
+            VkGraphicsPipelineCreateInfo fragmentShaderPart{};
+            fragmentShaderPart.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            fragmentShaderPart.stageCount = static_cast<uint32_t>(fragmentStages.size());
+            fragmentShaderPart.pStages = fragmentStages.data();
+            fragmentShaderPart.pMultisampleState = pipelineInfo.pMultisampleState;
+            fragmentShaderPart.pDepthStencilState = pipelineInfo.pDepthStencilState;
+            fragmentShaderPart.layout = pipelineInfo.layout;
+            fragmentShaderPart.renderPass = pipelineInfo.renderPass;
+            fragmentShaderPart.subpass = pipelineInfo.subpass;
+
+            VkGraphicsPipelineCreateInfo fragmentOutputPart{};
+            fragmentOutputPart.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            fragmentOutputPart.pMultisampleState = pipelineInfo.pMultisampleState;
+            fragmentOutputPart.pColorBlendState = pipelineInfo.pColorBlendState;
+            fragmentOutputPart.renderPass = pipelineInfo.renderPass;
+            fragmentOutputPart.subpass = pipelineInfo.subpass;
+
+            const VkPipeline libraries[] = {
+                owner_->get_pipeline_library(vertexInputKey, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT, vertexInputPart),
+                owner_->get_pipeline_library(preRasterizationKey, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT, preRasterizationPart),
+                owner_->get_pipeline_library(fragmentShaderKey, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT, fragmentShaderPart),
+                owner_->get_pipeline_library(fragmentOutputKey, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT, fragmentOutputPart),
+            };
+
+            VkPipelineLibraryCreateInfoKHR linkInfo{};
+            linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+         // linkInfo.pNext = nullptr;
+            linkInfo.libraryCount = static_cast<uint32_t>(WIENDER_ARRSIZE(libraries));
+            linkInfo.pLibraries = libraries;
+
+            VkGraphicsPipelineCreateInfo linkedInfo{};
+            linkedInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+            linkedInfo.pNext = &linkInfo;
+         // linkedInfo.flags = static_cast<VkFlags>(0); // no link time optimization, fast link
+            linkedInfo.layout = pipelineInfo.layout;
+
+            VkPipeline result;
+            vulkan_check(vkCreateGraphicsPipelines(owner_->get_ldevice(), owner_->get_pipeline_cache(), 1, &linkedInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result), "wienderer::vulkan_shader::link_pipeline failed to link pipeline libraries");
+            return result;
+        }
+        WIENDER_NODISCARD static uint64_t hash_push_constant_range(const VkPushConstantRange& pushConstantRange) {
+            uint64_t result = hash_value(pushConstantRange.stageFlags);
+            result = hash_value(pushConstantRange.offset, result);
+            result = hash_value(pushConstantRange.size, result);
+            return result;
+        }
+        WIENDER_NODISCARD descriptor_sets_state create_descriptor_sets_state() const {
+            descriptor_sets_state result{};
+            result.setCount = get_set_layout_count();
+
+            const uint32_t imageCount = owner_->get_swapchain_image_count();
+            uint64_t compatibilityHash = hash_push_constant_range(pushConstantRange_);
+            for (uint32_t setNumber = 0; setNumber < result.setCount; ++setNumber) {
+                if (setNumber == WIENDER_BINDLESS_TEXTURE_SET) {
+                    compatibilityHash = hash_value(owner_->get_bindless_texture_layout(), compatibilityHash);
+                    for (uint32_t i = 0; i < imageCount; ++i)
+                        result.sets[setNumber][i] = owner_->get_bindless_texture_set();
+                } else if (descriptorSets_[setNumber] != nullptr) {
+                    compatibilityHash = hash_value(descriptorSets_[setNumber]->get_layout_hash(), compatibilityHash);
+                    for (uint32_t i = 0; i < imageCount; ++i)
+                        result.sets[setNumber][i] = descriptorSets_[setNumber]->get_set(i);
+                } else {
+                    compatibilityHash = hash_value(owner_->get_empty_set_layout(), compatibilityHash); // nothing to bind
+                }
+                result.compatibilityHashes[setNumber] = compatibilityHash;
+            }
+            return result;
+        }
         WIENDER_NODISCARD VkPipelineLayout create_pipeline_layout() const {
             VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
             pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
          // pipelineLayoutCreateInfo.pNext = nullptr;
          // pipelineLayoutCreateInfo.flags = static_cast<VkFlags>(0);
-            pipelineLayoutCreateInfo.setLayoutCount = descriptorSetLayout_ ? 1u : 0u;
-            pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayout_ ? &descriptorSetLayout_ : nullptr;
-         // pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-         // pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+            VkDescriptorSetLayout setLayouts[WIENDER_DESCRIPTOR_SET_MAX_COUNT];
+            const uint32_t setLayoutCount = get_set_layout_count();
+            for (uint32_t setNumber = 0; setNumber < setLayoutCount; ++setNumber) {
+                if (setNumber == WIENDER_BINDLESS_TEXTURE_SET)
+                    setLayouts[setNumber] = owner_->get_bindless_texture_layout();
+                else if (descriptorSets_[setNumber] != nullptr)
+                    setLayouts[setNumber] = descriptorSets_[setNumber]->get_layout();
+                else
+                    setLayouts[setNumber] = owner_->get_empty_set_layout();
+            }
+
+            pipelineLayoutCreateInfo.setLayoutCount = setLayoutCount;
+            pipelineLayoutCreateInfo.pSetLayouts = (setLayoutCount != 0) ? setLayouts : nullptr;
+            pipelineLayoutCreateInfo.pushConstantRangeCount = (pushConstantRange_.size != 0) ? 1u : 0u;
+            pipelineLayoutCreateInfo.pPushConstantRanges = (pushConstantRange_.size != 0) ? &pushConstantRange_ : nullptr;
 
             VkPipelineLayout newPipelineLayout;
             vulkan_check(vkCreatePipelineLayout(owner_->get_ldevice(), &pipelineLayoutCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &newPipelineLayout), "wienderer::vulkan_shader::create_pipeline_layout failed to create create pipeline layout");
             return newPipelineLayout;
         }
         WIENDER_NODISCARD VkRenderPass create_render_pass(const create_info& createInfo) const {
-            return owner_->create_default_render_pass(createInfo.clearScreen ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE);
-        }
-        WIENDER_NODISCARD VkDescriptorSet create_descriptor_set(const descriptor_set_layout_data& descriptorInfo) {
-            VkDescriptorSetAllocateInfo allocationInfo{};
-            allocationInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-         // allocationInfo.pNext = nullptr;
-            allocationInfo.descriptorPool = descriptorPool_;
-            allocationInfo.descriptorSetCount = 1;
-            allocationInfo.pSetLayouts = &descriptorSetLayout_;
-
-            VkDescriptorSet result;
-            vulkan_check(vkAllocateDescriptorSets(owner_->get_ldevice(), &allocationInfo, &result), "wiender::vulkan_shader::create_descriptor_set failed to allocate descriptor set");
-
-            for (size_t i = 0; i < descriptorInfo.bindings.size(); ++i) {
-                const auto& setBinding = descriptorInfo.bindings[i];
-                const auto& bindingBufferInfo = descriptorInfo.bufferSizes[i];
-
-                const uint32_t binding = setBinding.binding;
-
-                VkDescriptorBufferInfo bufferInfo{};
-                bufferInfo.range = bindingBufferInfo;
-                bufferInfo.offset = 0;
-                bufferInfo.buffer = uniformBuffers_.buffers[binding].buffer;
-
-                VkDescriptorImageInfo imageInfo{};
-                imageInfo.sampler = owner_->get_default_sampler();
-                imageInfo.imageView = owner_->get_default_texture_image().view;
-                imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-                VkWriteDescriptorSet write{};
-                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-             // write.pNext = nullptr;
-                write.dstSet = result;
-                write.dstBinding = binding;
-                write.dstArrayElement = 0;
-                write.descriptorCount = setBinding.descriptorCount;
-                write.pTexelBufferView = nullptr;
-                write.descriptorType = setBinding.descriptorType;
-
-                if (
-                    (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER) ||
-                    (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) ||
-                    (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_INLINE_UNIFORM_BLOCK) ||
-                    (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC) ||
-                    (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)) {
-                    write.pBufferInfo = &bufferInfo;
-
-                } else if (setBinding.descriptorType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) {
-                    write.pImageInfo = &imageInfo;
-                    
-                } else {
-                    continue;
-                }
-
-                vkUpdateDescriptorSets(owner_->get_ldevice(), 1, &write, 0, nullptr);
+            if (createInfo.chain != nullptr) { // a compatible copy, the shader doesn't depend on the chain after creation
+                const postprocess_chain_state& chainState = get_vulkan_postprocess_chain_state(createInfo.chain);
+                return owner_->create_postprocess_render_pass(chainState.intermediateFormat, chainState.subpassCount, chainState.depthAttachment);
             }
-            return result;
+            if (targetFormat_ != VK_FORMAT_UNDEFINED) {
+                return owner_->create_target_render_pass(
+                    targetFormat_,
+                    samples_,
+                    createInfo.clearScreen ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+                    depthAttachment_,
+                    createInfo.clearDepth ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD
+                );
+            }
+            return owner_->create_default_render_pass(
+                createInfo.clearScreen ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+                depthAttachment_,
+                createInfo.clearDepth ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD
+            );
         }
+    };
+    WIENDER_NODISCARD std::unique_ptr<shader> create_vulkan_shader(vulkan_wienderer* owner, const shader::create_info& createInfo) {
+        return std::unique_ptr<vulkan_shader>(new vulkan_shader(owner, createInfo));
+    }
+    WIENDER_NODISCARD push_constants_state get_vulkan_shader_push_constants_state(const shader* shad) {
+        return static_cast<const vulkan_shader*>(shad)->get_push_constants_state();
+    }
 
-        WIENDER_NODISCARD VkDescriptorSetLayout create_descriptor_set_layout(const descriptor_set_layout_data& descriptorInfo) { // TODO: multiple sets
-            const auto& bindings = descriptorInfo.bindings;
-            std::vector<VkDescriptorBindingFlags> flags;
+    struct vulkan_material final : public material {
+        public:
+        vulkan_wienderer* owner_;
+        const vulkan_shader* shader_;
+        std::unique_ptr<vulkan_descriptor_set> descriptorSet_;
+        descriptor_sets_state descriptorSetsState_; // shader sets with the material set replaced
 
-            flags.resize(bindings.size());
-            for (size_t i = 0; i < flags.size(); ++i) {
-                if (bindings[i].descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
-                    flags[i] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
-                } else {
-                    flags[i] = static_cast<VkFlags>(0);
-                }
+        public:
+        vulkan_material(vulkan_wienderer* owner, const vulkan_shader* shad) :
+            owner_(owner),
+            shader_(shad),
+            descriptorSet_{},
+            descriptorSetsState_{} {
+
+            if ((owner_ == nullptr) || (shader_ == nullptr)) {
+                throw std::runtime_error("wiender::vulkan_material::vulkan_material owner and shader cannot be nullptr");
             }
 
-            VkDescriptorSetLayoutBindingFlagsCreateInfo bindingsFlags{};
-            bindingsFlags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
-            bindingsFlags.pBindingFlags = flags.data();
-            bindingsFlags.bindingCount = flags.size();
+            descriptorSet_.reset(new vulkan_descriptor_set(owner_, shader_->get_material_set_info()));
 
-            VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = descriptorInfo.createInfo;
-            descriptorSetLayoutCreateInfo.pNext = &bindingsFlags;
-            descriptorSetLayoutCreateInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
-
-            VkDescriptorSetLayout result;
-            vulkan_check(vkCreateDescriptorSetLayout(owner_->get_ldevice(), &descriptorSetLayoutCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result), "wiender::vulka_shader::create_descriptor_set_layout failed to create descriptors set layout");
-            return result;
+            descriptorSetsState_ = shader_->get_descriptor_sets_state();
+            for (uint32_t i = 0; i < owner_->get_swapchain_image_count(); ++i)
+                descriptorSetsState_.sets[shader::materialSet][i] = descriptorSet_->get_set(i);
+            // identically defined layout, so compatibility hashes of the shader stay valid
         }
-        WIENDER_NODISCARD VkDescriptorPool create_descriptor_pool(const descriptor_set_layout_data& descriptorInfo) const { // TODO: multiple sets
-            std::vector<VkDescriptorPoolSize> poolSizes;
-
-            for (const auto& bindingInfo : descriptorInfo.bindings) {
-                poolSizes.emplace_back(VkDescriptorPoolSize{bindingInfo.descriptorType, bindingInfo.descriptorCount});
-            }
-            
-            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
-            descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-         // descriptorPoolCreateInfo.pNext = nullptr;
-            descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;//static_cast<VkFlags>(0); WATCH
-            descriptorPoolCreateInfo.maxSets = 1;
-            descriptorPoolCreateInfo.poolSizeCount = poolSizes.size();
-            descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
 
-            VkDescriptorPool result;
-            vulkan_check(vkCreateDescriptorPool(owner_->get_ldevice(), &descriptorPoolCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result), "wiender::vulkan_shader::create_descriptor_pool failed to create descriptor pool");
-            return result;
+        public:
+        ~vulkan_material() override {
+            vkDeviceWaitIdle(owner_->get_ldevice());
         }
-        WIENDER_NODISCARD uniform_buffers_info create_uniform_buffers(const descriptor_set_layout_data& descriptorsInfo) const { // TODO: multiple sets
-            uniform_buffers_info result;
-            for (size_t i = 0; i < descriptorsInfo.bindings.size(); ++i) {
-                const auto& bindingInfo = descriptorsInfo.bindings[i];
-                const auto& bufferSize = descriptorsInfo.bufferSizes[i];
-                if (bindingInfo.descriptorType != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-                    continue;
-                wiender_assert(bindingInfo.binding < WIENDER_UNIFORM_BUFFER_MAX_COUNT, "wiender::vulkan_shader::create_uniform_buffers uniform buffer binding has to be less than" WIENDER_TOSTRING(WIENDER_UNIFORM_BUFFER_MAX_COUNT));
-                wiender_assert(bufferSize != 0, "wiender::vulkan_shader::create_uniform_buffers uniform buffer size must be more than zero");
-                result.buffers[bindingInfo.binding].size = bufferSize >= 128 ? bufferSize : 128; // 128 - maximum align
-            }
-            
-            VkDeviceSize totalBufferSize = 0;
-            for (uint32_t i = 0; i < WIENDER_UNIFORM_BUFFER_MAX_COUNT; ++i)
-                totalBufferSize += result.buffers[i].size;
-            if (totalBufferSize == 0) {
-                return uniform_buffers_info{};
-            }
 
-            VkMemoryAllocateInfo allocationInfo{};
-            allocationInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-         // allocationInfo.pNext = nullptr;
-            allocationInfo.allocationSize = totalBufferSize;
-            allocationInfo.memoryTypeIndex = owner_->find_memory_type(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-            
-            vulkan_check(vkAllocateMemory(owner_->get_ldevice(), &allocationInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result.memory), "wiender::vulkan_shader::create_uniform_buffers failed to allocate memoey for uniform buffers");
-
-            VkDeviceSize offset = 0;
-            for (uint32_t i = 0; i < WIENDER_UNIFORM_BUFFER_MAX_COUNT; ++i)  {
-                if (result.buffers[i].size == 0)
-                    continue;
-                
-                VkBufferCreateInfo bufferCreateInfo{};
-                bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-             // bufferCreateInfo.pNext = nullptr;
-             // bufferCreateInfo.flags = static_cast<VkFlags>(0); //VK_BUFFER_CREATE_SPARSE_ALIASED_BIT | VK_BUFFER_CREATE_SPARSE_BINDING_BIT,
-                bufferCreateInfo.size = result.buffers[i].size;
-                bufferCreateInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
-                bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-                bufferCreateInfo.queueFamilyIndexCount = 1;
-                bufferCreateInfo.pQueueFamilyIndices = &owner_->get_pdevice().queueIndeces.graphicsFamily;
-
-                vulkan_check(vkCreateBuffer(owner_->get_ldevice(), &bufferCreateInfo, WIENDER_CHILD_ALLOCATOR_NAME, &result.buffers[i].buffer), "wiender::vulkan_shader::create_uniform_buffers");
-                vulkan_check(vkBindBufferMemory(owner_->get_ldevice(), result.buffers[i].buffer, result.memory, offset), "wiender::vulkan_shader::create_uniform_buffers");
-                offset += result.buffers[i].size;
-            }
-            vulkan_check(vkMapMemory(owner_->get_ldevice(), result.memory, 0, totalBufferSize, static_cast<VkFlags>(0), &result.mappedMemory), "wiender::vulkan_shader::create_uniform_buffers");
-            return result;
+        public:
+        void set() override {
+            active_shader_state state = shader_->get_shader_state();
+            state.descriptorSets = &descriptorSetsState_;
+            owner_->set_shader_state(state);
+        }
+        WIENDER_NODISCARD shader::uniform_buffer_info get_uniform_buffer_info(std::size_t binding) override {
+            return descriptorSet_->get_uniform_buffer_info(binding);
+        }
+        void bind_texture(std::size_t binding, std::size_t arrayIndex, const texture* tetr) override {
+            descriptorSet_->bind_texture(binding, arrayIndex, tetr);
+        }
+        void bind_textures(std::size_t binding, std::size_t first, const texture* const* textures, std::size_t count) override {
+            descriptorSet_->bind_textures(binding, first, textures, count);
+        }
+        void bind_buffer(std::size_t binding, const buffer* buff, std::size_t offset, std::size_t range) override {
+            descriptorSet_->bind_buffer(binding, buff, offset, range);
         }
     };
-    WIENDER_NODISCARD std::unique_ptr<shader> create_vulkan_shader(vulkan_wienderer* owner, const shader::create_info& createInfo) {
-        return std::unique_ptr<vulkan_shader>(new vulkan_shader(owner, createInfo));
+    WIENDER_NODISCARD std::unique_ptr<material> create_vulkan_material(vulkan_wienderer* owner, const shader* shad) {
+        return std::unique_ptr<vulkan_material>(new vulkan_material(owner, static_cast<const vulkan_shader*>(shad)));
     }
     
 } // namespace wiender
\ No newline at end of file
@@ -13,3 +13,23 @@ std::unique_ptr<wiender::wienderer> wiender::create_wienderer(wiender::backend_t
     }
     // unreachable
 }
+std::unique_ptr<wiender::wienderer> wiender::create_headless_wienderer(wiender::backend_type backendType, uint32_t width, uint32_t height) {
+    switch (backendType) {
+        case wiender::backend_type::VULKAN: {
+            return std::unique_ptr<vulkan_wienderer>(new vulkan_wienderer(width, height));
+        } default: {
+            throw std::runtime_error("wiender::create_headless_wienderer unknown backend_type");
+        }
+    }
+    // unreachable
+}
+std::shared_ptr<wiender::context> wiender::create_context(wiender::backend_type backendType) {
+    switch (backendType) {
+        case wiender::backend_type::VULKAN: {
+            return std::make_shared<vulkan_context>(false);
+        } default: {
+            throw std::runtime_error("wiender::create_context unknown backend_type");
+        }
+    }
+    // unreachable
+}
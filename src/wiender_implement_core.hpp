@@ -3,6 +3,8 @@
 
 #include <pickmelib/reado.hpp>
 #include <stdexcept>
+#include <cstddef>
+#include <cstdint>
 
 namespace wiender {
     void wiender_assert(bool v, const wcs::tiny_string_view<char>& strv) {
@@ -10,6 +12,21 @@ namespace wiender {
             throw std::runtime_error(strv.c_str());
         }
     } 
+    uint64_t hash_bytes(const void* data, std::size_t size, uint64_t hash = 14695981039346656037ull) { // FNV-1a
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+    uint64_t align_up(uint64_t value, uint64_t alignment) { // alignment is a power of two
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+    template<class T>
+    uint64_t hash_value(const T& value, uint64_t hash = 14695981039346656037ull) {
+        return hash_bytes(&value, sizeof(T), hash);
+    }
 } // namespace wiender
 
 #endif // WIENDER_IMPLEMENT_CORE_HPP_
\ No newline at end of file
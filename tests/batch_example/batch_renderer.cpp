@@ -56,7 +56,7 @@ batch_renderer::batch_renderer(wienderer* wrer, uint32_t maxVertices, overflow_s
             },
             std::vector<vertex_input_attribute>{
                 vertex_input_attribute(vertex_input_attribute::format::FLOAT_VEC2, 0, 0, 0),
-                vertex_input_attribute(vertex_input_attribute::format::FLOAT_VEC2, 1, offsetof(invertex, uv), 0),
+                vertex_input_attribute(vertex_input_attribute::format::UNORM8_VEC2, 1, offsetof(invertex, uv), 0),
                 vertex_input_attribute(vertex_input_attribute::format::FLOAT_SCALAR, 2, offsetof(invertex, textureId), 0)
             },
             primitive_topology::TRIANGLES_LIST,
@@ -119,9 +119,9 @@ void batch_renderer::add_triangle(const batch_renderer::triangle& tri, const wie
     if (textureIndex < 0.0f) {
         __BATCH_RENDERER_BATCH_OVERFLOW
     }
-    vertexData_[currentVertex_] =       invertex{ tri.vertices[0].pos, vec2(0.0f, 0.0f), textureIndex};
-    vertexData_[currentVertex_ + 1] =   invertex{ tri.vertices[1].pos, vec2(1.0f, 0.0f), textureIndex};
-    vertexData_[currentVertex_ + 2] =   invertex{ tri.vertices[2].pos, vec2(0.0f, 1.0f), textureIndex};
+    vertexData_[currentVertex_] =       invertex{ tri.vertices[0].pos, u8vec2(0, 0), textureIndex};
+    vertexData_[currentVertex_ + 1] =   invertex{ tri.vertices[1].pos, u8vec2(255, 0), textureIndex};
+    vertexData_[currentVertex_ + 2] =   invertex{ tri.vertices[2].pos, u8vec2(0, 255), textureIndex};
     indexData_[currentIndex_] =         currentVertex_;
     indexData_[currentIndex_ + 1] =     currentVertex_ + 1;
     indexData_[currentIndex_ + 2] =     currentVertex_ + 2;
@@ -140,10 +140,10 @@ void batch_renderer::add_quadrilateral(const batch_renderer::quadrilateral& qua,
         __BATCH_RENDERER_BATCH_OVERFLOW
     }
 
-    vertexData_[currentVertex_] =       invertex{ qua.vertices[0].pos, vec2(0.0f, 0.0f), textureIndex};
-    vertexData_[currentVertex_ + 1] =   invertex{ qua.vertices[1].pos, vec2(1.0f, 0.0f), textureIndex};
-    vertexData_[currentVertex_ + 2] =   invertex{ qua.vertices[2].pos, vec2(0.0f, 1.0f), textureIndex};
-    vertexData_[currentVertex_ + 3] =   invertex{ qua.vertices[3].pos, vec2(1.0f, 1.0f), textureIndex};
+    vertexData_[currentVertex_] =       invertex{ qua.vertices[0].pos, u8vec2(0, 0), textureIndex};
+    vertexData_[currentVertex_ + 1] =   invertex{ qua.vertices[1].pos, u8vec2(255, 0), textureIndex};
+    vertexData_[currentVertex_ + 2] =   invertex{ qua.vertices[2].pos, u8vec2(0, 255), textureIndex};
+    vertexData_[currentVertex_ + 3] =   invertex{ qua.vertices[3].pos, u8vec2(255, 255), textureIndex};
     indexData_[currentIndex_] =         currentVertex_;
     indexData_[currentIndex_ + 1] =     currentVertex_ + 1;
     indexData_[currentIndex_ + 2] =     currentVertex_ + 2;
@@ -200,9 +200,7 @@ void batch_renderer::add_rectangle(const batch_renderer::rectangle& rect, const
 void batch_renderer::prepare_execute() {
     vertexBuffer_->update_data();
     indexBuffer_->update_data();
-    for (uint32_t i = 0; i < textures_.size(); ++i) {
-        batchShader_->bind_texture(1, i, textures_[i]);
-    }
+    batchShader_->bind_textures(1, 0, textures_.data(), textures_.size());
     cameraUniformBuffer_->position = -cameraData_.position;
     cameraUniformBuffer_->scale = cameraData_.scale;
 }
@@ -211,7 +209,7 @@ void batch_renderer::record_draw() {
     indexBuffer_->bind();
     batchShader_->set();
     wienderer_->begin_render();
-    wienderer_->draw_indexed(maxIndices_, 0, 1);
+    wienderer_->draw_indexed(maxIndices_, 0, 1, 0);
     wienderer_->end_render();
 }
 void batch_renderer::clean_batch() {
@@ -0,0 +1,86 @@
+// context_check: two headless renderers on one context. The second one only creates its own images and command
+// buffers, so it has to be ready much faster than the first one, which creates the instance and the device.
+// Both render and read back their frames, then a renderer destroyed in the middle of recording must not keep
+// the context busy for the others.
+// Expects fullscreen_vert.spirv and solid_frag.spirv in the working directory.
+
+#include "headless_check.hpp"
+#include <chrono>
+#include <iostream>
+#include <memory>
+
+using namespace wiender;
+using namespace headless_check;
+using stage = shader::stage;
+
+namespace {
+    constexpr uint32_t extent = 64;
+
+    double elapsed_ms(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::unique_ptr<shader> create_solid_shader(wienderer* wrer) {
+        shader::create_info createInfo({
+            stage(stage::kind::VERTEX, read_spirv("fullscreen_vert.spirv")),
+            stage(stage::kind::FRAGMENT, read_spirv("solid_frag.spirv"))
+        });
+        createInfo.cullMode = shader::cull_mode::NONE;
+        createInfo.clearScreen = true;
+        return wrer->create_shader(createInfo);
+    }
+    void record_solid(wienderer* wrer, shader* shad, const float (&color)[4]) {
+        wrer->clear_commands_frame();
+        shad->set();
+        wrer->begin_record();
+        wrer->begin_render();
+        wrer->push_constants(shad, 0, color, sizeof(color));
+        wrer->draw_verteces(3, 0, 1);
+        wrer->end_render();
+        wrer->end_record();
+    }
+    void expect_frame_color(wienderer* wrer, const unsigned char (&expected)[4], const char* name) {
+        wrer->execute();
+        const auto ticket = wrer->request_readback(nullptr, readback_region(extent / 2, extent / 2, 1, 1));
+        ticket->wait();
+        const unsigned char* texel = static_cast<const unsigned char*>(ticket->get_data());
+        for (int i = 0; i < 4; ++i)
+            expect(texel[i] == expected[i], std::string("frame color of the ") + name + " renderer, channel " + std::to_string(i) + " is " + std::to_string(texel[i]));
+    }
+} // namespace
+
+int main() {
+    try {
+        std::shared_ptr<context> ctx = create_context(backend_type::VULKAN);
+
+        auto start = std::chrono::steady_clock::now();
+        auto first = ctx->create_headless_renderer(extent, extent);
+        const double firstMs = elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        auto second = ctx->create_headless_renderer(extent, extent);
+        const double secondMs = elapsed_ms(start);
+        std::cout << "context_check: first renderer " << firstMs << " ms, second renderer " << secondMs << " ms\n";
+        expect(secondMs < firstMs, "the second renderer reuses the device of the context");
+
+        auto firstShader = create_solid_shader(first.get());
+        auto secondShader = create_solid_shader(second.get()); // pipeline comes from the shared cache
+        record_solid(first.get(), firstShader.get(), { 1.0f, 0.0f, 0.0f, 1.0f });
+        record_solid(second.get(), secondShader.get(), { 0.0f, 0.0f, 1.0f, 1.0f });
+        expect_frame_color(first.get(), { 255, 0, 0, 255 }, "first");
+        expect_frame_color(second.get(), { 0, 0, 255, 255 }, "second");
+
+        {
+            auto abandoned = ctx->create_headless_renderer(extent, extent);
+            abandoned->begin_record(); // destroyed while the context routes shared binds into it
+        }
+        record_solid(first.get(), firstShader.get(), { 0.0f, 1.0f, 0.0f, 1.0f });
+        expect_frame_color(first.get(), { 0, 255, 0, 255 }, "first");
+
+        first->wait_executing();
+        second->wait_executing();
+        std::cout << "context_check: passed\n";
+    } catch (const std::exception& e) {
+        std::cerr << "context_check: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
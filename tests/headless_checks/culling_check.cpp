@@ -0,0 +1,111 @@
+// culling_check: culls a row of spheres against a moving view rectangle on the GPU and reads back the survivors.
+// Every frame draws the survivors indirectly, so the next frame rewrites the draw buffer and resets the counter
+// while the previous one may still read them.
+// Expects culling_comp.spirv, fullscreen_vert.spirv and solid_frag.spirv in the working directory.
+
+#include "headless_check.hpp"
+#include <wiender_culling.hpp>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+using namespace wiender;
+using namespace headless_check;
+using stage = shader::stage;
+
+namespace {
+    constexpr uint32_t objectCount = 256;
+    constexpr uint32_t visibleCount = 16;   // spheres the view rectangle covers
+    constexpr uint32_t frameCount = 12;
+
+    struct frame_readback {
+        uint32_t first;     // first visible object
+        std::unique_ptr<readback_ticket> draws;
+        std::unique_ptr<readback_ticket> count;
+    };
+
+    // objects are spheres of radius 0.25 at (i, 0), so [first, first + 15.5] covers exactly objects first..first + 15
+    culling_pass::frustum view_of(uint32_t first) {
+        return culling_pass::frustum::from_view_rect(static_cast<float>(first), -1.0f, static_cast<float>(first) + visibleCount - 0.5f, 1.0f);
+    }
+    void check_frame(const frame_readback& frame, bool compact) {
+        frame.draws->wait();
+        const draw_indirect_command* draws = static_cast<const draw_indirect_command*>(frame.draws->get_data());
+        if (compact) {
+            frame.count->wait();
+            const uint32_t count = *static_cast<const uint32_t*>(frame.count->get_data());
+            expect(count == visibleCount, "survivor count of the frame at " + std::to_string(frame.first) + " is " + std::to_string(count));
+
+            bool seen[visibleCount] = {};
+            for (uint32_t i = 0; i < count; ++i) { // order of compacted draws is up to the GPU
+                const uint32_t object = draws[i].firstInstance;
+                expect((object >= frame.first) && (object < frame.first + visibleCount) && !seen[object - frame.first], "unexpected survivor " + std::to_string(object));
+                seen[object - frame.first] = true;
+            }
+        } else {
+            for (uint32_t i = 0; i < objectCount; ++i) {
+                const bool visible = (i >= frame.first) && (i < frame.first + visibleCount);
+                expect((draws[i].instanceCount != 0) == visible, "visibility of object " + std::to_string(i) + " in the frame at " + std::to_string(frame.first));
+            }
+        }
+    }
+} // namespace
+
+int main() {
+    try {
+        auto wrer = create_headless_wienderer(backend_type::VULKAN, 64, 64);
+        const bool compact = wrer->is_feature_supported(wienderer::feature::INDIRECT_DRAW_COUNT);
+
+        culling_pass cull(wrer.get(), stage(stage::kind::COMPUTE, read_spirv("culling_comp.spirv")), objectCount, false);
+        culling_pass::object* objects = static_cast<culling_pass::object*>(cull.get_objects_buffer()->map());
+        for (uint32_t i = 0; i < objectCount; ++i) {
+            std::memset(&objects[i], 0, sizeof(culling_pass::object));
+            objects[i].center[0] = static_cast<float>(i);
+            objects[i].radius = 0.25f;
+            objects[i].draw.indexCount = 3;
+            objects[i].draw.instanceCount = 1;
+            objects[i].draw.firstInstance = i; // identifies survivors in the draw buffer
+        }
+        cull.get_objects_buffer()->unmap();
+        cull.get_objects_buffer()->update_data();
+        cull.set_object_count(objectCount);
+
+        shader::create_info createInfo({
+            stage(stage::kind::VERTEX, read_spirv("fullscreen_vert.spirv")),
+            stage(stage::kind::FRAGMENT, read_spirv("solid_frag.spirv"))
+        });
+        createInfo.cullMode = shader::cull_mode::NONE;
+        createInfo.clearScreen = true;
+        auto drawShader = wrer->create_shader(createInfo);
+
+        const float color[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+        wrer->begin_record();
+        cull.record_cull();
+        drawShader->set();
+        wrer->begin_render();
+        wrer->push_constants(drawShader.get(), 0, color, sizeof(color));
+        cull.record_draw();
+        wrer->end_render();
+        wrer->end_record();
+
+        std::vector<frame_readback> frames;
+        for (uint32_t f = 0; f < frameCount; ++f) {
+            const uint32_t first = f * 7;
+            cull.set_frustum(view_of(first));
+            wrer->execute();
+            // copies run behind the frame, so they see its results while the next frames are already submitted
+            frames.push_back(frame_readback{ first, wrer->request_readback(cull.get_draws_buffer(), 0, objectCount * sizeof(draw_indirect_command)), nullptr });
+            if (compact)
+                frames.back().count = wrer->request_readback(cull.get_count_buffer(), 0, sizeof(uint32_t));
+        }
+        for (const frame_readback& frame : frames)
+            check_frame(frame, compact);
+        wrer->wait_executing();
+
+        std::cout << "culling_check: " << frameCount << " frames, " << (compact ? "compacted" : "zero-instance") << " draws passed\n";
+    } catch (const std::exception& e) {
+        std::cerr << "culling_check: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
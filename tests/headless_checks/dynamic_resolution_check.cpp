@@ -0,0 +1,101 @@
+// dynamic_resolution_check: scale quantization, upscaling of a part of the target into the whole window,
+// and the controller lowering the scale when frames are over a budget no GPU can meet.
+// Texels outside of the render extent keep an older color, so sampling them shows up in the window.
+// Expects upscale_vert.spirv, upscale_frag.spirv, fullscreen_vert.spirv and solid_frag.spirv in the working directory.
+
+#include "headless_check.hpp"
+#include <wiender_dynamic_resolution.hpp>
+#include <iostream>
+#include <memory>
+
+using namespace wiender;
+using namespace headless_check;
+using stage = shader::stage;
+
+namespace {
+    constexpr uint32_t extent = 64;
+    constexpr uint32_t maxFrames = 128;
+
+    void record_frame(wienderer* wrer, dynamic_resolution& dynres, shader* sceneShader, const float (&color)[4]) {
+        wrer->clear_commands_frame();
+        sceneShader->set();
+        wrer->begin_record();
+        wrer->begin_render(dynres.get_target());
+        wrer->push_constants(sceneShader, 0, color, sizeof(color));
+        wrer->draw_verteces(3, 0, 1);
+        wrer->end_render();
+        dynres.record_upscale();
+        wrer->end_record();
+    }
+    void expect_window_color(wienderer* wrer, uint32_t x, uint32_t y, const unsigned char (&expected)[4]) {
+        const auto ticket = wrer->request_readback(nullptr, readback_region(x, y, 1, 1));
+        ticket->wait();
+        const unsigned char* texel = static_cast<const unsigned char*>(ticket->get_data());
+        for (int i = 0; i < 4; ++i)
+            expect(texel[i] == expected[i], "window pixel (" + std::to_string(x) + ", " + std::to_string(y) + ") channel " + std::to_string(i) + " is " + std::to_string(texel[i]));
+    }
+} // namespace
+
+int main() {
+    try {
+        auto wrer = create_headless_wienderer(backend_type::VULKAN, extent, extent);
+
+        dynamic_resolution::settings settings;
+        settings.minScale = 0.5f;
+        settings.scaleStep = 0.25f;
+        settings.frameTimeBudget = 1e-6;
+        dynamic_resolution dynres(wrer.get(),
+            stage(stage::kind::VERTEX, read_spirv("upscale_vert.spirv")),
+            stage(stage::kind::FRAGMENT, read_spirv("upscale_frag.spirv")),
+            texture::extent(extent, extent), render_target::format::RGBA8_UNORM, settings);
+        expect(dynres.get_scale() == 1.0f, "starts at the maximum scale");
+
+        dynres.set_scale(0.8f);
+        expect(dynres.get_scale() == 0.75f, "scale is quantized down to the step");
+        expect(dynres.get_target()->get_render_extent().width == 48, "render extent follows the scale");
+        dynres.set_scale(0.1f);
+        expect(dynres.get_scale() == 0.5f, "scale is clamped to the minimum");
+        dynres.set_scale(2.0f);
+        expect(dynres.get_scale() == 1.0f, "scale is clamped to the maximum");
+
+        shader::create_info createInfo({
+            stage(stage::kind::VERTEX, read_spirv("fullscreen_vert.spirv")),
+            stage(stage::kind::FRAGMENT, read_spirv("solid_frag.spirv"))
+        });
+        createInfo.cullMode = shader::cull_mode::NONE;
+        createInfo.clearScreen = true;
+        createInfo.target = dynres.get_target()->get_description();
+        auto sceneShader = wrer->create_shader(createInfo);
+
+        // the whole target turns red, then only its top-left quarter turns blue
+        record_frame(wrer.get(), dynres, sceneShader.get(), { 1.0f, 0.0f, 0.0f, 1.0f });
+        wrer->execute();
+        dynres.set_scale(0.5f);
+        record_frame(wrer.get(), dynres, sceneShader.get(), { 0.0f, 0.0f, 1.0f, 1.0f });
+        wrer->execute();
+        expect_window_color(wrer.get(), 4, 4, { 0, 0, 255, 255 });
+        expect_window_color(wrer.get(), extent - 4, extent - 4, { 0, 0, 255, 255 });
+
+        if (wrer->is_feature_supported(wienderer::feature::GPU_TIMESTAMPS)) {
+            dynres.set_scale(1.0f);
+            record_frame(wrer.get(), dynres, sceneShader.get(), { 0.0f, 0.0f, 1.0f, 1.0f });
+            uint32_t frame = 0;
+            for (; (frame < maxFrames) && (dynres.get_scale() > settings.minScale); ++frame) {
+                wrer->execute();
+                if (dynres.update())
+                    record_frame(wrer.get(), dynres, sceneShader.get(), { 0.0f, 0.0f, 1.0f, 1.0f });
+            }
+            expect(wrer->get_gpu_frame_time() > 0.0, "finished frames are measured");
+            expect(dynres.get_scale() == settings.minScale, "scale drops to the minimum over the budget, it is " + std::to_string(dynres.get_scale()));
+            std::cout << "dynamic_resolution_check: minimum scale after " << frame << " frames, last frame " << wrer->get_gpu_frame_time() << " ms\n";
+        } else {
+            std::cout << "dynamic_resolution_check: no GPU timestamps, the controller isn't checked\n";
+        }
+        wrer->wait_executing();
+        std::cout << "dynamic_resolution_check: passed\n";
+    } catch (const std::exception& e) {
+        std::cerr << "dynamic_resolution_check: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,8 @@
+#version 450
+
+// fullscreen triangle, see headless checks
+
+void main() {
+    const vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.5, 1.0);
+}
@@ -0,0 +1,34 @@
+#ifndef HEADLESS_CHECK_HPP_
+#define HEADLESS_CHECK_HPP_ 1
+
+// Shared helpers of the headless checks. Every check renders on a headless wienderer,
+// reads results back and returns non-zero when they are wrong, so it runs under ctest without a display.
+
+#include <wiender.hpp>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace headless_check {
+    inline std::vector<uint32_t> read_spirv(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            throw std::runtime_error("unable to open " + path);
+
+        const std::streamsize size = file.tellg();
+        if (size <= 0 || size % 4 != 0)
+            throw std::runtime_error(path + " is not a SPIR-V binary");
+
+        std::vector<uint32_t> code(static_cast<size_t>(size) / 4);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(code.data()), size);
+        return code;
+    }
+    inline void expect(bool condition, const std::string& what) {
+        if (!condition)
+            throw std::runtime_error("check failed: " + what);
+    }
+} // namespace headless_check
+
+#endif // HEADLESS_CHECK_HPP_
@@ -0,0 +1,11 @@
+#version 450
+
+// inverts the color of the previous post-process chain subpass, see headless checks
+
+layout(input_attachment_index = 0, set = 3, binding = 0) uniform subpassInput previous;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    fragColor = vec4(1.0 - subpassLoad(previous).rgb, 1.0);
+}
@@ -0,0 +1,74 @@
+// postprocess_chain_check: a chain of the scene subpass and one post subpass inverting it into the window.
+// A frame without scene draws shows the cleared intermediate, inverted to white, then a drawn scene is inverted.
+// Expects fullscreen_vert.spirv, solid_frag.spirv and invert_frag.spirv in the working directory.
+
+#include "headless_check.hpp"
+#include <iostream>
+#include <memory>
+
+using namespace wiender;
+using namespace headless_check;
+using stage = shader::stage;
+
+namespace {
+    constexpr uint32_t extent = 64;
+
+    std::unique_ptr<shader> create_chain_shader(wienderer* wrer, const postprocess_chain* chain, uint32_t subpass, const char* fragmentPath) {
+        shader::create_info createInfo({
+            stage(stage::kind::VERTEX, read_spirv("fullscreen_vert.spirv")),
+            stage(stage::kind::FRAGMENT, read_spirv(fragmentPath))
+        });
+        createInfo.cullMode = shader::cull_mode::NONE;
+        createInfo.chain = chain;
+        createInfo.subpass = subpass;
+        return wrer->create_shader(createInfo);
+    }
+    // scene color nullptr leaves the scene subpass empty
+    void record_chain(wienderer* wrer, postprocess_chain* chain, shader* sceneShader, shader* invertShader, const float* sceneColor) {
+        wrer->clear_commands_frame();
+        sceneShader->set();
+        wrer->begin_record();
+        wrer->begin_render_chain(chain);
+        if (sceneColor != nullptr) {
+            wrer->push_constants(sceneShader, 0, sceneColor, 4 * sizeof(float));
+            wrer->draw_verteces(3, 0, 1);
+        }
+        wrer->next_subpass();
+        invertShader->set();
+        wrer->draw_verteces(3, 0, 1);
+        wrer->end_render();
+        wrer->end_record();
+    }
+    void expect_frame_color(wienderer* wrer, const unsigned char (&expected)[4], const std::string& what) {
+        wrer->execute();
+        const auto ticket = wrer->request_readback(nullptr, readback_region());
+        ticket->wait();
+        const unsigned char* texels = static_cast<const unsigned char*>(ticket->get_data());
+        for (uint32_t i = 0; i < extent * extent; ++i)
+            for (uint32_t c = 0; c < 4; ++c)
+                expect(texels[4 * i + c] == expected[c], what + ", pixel " + std::to_string(i) + " channel " + std::to_string(c) + " is " + std::to_string(texels[4 * i + c]));
+    }
+} // namespace
+
+int main() {
+    try {
+        auto wrer = create_headless_wienderer(backend_type::VULKAN, extent, extent);
+        auto chain = wrer->create_postprocess_chain(postprocess_chain::description(render_target::format::RGBA8_UNORM, 1));
+        auto sceneShader = create_chain_shader(wrer.get(), chain.get(), 0, "solid_frag.spirv");
+        auto invertShader = create_chain_shader(wrer.get(), chain.get(), 1, "invert_frag.spirv");
+
+        record_chain(wrer.get(), chain.get(), sceneShader.get(), invertShader.get(), nullptr);
+        expect_frame_color(wrer.get(), { 255, 255, 255, 255 }, "scene is cleared to black");
+
+        const float green[4] = { 0.0f, 1.0f, 0.0f, 1.0f };
+        record_chain(wrer.get(), chain.get(), sceneShader.get(), invertShader.get(), green);
+        expect_frame_color(wrer.get(), { 255, 0, 255, 255 }, "drawn scene is inverted");
+
+        wrer->wait_executing();
+        std::cout << "postprocess_chain_check: passed\n";
+    } catch (const std::exception& e) {
+        std::cerr << "postprocess_chain_check: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
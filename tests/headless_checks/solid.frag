@@ -0,0 +1,13 @@
+#version 450
+
+// pushed solid color, see headless checks
+
+layout(push_constant) uniform solid_constants {
+    vec4 color;
+} solid;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    fragColor = solid.color;
+}
@@ -0,0 +1,16 @@
+#version 450
+
+// deliberately expensive fragments, so rejected ones are visible in frame time
+
+layout(constant_id = 0) const int shadingIterations = 64;
+
+layout(location = 0) in float fragShade;
+
+layout(location = 0) out vec4 fragColor;
+
+void main() {
+    vec2 p = gl_FragCoord.xy * 0.01 + fragShade;
+    for (int i = 0; i < shadingIterations; ++i)
+        p = vec2(sin(p.y * 1.3 + p.x), cos(p.x * 0.7 - p.y));
+    fragColor = vec4(0.5 + 0.5 * p, fragShade, 1.0);
+}
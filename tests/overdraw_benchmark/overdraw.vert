@@ -0,0 +1,16 @@
+#version 450
+
+// fullscreen triangle at a pushed depth, see overdraw_benchmark.cpp
+
+layout(push_constant) uniform layer_constants {
+    float depth;
+    float shade;
+} layer;
+
+layout(location = 0) out float fragShade;
+
+void main() {
+    const vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, layer.depth, 1.0);
+    fragShade = layer.shade;
+}
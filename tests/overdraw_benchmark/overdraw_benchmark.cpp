@@ -0,0 +1,112 @@
+// overdraw_benchmark: frame time of stacked opaque fullscreen layers without depth, with depth drawn
+// back to front and with depth drawn front to back. Only the nearest layer should be shaded in the last case.
+// usage: overdraw_benchmark [layers] [frames] [shading iterations]
+// Expects overdraw_vert.spirv and overdraw_frag.spirv in the working directory.
+// Renders headless, so it runs without a display (e.g. on lavapipe in CI).
+
+#include <wiender.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace wiender;
+using stage = shader::stage;
+
+namespace {
+    struct layer_constants {
+        float depth;
+        float shade;
+    };
+    enum struct order {
+        BACK_TO_FRONT,
+        FRONT_TO_BACK,
+    };
+
+    std::vector<uint32_t> read_spirv(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+            throw std::runtime_error("unable to open " + path);
+
+        const std::streamsize size = file.tellg();
+        if (size <= 0 || size % 4 != 0)
+            throw std::runtime_error(path + " is not a SPIR-V binary");
+
+        std::vector<uint32_t> code(static_cast<size_t>(size) / 4);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(code.data()), size);
+        return code;
+    }
+
+    double run(wienderer* wrer, shader* shad, uint32_t layers, uint32_t frames, order drawOrder) {
+        wrer->clear_commands_frame();
+        shad->set();
+        wrer->begin_record();
+        wrer->begin_render();
+        for (uint32_t i = 0; i < layers; ++i) {
+            const uint32_t layer = (drawOrder == order::FRONT_TO_BACK) ? i : layers - 1 - i;
+            const layer_constants constants{ (static_cast<float>(layer) + 0.5f) / static_cast<float>(layers), static_cast<float>(layer) / static_cast<float>(layers) };
+            wrer->push_constants(shad, 0, &constants, sizeof(constants));
+            wrer->draw_verteces(3, 0, 1);
+        }
+        wrer->end_render();
+        wrer->end_record();
+
+        for (uint32_t i = 0; i < 3; ++i) // warm up
+            wrer->execute();
+        wrer->wait_executing();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < frames; ++i)
+            wrer->execute();
+        wrer->wait_executing();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / frames;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const uint32_t layers = (argc > 1) ? static_cast<uint32_t>(std::atoi(argv[1])) : 16;
+    const uint32_t frames = (argc > 2) ? static_cast<uint32_t>(std::atoi(argv[2])) : 200;
+    const int32_t shadingIterations = (argc > 3) ? std::atoi(argv[3]) : 64;
+    if (layers == 0 || frames == 0) {
+        std::cerr << "usage: overdraw_benchmark [layers] [frames] [shading iterations]\n";
+        return 1;
+    }
+
+    try {
+        auto wrer = create_headless_wienderer(backend_type::VULKAN, 1280, 720);
+
+        const std::vector<uint32_t> vertexCode = read_spirv("overdraw_vert.spirv");
+        const std::vector<uint32_t> fragmentCode = read_spirv("overdraw_frag.spirv");
+        const auto create_layer_shader = [&](shader::depth_mode depthMode) {
+            shader::create_info createInfo({
+                stage(stage::kind::VERTEX, vertexCode),
+                stage(stage::kind::FRAGMENT, fragmentCode, { stage::specialization_constant(0, shadingIterations) })
+            });
+            createInfo.cullMode = shader::cull_mode::NONE;
+            createInfo.clearScreen = true;
+            createInfo.depthMode = depthMode;
+            createInfo.clearDepth = (depthMode != shader::depth_mode::DISABLED);
+            return wrer->create_shader(createInfo);
+        };
+        auto noDepthShader = create_layer_shader(shader::depth_mode::DISABLED);
+        auto depthShader = create_layer_shader(shader::depth_mode::TEST_AND_WRITE);
+
+        const double noDepth = run(wrer.get(), noDepthShader.get(), layers, frames, order::BACK_TO_FRONT);
+        const double backToFront = run(wrer.get(), depthShader.get(), layers, frames, order::BACK_TO_FRONT);
+        const double frontToBack = run(wrer.get(), depthShader.get(), layers, frames, order::FRONT_TO_BACK);
+
+        std::cout << layers << " layers, " << frames << " frames, " << shadingIterations << " shading iterations\n";
+        std::cout << "no depth:              " << noDepth << " ms/frame, " << 1000.0 / noDepth << " fps\n";
+        std::cout << "depth, back to front:  " << backToFront << " ms/frame, " << 1000.0 / backToFront << " fps\n";
+        std::cout << "depth, front to back:  " << frontToBack << " ms/frame, " << 1000.0 / frontToBack << " fps (" << noDepth / frontToBack << "x)\n";
+    } catch (const std::exception& e) {
+        std::cerr << "overdraw_benchmark: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+// render_queue_test: sort key packing and recorded draw order of render_queue, CPU only.
+// Draws are recorded into a fake wienderer, every draw is identified by its first vertex.
+
+#include <wiender_render_queue.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace wiender;
+
+namespace {
+    struct recorded_draw {
+        const shader* shad;
+        uint32_t first;
+    };
+
+    [[noreturn]] void unexpected() {
+        throw std::logic_error("render_queue called an unexpected wienderer method");
+    }
+
+    struct fake_wienderer : public wienderer {
+        public:
+        const shader* currentShader = nullptr;
+        std::vector<recorded_draw> draws;
+
+        public:
+        std::unique_ptr<buffer> create_buffer(buffer::type, std::size_t) override { unexpected(); }
+        std::unique_ptr<shader> create_shader(const shader::create_info&) override { unexpected(); }
+        std::unique_ptr<texture> create_texture(const texture::create_info&) override { unexpected(); }
+        std::unique_ptr<material> create_material(const shader*) override { unexpected(); }
+        std::unique_ptr<render_target> create_render_target(const texture::extent&, render_target::format, uint32_t) override { unexpected(); }
+        std::unique_ptr<render_target> get_postproc_texture() override { unexpected(); }
+        std::unique_ptr<postprocess_chain> create_postprocess_chain(const postprocess_chain::description&) override { unexpected(); }
+        std::unique_ptr<wiender_commands_frame> get_commands_frame() const override { unexpected(); }
+        void clear_commands_frame() override { unexpected(); }
+        void set_commands_frame(const wiender_commands_frame*) override { unexpected(); }
+        void concat_commands_frame(const wiender_commands_frame*) override { unexpected(); }
+        void begin_record() override { unexpected(); }
+        void begin_render() override { unexpected(); }
+        void begin_render(render_target*) override { unexpected(); }
+        void begin_render_chain(postprocess_chain*) override { unexpected(); }
+        void next_subpass() override { unexpected(); }
+        void draw_verteces(uint32_t, uint32_t firstVertex, uint32_t) override {
+            draws.push_back(recorded_draw{ currentShader, firstVertex });
+        }
+        void draw_indexed(uint32_t, uint32_t, uint32_t, int32_t) override { unexpected(); }
+        void bind_instance_buffer(const buffer*, uint32_t, std::size_t) override { unexpected(); }
+        void draw_indirect(const buffer*, std::size_t, uint32_t, uint32_t) override { unexpected(); }
+        void draw_indexed_indirect(const buffer*, std::size_t, uint32_t, uint32_t) override { unexpected(); }
+        void draw_indirect_count(const buffer*, std::size_t, const buffer*, std::size_t, uint32_t, uint32_t) override { unexpected(); }
+        void draw_indexed_indirect_count(const buffer*, std::size_t, const buffer*, std::size_t, uint32_t, uint32_t) override { unexpected(); }
+        void dispatch(uint32_t, uint32_t, uint32_t) override { unexpected(); }
+        void fill_buffer(const buffer*, std::size_t, std::size_t, uint32_t) override { unexpected(); }
+        void push_constants(const shader*, uint32_t, const void*, std::size_t) override { unexpected(); }
+        void end_render() override { unexpected(); }
+        void end_record() override { unexpected(); }
+        void execute() override { unexpected(); }
+        void wait_executing() override { unexpected(); }
+        std::unique_ptr<readback_ticket> request_readback(const texture*, const readback_region&) override { unexpected(); }
+        std::unique_ptr<readback_ticket> request_readback(const buffer*, std::size_t, std::size_t) override { unexpected(); }
+        std::vector<char> get_cache_data() const override { unexpected(); }
+        void load_cache_data(const void*, std::size_t) override { unexpected(); }
+        bool is_feature_supported(feature) const noexcept override { return false; }
+        bind_statistics get_bind_statistics() const noexcept override { return bind_statistics{}; }
+        double get_gpu_frame_time() const noexcept override { return 0.0; }
+    };
+    struct fake_shader : public shader {
+        public:
+        fake_wienderer* owner;
+
+        public:
+        explicit fake_shader(fake_wienderer* owner) : owner(owner) {}
+
+        public:
+        void set() override { owner->currentShader = this; }
+        uniform_buffer_info get_uniform_buffer_info(std::size_t, std::size_t) override { unexpected(); }
+        void bind_texture(std::size_t, std::size_t, std::size_t, const texture*) override { unexpected(); }
+        void bind_textures(std::size_t, std::size_t, std::size_t, const texture* const*, std::size_t) override { unexpected(); }
+        void bind_buffer(std::size_t, std::size_t, const buffer*, std::size_t, std::size_t) override { unexpected(); }
+    };
+
+    void expect(bool condition, const std::string& what) {
+        if (!condition)
+            throw std::runtime_error("check failed: " + what);
+    }
+    void expect_order(const fake_wienderer& wrer, const std::vector<uint32_t>& expected, const std::string& what) {
+        std::string recorded;
+        for (const recorded_draw& draw : wrer.draws)
+            recorded += std::to_string(draw.first) + " ";
+        expect(wrer.draws.size() == expected.size(), what + ", recorded " + recorded);
+        for (std::size_t i = 0; i < expected.size(); ++i)
+            expect(wrer.draws[i].first == expected[i], what + ", recorded " + recorded);
+    }
+    render_queue::draw_packet packet(shader* shad, uint32_t id) {
+        return render_queue::draw_packet(shad, nullptr, nullptr, nullptr, 3, id);
+    }
+
+    void test_key_layout() {
+        using sort_key = render_queue::sort_key;
+        expect(sort_key::opaque(1, 0, 0, 0.0f) == (1ull << 56), "layer occupies the top 8 bits");
+        expect(sort_key::translucent(0, 0, 0, 1.0f) == (1ull << 55), "translucent flag is below the layer, nearest translucent depth is 0");
+        expect(sort_key::opaque(0, 1, 0, 0.0f) == (1ull << 40), "opaque pipeline is above material and depth");
+        expect(sort_key::opaque(0, 0, 1, 0.0f) == (1ull << 24), "opaque material is above depth");
+        expect(sort_key::opaque(0, 0, 0, 1.0f) == (1ull << 24) - 1, "opaque depth takes the low 24 bits");
+        expect(sort_key::opaque(0, 1u << 15, 1u << 16, 0.0f) == 0, "pipeline and material ids wrap at their widths");
+        expect(sort_key::opaque(0, 0, 0, -1.0f) == 0 && sort_key::opaque(0, 0, 0, 2.0f) == (1ull << 24) - 1, "depth is clamped");
+        expect(sort_key::translucent(0, 1, 0, 1.0f) == ((1ull << 55) | (1ull << 16)), "translucent pipeline is below depth");
+        expect(sort_key::opaque(0, 0x7fff, 0xffff, 1.0f) < sort_key::translucent(0, 0, 0, 1.0f), "any opaque key of a layer is less than translucent ones");
+        expect(sort_key::translucent(0, 0, 0, 0.0f) < sort_key::opaque(1, 0, 0, 0.0f), "any key of a layer is less than keys of the next one");
+    }
+    void test_opaque_before_translucent() {
+        fake_wienderer wrer;
+        fake_shader a(&wrer);
+        render_queue queue(&wrer);
+        queue.submit(1, false, 0.5f, packet(&a, 0));    // next layer goes last even when opaque
+        queue.submit(0, true, 0.5f, packet(&a, 1));
+        queue.submit(0, false, 0.9f, packet(&a, 2));
+        queue.submit(0, true, 0.1f, packet(&a, 3));
+        queue.submit(0, false, 0.2f, packet(&a, 4));
+        queue.record();
+        expect_order(wrer, { 4, 2, 1, 3, 0 }, "opaque draws of a layer before translucent ones, layers in order");
+        expect(queue.size() == 0, "record clears the queue");
+    }
+    void test_depth_order() {
+        fake_wienderer wrer;
+        fake_shader a(&wrer);
+        render_queue queue(&wrer);
+        const float depths[] = { 0.4f, 0.05f, 0.95f, 0.6f, 0.3f };
+        for (uint32_t i = 0; i < 5; ++i) {
+            queue.submit(0, false, depths[i], packet(&a, i));
+            queue.submit(0, true, depths[i], packet(&a, 10 + i));
+        }
+        queue.record();
+        expect_order(wrer, { 1, 4, 0, 3, 2, 12, 13, 10, 14, 11 }, "opaque front to back, translucent back to front");
+    }
+    void test_pipeline_buckets() {
+        fake_wienderer wrer;
+        fake_shader a(&wrer);
+        fake_shader b(&wrer);
+        fake_shader c(&wrer);
+        render_queue queue(&wrer);
+        // ids are assigned on first use: a, b, c
+        queue.submit(0, false, 0.5f, packet(&a, 0));
+        queue.submit(0, false, 0.1f, packet(&b, 1));
+        queue.submit(0, false, 0.9f, packet(&c, 2));
+        queue.submit(0, false, 0.3f, packet(&a, 3));
+        queue.submit(0, false, 0.2f, packet(&c, 4));
+        queue.submit(0, false, 0.7f, packet(&b, 5));
+        queue.submit(0, false, 0.5f, packet(&a, 6)); // same key as draw 0, submission order is kept
+        queue.record();
+        expect_order(wrer, { 3, 0, 6, 1, 5, 4, 2 }, "opaque draws grouped by pipeline, front to back inside a group");
+        expect(queue.get_statistics().pipelineChanges == 3, "one pipeline change per shader, got " + std::to_string(queue.get_statistics().pipelineChanges));
+        expect(wrer.draws[0].shad == &a && wrer.draws[3].shad == &b && wrer.draws[5].shad == &c, "draws are recorded with their shaders");
+
+        // translucent draws ignore pipelines for the correct blending order
+        queue.submit(0, true, 0.1f, packet(&a, 7));
+        queue.submit(0, true, 0.9f, packet(&b, 8));
+        queue.submit(0, true, 0.5f, packet(&a, 9));
+        wrer.draws.clear();
+        queue.record();
+        expect_order(wrer, { 8, 9, 7 }, "translucent draws back to front across pipelines");
+        expect(queue.get_statistics().pipelineChanges == 2, "translucent pipeline changes, got " + std::to_string(queue.get_statistics().pipelineChanges));
+    }
+    void test_many_draws() {
+        fake_wienderer wrer;
+        fake_shader a(&wrer);
+        render_queue queue(&wrer);
+        constexpr uint32_t count = 1000;
+        for (uint32_t i = 0; i < count; ++i) // depths in reversed order, every radix digit of the depth differs
+            queue.submit(0, false, static_cast<float>(count - 1 - i) / count, packet(&a, i));
+        queue.record();
+        expect(wrer.draws.size() == count, "every draw is recorded");
+        for (uint32_t i = 0; i < count; ++i)
+            expect(wrer.draws[i].first == count - 1 - i, "front to back order of " + std::to_string(count) + " draws");
+    }
+} // namespace
+
+int main() {
+    try {
+        test_key_layout();
+        test_opaque_before_translucent();
+        test_depth_order();
+        test_pipeline_buckets();
+        test_many_draws();
+    } catch (const std::exception& e) {
+        std::cerr << "render_queue_test: " << e.what() << '\n';
+        return 1;
+    }
+    std::cout << "render_queue_test: passed\n";
+    return 0;
+}
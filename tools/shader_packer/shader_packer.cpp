@@ -0,0 +1,127 @@
+// shader_packer: builds a wiender shader archive (see include/wiender_shader_archive.hpp)
+// usage: shader_packer <output archive> <input.spirv>...
+// Entries are named after input file names without directories.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../include/wiender_shader_archive.hpp"
+#include "../../src/vulkan_implement/spirv_reflection_support.hpp"
+
+namespace {
+    struct input_shader {
+        std::string name;
+        std::vector<uint32_t> code;
+        uint64_t nameHash;
+        uint64_t codeHash;
+    };
+
+    std::vector<uint32_t> read_spirv(const std::string& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            throw std::runtime_error("failed to open " + path);
+
+        const std::streamsize size = file.tellg();
+        if (size <= 0 || size % sizeof(uint32_t) != 0)
+            throw std::runtime_error(path + " is not a SPIR-V binary");
+
+        std::vector<uint32_t> code(static_cast<size_t>(size) / sizeof(uint32_t));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(code.data()), size);
+        return code;
+    }
+    std::string file_name(const std::string& path) {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+    void align(std::vector<char>& out, size_t alignment) {
+        out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+    }
+    template<class T>
+    void write_at(std::vector<char>& out, size_t offset, const T& value) {
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: shader_packer <output archive> <input.spirv>...\n";
+        return 1;
+    }
+
+    try {
+        std::vector<input_shader> shaders;
+        for (int i = 2; i < argc; ++i) {
+            input_shader shader;
+            shader.name = file_name(argv[i]);
+            shader.code = read_spirv(argv[i]);
+            shader.nameHash = wiender::shader_archive::hash_name(shader.name.data(), shader.name.size());
+            shader.codeHash = wiender::spirv_code_hash(shader.code.size() * sizeof(uint32_t), shader.code.data());
+            shaders.push_back(std::move(shader));
+        }
+        std::stable_sort(shaders.begin(), shaders.end(), [](const input_shader& a, const input_shader& b) { return a.nameHash < b.nameHash; });
+        for (size_t i = 1; i < shaders.size(); ++i) {
+            if (shaders[i - 1].name == shaders[i].name)
+                throw std::runtime_error("duplicate shader name " + shaders[i].name);
+        }
+
+        // precomputed reflection, in wienderer::get_cache_data format without pipeline cache data
+        wiender::shader_reflection_cache reflectionCache;
+        for (const auto& shader : shaders)
+            (void)reflectionCache.get(shader.code.size() * sizeof(uint32_t), shader.code.data(), shader.codeHash);
+        std::vector<char> reflectionData;
+        reflectionCache.serialize(reflectionData);
+
+        std::vector<char> out(sizeof(wiender::shader_archive::header) + shaders.size() * sizeof(wiender::shader_archive::entry), 0);
+        std::vector<wiender::shader_archive::entry> entries(shaders.size());
+        for (size_t i = 0; i < shaders.size(); ++i) {
+            entries[i].nameHash = shaders[i].nameHash;
+            entries[i].codeHash = shaders[i].codeHash;
+            entries[i].nameOffset = out.size();
+            entries[i].nameSize = shaders[i].name.size();
+            out.insert(out.end(), shaders[i].name.begin(), shaders[i].name.end());
+        }
+        for (size_t i = 0; i < shaders.size(); ++i) {
+            align(out, 8);
+            entries[i].codeOffset = out.size();
+            entries[i].codeSize = shaders[i].code.size() * sizeof(uint32_t);
+            const char* code = reinterpret_cast<const char*>(shaders[i].code.data());
+            out.insert(out.end(), code, code + entries[i].codeSize);
+        }
+
+        align(out, 8);
+        wiender::cache_data_header cacheHeader{};
+        cacheHeader.magic = wiender::cache_data_header::wienderMagic;
+        cacheHeader.reflectionSize = reflectionData.size();
+        cacheHeader.pipelineCacheSize = 0;
+
+        wiender::shader_archive::header archiveHeader{};
+        archiveHeader.magic = wiender::shader_archive::header::archiveMagic;
+        archiveHeader.version = wiender::shader_archive::header::archiveVersion;
+        archiveHeader.entryCount = static_cast<uint32_t>(shaders.size());
+        archiveHeader.cacheDataOffset = out.size();
+        archiveHeader.cacheDataSize = sizeof(cacheHeader) + reflectionData.size();
+
+        const char* cacheHeaderBytes = reinterpret_cast<const char*>(&cacheHeader);
+        out.insert(out.end(), cacheHeaderBytes, cacheHeaderBytes + sizeof(cacheHeader));
+        out.insert(out.end(), reflectionData.begin(), reflectionData.end());
+
+        write_at(out, 0, archiveHeader);
+        for (size_t i = 0; i < entries.size(); ++i)
+            write_at(out, sizeof(archiveHeader) + i * sizeof(wiender::shader_archive::entry), entries[i]);
+
+        std::ofstream file(argv[1], std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+            throw std::runtime_error(std::string("failed to create ") + argv[1]);
+        file.write(out.data(), static_cast<std::streamsize>(out.size()));
+        if (!file)
+            throw std::runtime_error(std::string("failed to write ") + argv[1]);
+    } catch (const std::exception& e) {
+        std::cerr << "shader_packer: " << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}